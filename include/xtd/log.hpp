@@ -1,321 +1,813 @@
-/** @file
-  runtime logging to various destinations
-  @copyright David Mott (c) 2016. Distributed under the Boost Software License Version 1.0. See LICENSE.md or http://boost.org/LICENSE_1_0.txt for details.
-
-*/
-
-#pragma once
-
-
-#include <xtd/xtd.hpp>
-
-#include <chrono>
-#include <thread>
-#include <condition_variable>
-#include <mutex>
-#include <future>
-#include <deque>
-
-#if (XTD_LOG_TARGET_CSV | XTD_LOG_TARGET_XML)
-#include <fstream>
-#endif
-
-#if XTD_LOG_TARGET_SYSLOG
-  #include <syslog.h>
-#endif
-
-#if XTD_LOG_TARGET_COUT
-#include <iostream>
-#endif
-
-
-#include <xtd/string.hpp>
-#include <xtd/source_location.hpp>
-#include <xtd/filesystem.hpp>
-#include <xtd/process.hpp>
-#include <xtd/executable.hpp>
-#include <xtd/meta.hpp>
-
-#define FATAL(...) xtd::log::get().write(xtd::log::type::fatal, here(), __VA_ARGS__)
-#define ERR(...)  xtd::log::get().write(xtd::log::type::error, here(), __VA_ARGS__)
-#define WARNING(...)  xtd::log::get().write(xtd::log::type::warning, here(), __VA_ARGS__)
-#define INFO(...) xtd::log::get().write(xtd::log::type::info, here(), __VA_ARGS__)
-#define DBG(...)  xtd::log::get().write(xtd::log::type::debug, here(), __VA_ARGS__)
-
-namespace xtd {
-
-  class log {
-  public:
-    enum class type {
-      fatal,
-      error,
-      warning,
-      info,
-      debug,
-      enter,
-      leave,
-    };
-
-    static const char* type_string(type oType) {
-      switch (oType) {
-        case xtd::log::type::fatal:
-          return "fatal";
-        case xtd::log::type::error:
-          return "error";
-        case xtd::log::type::warning:
-          return "warning";
-        case xtd::log::type::debug:
-          return "debug";
-        case xtd::log::type::enter:
-          return "enter";
-        case xtd::log::type::leave:
-          return "leave";
-        default:
-          return "info";
-      }
-    }
-
-
-    class message {
-    public:
-      using pointer_type = std::shared_ptr<message>;
-      using deque_type = std::deque<pointer_type>;
-      using time_type = std::chrono::time_point<std::chrono::system_clock>;
-
-      message(type msg_type, const xtd::source_location& location, xtd::string&& text)
-        : _tid(std::this_thread::get_id()), _type(msg_type), _location(location), _text(std::move(text)), _time(std::chrono::system_clock::now()) {}
-
-      message(const message& src)
-        : _tid(src._tid), _type(src._type), _location(src._location), _text(src._text), _time(src._time) {}
-
-      message& operator=(const message& src) {
-        if (this == &src) {
-          return *this;
-        }
-        _tid = src._tid;
-        _type = src._type;
-        _location = src._location;
-        _text = src._text;
-        _time = src._time;
-        return *this;
-      }
-
-      std::thread::id _tid;
-      type _type;
-      source_location _location;
-      xtd::string _text;
-      time_type _time;
-    };
-
-    class log_target {
-    public:
-      virtual ~log_target() = default;
-      using pointer_type = std::shared_ptr<log_target>;
-      using vector_type = std::vector<pointer_type>;
-      virtual void operator()(const message::pointer_type&) = 0;
-    };
-
-    void Exit() {
-      {
-        std::lock_guard<std::mutex> oLock(_callback_lock);
-        _callbacks.push_back([this]() {
-          _callbackThreadExit = true;
-        });
-        _callbackCheck.notify_one();
-      }
-      if (_callbackThread.joinable()) {
-        _callbackThread.join();
-        _callbackThreadFinished.get_future().get();
-      }
-    }
-
-
-    template <typename _ty>
-    void AddTarget() {
-      std::lock_guard<std::mutex> oLock(_callback_lock);
-      _logTargets.emplace_back(new _ty);
-    }
-
-    void AddTarget(log_target::pointer_type oTarget) {
-      std::lock_guard<std::mutex> oLock(_callback_lock);
-      _logTargets.push_back(oTarget);
-    }
-  private:
-
-#if (XTD_LOG_TARGET_SYSLOG)
-    class syslog_target : public log_target{
-    public:
-
-      syslog_target(){ openlog(nullptr, LOG_PID | LOG_NDELAY, 0); }
-      ~syslog_target() override { closelog(); }
-      void operator()(const message::pointer_type& oMessage) override {
-        int iFacility = LOG_MAKEPRI(LOG_USER, LOG_DEBUG);
-        switch (oMessage->_type){
-          case type::fatal:
-          {
-            iFacility = LOG_MAKEPRI(LOG_USER, LOG_CRIT); 
-            break;
-          }
-          case type::error:
-          {
-            iFacility = LOG_MAKEPRI(LOG_USER, LOG_ERR); 
-            break;
-          }
-          case type::warning:
-          {
-            iFacility = LOG_MAKEPRI(LOG_USER, LOG_WARNING); 
-            break;
-          }
-          case type::info:
-          {
-            iFacility = LOG_MAKEPRI(LOG_USER, LOG_INFO); 
-            break;
-          }
-          case type::debug:
-          case type::enter:
-          case type::leave:
-          {
-            iFacility = LOG_MAKEPRI(LOG_USER, LOG_DEBUG); 
-            break;
-          }
-        }
-        syslog(iFacility, "%s", oMessage->_text.c_str());
-      }
-    };
-#endif
-
-#if (XTD_LOG_TARGET_WINDBG)
-    class win_dbg_target : public log_target {
-    public:
-      ~win_dbg_target() override = default;
-
-      void operator()(const message::pointer_type& oMessage) override {
-        OutputDebugStringA(xtd::string::format(oMessage->_text, "\n").c_str());
-      }
-    };
-#endif
-
-
-#if (XTD_LOG_TARGET_COUT)
-    class std_cout_target : public log_target {
-    public:
-      ~std_cout_target() override = default;
-
-      void operator()(const message::pointer_type& oMessage) override {
-        std::cout << oMessage->_text << std::endl;
-      }
-    };
-#endif
-
-#if (XTD_LOG_TARGET_CSV)
-    class csv_target : public log_target {
-      std::ofstream _logfile;
-      std::mutex _FileLock;
-    public:
-
-
-      void operator()(const message::pointer_type& oMsg) override {
-        static thread_local size_t _StackDepth = 1;
-        if (type::leave == oMsg->_type) --_StackDepth;
-        std::string sMsgPrefix(_StackDepth, ',');
-        std::hash<std::thread::id> oHash;
-        auto sMsg = xtd::string::format(oHash(oMsg->_tid), ",", oMsg->_time.time_since_epoch().count(), ",", type_string(oMsg->_type), ",", oMsg->_location.file(), ",", oMsg->_location.line(), sMsgPrefix, oMsg->_text);
-        if (type::enter == oMsg->_type) ++_StackDepth;
-        std::unique_lock<std::mutex> oLock(_FileLock);
-        _logfile << sMsg << '\n';
-      }
-
-      csv_target() : _logfile(), _FileLock() {
-        auto oLogPath = xtd::filesystem::home_directory_path();
-        oLogPath /= xtd::executable::this_executable().path().filename();
-        if (!xtd::filesystem::exists(oLogPath)) xtd::filesystem::create_directories(oLogPath);
-        oLogPath /= xtd::tstring::format(intrinsic_cast(xtd::process::this_process().id()), __(".csv"));
-        _logfile.open(oLogPath.tstring(), std::ios::out);
-      }
-    };
-#endif
-
-    void callback_thread() {
-      _callbackThreadStarted.set_value();
-      while (!_callbackThreadExit) {
-        callback_type oCallback; {
-          std::unique_lock<std::mutex> oLock(_callback_lock);
-          _callbackCheck.wait(oLock, [this] {
-                                return _callbacks.size();
-                              });
-          oCallback = _callbacks.front();
-          _callbacks.pop_front();
-          oLock.unlock();
-          _callbackCheck.notify_one();
-        }
-        if (oCallback) {
-          oCallback();
-        }
-      }
-      _callbackThreadFinished.set_value();
-    }
-
-    log() : _messages(), _callbacks(), _callbackThread(), _callback_lock(), _callbackCheck(), _logTargets()
-        ,_callbackThreadStarted(), _callbackThreadFinished()
-    {
-
-#if (XTD_LOG_TARGET_SYSLOG)
-      _logTargets.emplace_back(new syslog_target);
-#endif
-
-#if (XTD_LOG_TARGET_WINDBG)
-      _logTargets.emplace_back(new win_dbg_target);
-#endif
-
-#if (XTD_LOG_TARGET_COUT)
-      _logTargets.emplace_back(new std_cout_target);
-#endif
-
-#if (XTD_LOG_TARGET_CSV)
-      _logTargets.emplace_back(new csv_target);
-#endif
-
-      _callbackThread = std::thread(&log::callback_thread, this);
-      _callbackThreadStarted.get_future().get();
-    }
-
-    ~log() { Exit(); }
-
-    using callback_type = std::function<void()>;
-    using callback_deque = std::deque<callback_type>;
-
-    message::deque_type _messages;
-    callback_deque _callbacks;
-    std::thread _callbackThread;
-    std::mutex _callback_lock;
-    std::condition_variable _callbackCheck;
-    log_target::vector_type _logTargets;
-    std::promise<void> _callbackThreadStarted;
-    std::promise<void> _callbackThreadFinished;
-    bool _callbackThreadExit = false;
-
-  public:
-
-    static log& get() {
-      static log _log;
-      return _log;
-    }
-
-    template <typename ... _arg_ts>
-    inline void write(type mesageType, const source_location& location, _arg_ts&&...oArgs) {
-      auto sMessage = xtd::string::format(std::forward<_arg_ts>(oArgs)...);
-      auto oMessage = std::make_shared<message>(mesageType, location, std::move(sMessage)); {
-        std::lock_guard<std::mutex> oLock(_callback_lock);
-        _callbacks.push_back([oMessage, this]() {
-            for (auto oTarget : _logTargets) {
-              (*oTarget)(oMessage);
-            }
-          });
-      }
-      _callbackCheck.notify_one();
-    }
-
-  };
-
-
-}
+/** @file
+  runtime logging to various destinations
+  @copyright David Mott (c) 2016. Distributed under the Boost Software License Version 1.0. See LICENSE.md or http://boost.org/LICENSE_1_0.txt for details.
+
+*/
+
+#pragma once
+
+
+#include <xtd/xtd.hpp>
+
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <mutex>
+#include <future>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include <array>
+#include <limits>
+#include <fstream>
+
+#if XTD_LOG_TARGET_SYSLOG
+  #include <syslog.h>
+#endif
+
+#if XTD_LOG_TARGET_COUT
+#include <iostream>
+#endif
+
+#if !defined(XTD_LOG_CLOCK_TSC)
+  #if ((XTD_COMPILER_GCC | XTD_COMPILER_CLANG | XTD_COMPILER_MSVC) & XTD_COMPILER) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+    #define XTD_LOG_CLOCK_TSC 1
+  #else
+    #define XTD_LOG_CLOCK_TSC 0
+  #endif
+#endif
+
+#if (XTD_LOG_CLOCK_TSC && (XTD_COMPILER_MSVC & XTD_COMPILER))
+  #include <intrin.h>
+#elif (XTD_LOG_CLOCK_TSC)
+  #include <x86intrin.h>
+  #include <cpuid.h>
+#endif
+
+#include <atomic>
+#include <map>
+#include <ctime>
+
+#if (XTD_OS_UNIX & XTD_OS)
+  #include <time.h>
+  #include <sys/uio.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <cerrno>
+#endif
+
+
+#include <xtd/string.hpp>
+#include <xtd/source_location.hpp>
+#include <xtd/filesystem.hpp>
+#include <xtd/process.hpp>
+#include <xtd/executable.hpp>
+#include <xtd/meta.hpp>
+#include <xtd/callback.hpp>
+
+#define FATAL(...) xtd::log::get().write(xtd::log::type::fatal, here(), __VA_ARGS__)
+#define ERR(...)  xtd::log::get().write(xtd::log::type::error, here(), __VA_ARGS__)
+#define WARNING(...)  xtd::log::get().write(xtd::log::type::warning, here(), __VA_ARGS__)
+#define INFO(...) xtd::log::get().write(xtd::log::type::info, here(), __VA_ARGS__)
+#define DBG(...)  xtd::log::get().write(xtd::log::type::debug, here(), __VA_ARGS__)
+#define TRACE_SCOPE(_name) xtd::log::trace_scope UNIQUE_IDENTIFIER(_trace_scope_)(here(), _name)
+
+namespace xtd {
+
+  class log {
+  public:
+    enum class type {
+      fatal,
+      error,
+      warning,
+      info,
+      debug,
+      enter,
+      leave,
+    };
+
+    static const char* type_string(type oType) {
+      switch (oType) {
+        case xtd::log::type::fatal:
+          return "fatal";
+        case xtd::log::type::error:
+          return "error";
+        case xtd::log::type::warning:
+          return "warning";
+        case xtd::log::type::debug:
+          return "debug";
+        case xtd::log::type::enter:
+          return "enter";
+        case xtd::log::type::leave:
+          return "leave";
+        default:
+          return "info";
+      }
+    }
+
+
+    /** cheap monotonic tick source stamped on every message
+    Reads the TSC when CPUID reports it invariant, otherwise CLOCK_MONOTONIC or steady_clock. The tick rate is calibrated
+    once against steady_clock and ticks are converted to wall clock time only when a target formats the message.
+    */
+    class clock {
+    public:
+      using rep = uint64_t;
+      using time_type = std::chrono::time_point<std::chrono::system_clock>;
+
+      static rep now() {
+#if (XTD_LOG_CLOCK_TSC)
+        if (invariant_tsc()) return __rdtsc();
+#endif
+#if (XTD_OS_UNIX & XTD_OS)
+        timespec oTime;
+        clock_gettime(CLOCK_MONOTONIC, &oTime);
+        return (static_cast<rep>(oTime.tv_sec) * 1000000000) + static_cast<rep>(oTime.tv_nsec);
+#else
+        return static_cast<rep>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+      }
+
+      /// true when the TSC ticks at a constant rate across frequency and power state changes (CPUID 0x80000007 EDX bit 8)
+      static bool invariant_tsc() {
+#if (XTD_LOG_CLOCK_TSC)
+        static const bool _invariant = []() {
+  #if (XTD_COMPILER_MSVC & XTD_COMPILER)
+          int aRegs[4];
+          __cpuid(aRegs, 0x80000000);
+          if (static_cast<unsigned int>(aRegs[0]) < 0x80000007) return false;
+          __cpuid(aRegs, 0x80000007);
+          return 0 != (aRegs[3] & (1 << 8));
+  #else
+          unsigned int iEax, iEbx, iEcx, iEdx;
+          if (!__get_cpuid(0x80000007, &iEax, &iEbx, &iEcx, &iEdx)) return false;
+          return 0 != (iEdx & (1u << 8));
+  #endif
+        }();
+        return _invariant;
+#else
+        return false;
+#endif
+      }
+
+      /// converts ticks from now() to wall clock time relative to a fresh sample so wall clock adjustments are honored
+      static time_type to_system(rep ticks) {
+        auto iNow = now();
+        auto oWall = std::chrono::system_clock::now();
+        auto iElapsed = static_cast<double>(static_cast<int64_t>(iNow - ticks)) / get()._ticks_per_ns;
+        return oWall - std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(static_cast<int64_t>(iElapsed)));
+      }
+
+      /// converts the difference between two tick values to nanoseconds
+      static std::chrono::nanoseconds elapsed(rep begin, rep end) {
+        return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(end - begin)) / get()._ticks_per_ns));
+      }
+
+      /// performs the one time calibration
+      static void calibrate() { get(); }
+
+    private:
+      static clock& get() {
+        static clock _clock;
+        return _clock;
+      }
+
+      clock() : _ticks_per_ns(1.0) {
+        if (!invariant_tsc()) return;
+#if (XTD_LOG_CLOCK_TSC)
+        auto oStart = std::chrono::steady_clock::now();
+        auto iStart = now();
+        std::chrono::steady_clock::time_point oEnd;
+        do {
+          oEnd = std::chrono::steady_clock::now();
+        } while (oEnd - oStart < std::chrono::milliseconds(2));
+        auto iEnd = now();
+        _ticks_per_ns = static_cast<double>(iEnd - iStart) / static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(oEnd - oStart).count());
+#endif
+      }
+
+      double _ticks_per_ns;
+    };
+
+    using thread_id_type = uint32_t;
+
+    /// small dense id of the calling thread, assigned on first use and cached in TLS
+    static thread_id_type thread_id() {
+      static std::atomic<thread_id_type> _next(0);
+      static thread_local thread_id_type _id = ++_next;
+      return _id;
+    }
+
+    /// names the calling thread in formatted output
+    static void thread_name(const xtd::string& sName) {
+      auto & oNames = thread_names();
+      std::lock_guard<std::mutex> oLock(oNames.first);
+      oNames.second[thread_id()] = sName;
+    }
+
+    /// name of a thread given its dense id, the id itself if the thread was not named
+    static xtd::string thread_name(thread_id_type iThread) {
+      auto & oNames = thread_names();
+      std::lock_guard<std::mutex> oLock(oNames.first);
+      auto oName = oNames.second.find(iThread);
+      if (oNames.second.end() == oName) {
+        return xtd::string::format(iThread);
+      }
+      return oName->second;
+    }
+
+    class message {
+    public:
+      using pointer_type = std::shared_ptr<message>;
+      using deque_type = std::deque<pointer_type>;
+      using vector_type = std::vector<pointer_type>;
+      using time_type = clock::time_type;
+
+      message(type msg_type, const xtd::source_location& location, xtd::string&& text)
+        : _tid(log::thread_id()), _type(msg_type), _location(location), _text(std::move(text)), _time(clock::now()) {}
+
+      message(const message& src)
+        : _tid(src._tid), _type(src._type), _location(src._location), _text(src._text), _time(src._time) {}
+
+      message& operator=(const message& src) {
+        if (this == &src) {
+          return *this;
+        }
+        _tid = src._tid;
+        _type = src._type;
+        _location = src._location;
+        _text = src._text;
+        _time = src._time;
+        return *this;
+      }
+
+      /// wall clock time the message was created
+      time_type time() const { return clock::to_system(_time); }
+
+      /// name of the thread that created the message
+      xtd::string thread_name() const { return log::thread_name(_tid); }
+
+      thread_id_type _tid;
+      type _type;
+      source_location _location;
+      xtd::string _text;
+      clock::rep _time;
+    };
+
+    /// formats a wall clock time as UTC yyyy-mm-dd hh:mm:ss.uuuuuu
+    static xtd::string format_time(const message::time_type& oTime) {
+      auto iMicros = std::chrono::duration_cast<std::chrono::microseconds>(oTime.time_since_epoch()).count();
+      auto iSeconds = static_cast<time_t>(iMicros / 1000000);
+      tm oTm;
+#if (XTD_OS_WINDOWS & XTD_OS)
+      gmtime_s(&oTm, &iSeconds);
+#else
+      gmtime_r(&iSeconds, &oTm);
+#endif
+      char sRet[32];
+      auto iLen = strftime(sRet, sizeof(sRet), "%Y-%m-%d %H:%M:%S", &oTm);
+      snprintf(sRet + iLen, sizeof(sRet) - iLen, ".%06u", static_cast<unsigned>(iMicros % 1000000));
+      return sRet;
+    }
+
+    class log_target {
+    public:
+      virtual ~log_target() = default;
+      using pointer_type = std::shared_ptr<log_target>;
+      using vector_type = std::vector<pointer_type>;
+      virtual void operator()(const message::pointer_type&) = 0;
+      /** receives every message drained by the callback thread in a single wakeup
+      targets that can emit a whole batch at once override this, the default forwards each message to operator()
+      */
+      virtual void write(const message::vector_type& oBatch) {
+        for (const auto & oMessage : oBatch) {
+          (*this)(oMessage);
+        }
+      }
+    };
+
+#if (XTD_OS_UNIX & XTD_OS)
+    /** writes each batch of messages to a file descriptor with a single writev
+    */
+    class fd_target : public log_target {
+    public:
+      ~fd_target() override = default;
+
+      void operator()(const message::pointer_type& oMessage) override {
+        write(message::vector_type(1, oMessage));
+      }
+
+      void write(const message::vector_type& oBatch) override {
+        static const char cNewLine = '\n';
+        _iov.clear();
+        if (_decorate) {
+          _prefixes.resize(oBatch.size());
+        }
+        for (size_t i = 0; i < oBatch.size(); ++i) {
+          const auto & oMessage = oBatch[i];
+          if (_decorate) {
+            _prefixes[i] = xtd::string::format(format_time(oMessage->time()), " [", oMessage->thread_name(), "] ", type_string(oMessage->_type), " ");
+            _iov.push_back(iovec{ const_cast<char*>(_prefixes[i].data()), _prefixes[i].size() });
+          }
+          _iov.push_back(iovec{ const_cast<char*>(oMessage->_text.data()), oMessage->_text.size() });
+          _iov.push_back(iovec{ const_cast<char*>(&cNewLine), 1 });
+        }
+        writev_all(_fd, _iov.data(), _iov.size());
+      }
+
+    protected:
+      /**
+      @param fd destination file descriptor
+      @param decorate prefix each line with the time, thread name and message type
+      */
+      fd_target(int fd, bool decorate) : _fd(fd), _decorate(decorate), _iov(), _prefixes() {}
+
+      int _fd;
+
+    private:
+      bool _decorate;
+      std::vector<iovec> _iov;
+      std::vector<xtd::string> _prefixes;
+
+      //logging cannot throw from the callback thread so write errors drop the remainder of the batch
+      static void writev_all(int fd, iovec * pIov, size_t iCount) {
+        static const size_t iMaxIov = static_cast<size_t>(sysconf(_SC_IOV_MAX));
+        while (iCount) {
+          auto iRet = ::writev(fd, pIov, static_cast<int>(std::min(iCount, iMaxIov)));
+          if (iRet < 0) {
+            if (EINTR == errno) continue;
+            return;
+          }
+          auto iWritten = static_cast<size_t>(iRet);
+          for (; iCount && iWritten >= pIov->iov_len; --iCount, ++pIov) {
+            iWritten -= pIov->iov_len;
+          }
+          if (iCount) {
+            pIov->iov_base = static_cast<char*>(pIov->iov_base) + iWritten;
+            pIov->iov_len -= iWritten;
+          }
+        }
+      }
+    };
+
+    /// batched target for standard output
+    class stdout_target : public fd_target {
+    public:
+      stdout_target() : fd_target(STDOUT_FILENO, false) {}
+      ~stdout_target() override = default;
+    };
+
+    /// batched target that appends to a file
+    class file_target : public fd_target {
+    public:
+      explicit file_target(const xtd::filesystem::path& oPath)
+        : fd_target(xtd::crt_exception::throw_if(::open(oPath.string().c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644), [](int i) { return -1 == i; }), true) {}
+      ~file_target() override { ::close(_fd); }
+      file_target(const file_target&) = delete;
+      file_target& operator=(const file_target&) = delete;
+    };
+#endif
+
+    /** log-linear latency histogram in the style of HdrHistogram
+    Values below 16 are exact, larger values land in one of 16 sub-buckets per power of two giving ~6% precision over the full 64 bit range
+    */
+    class latency_histogram {
+    public:
+      static constexpr size_t sub_bucket_bits = 4;
+      static constexpr size_t sub_bucket_count = size_t(1) << sub_bucket_bits;
+      static constexpr size_t bucket_count = (65 - sub_bucket_bits) * sub_bucket_count;
+
+      latency_histogram() : _counts(), _count(0), _sum(0), _min(std::numeric_limits<uint64_t>::max()), _max(0) {}
+
+      void record(uint64_t value) {
+        ++_counts[index(value)];
+        ++_count;
+        _sum += value;
+        _min = std::min(_min, value);
+        _max = std::max(_max, value);
+      }
+
+      uint64_t count() const { return _count; }
+      uint64_t min() const { return _count ? _min : 0; }
+      uint64_t max() const { return _max; }
+      uint64_t mean() const { return _count ? _sum / _count : 0; }
+
+      /// highest value equivalent to the recorded value at the percentile
+      uint64_t percentile(double dPercentile) const {
+        if (!_count) return 0;
+        auto iTarget = static_cast<uint64_t>((dPercentile / 100.0) * static_cast<double>(_count) + 0.5);
+        iTarget = std::max<uint64_t>(1, std::min(iTarget, _count));
+        uint64_t iSeen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+          iSeen += _counts[i];
+          if (iSeen >= iTarget) {
+            return (i + 1 < bucket_count) ? std::min(_max, lowest_value(i + 1) - 1) : _max;
+          }
+        }
+        return _max;
+      }
+
+    private:
+      static size_t index(uint64_t value) {
+        if (value < sub_bucket_count) return static_cast<size_t>(value);
+        auto iShift = most_significant_bit(value) - sub_bucket_bits;
+        return ((iShift + 1) << sub_bucket_bits) + static_cast<size_t>((value >> iShift) - sub_bucket_count);
+      }
+
+      static uint64_t lowest_value(size_t index) {
+        if (index < sub_bucket_count) return index;
+        auto iShift = (index >> sub_bucket_bits) - 1;
+        return static_cast<uint64_t>(sub_bucket_count + (index & (sub_bucket_count - 1))) << iShift;
+      }
+
+      static size_t most_significant_bit(uint64_t value) {
+#if ((XTD_COMPILER_GCC | XTD_COMPILER_CLANG) & XTD_COMPILER)
+        return static_cast<size_t>(63 - __builtin_clzll(value));
+#else
+        size_t iRet = 0;
+        while (value >>= 1) ++iRet;
+        return iRet;
+#endif
+      }
+
+      std::array<uint64_t, bucket_count> _counts;
+      uint64_t _count;
+      uint64_t _sum;
+      uint64_t _min;
+      uint64_t _max;
+    };
+
+    /** pairs the enter and leave messages produced by TRACE_SCOPE and aggregates per span latency histograms
+    The report is handed to dump_event at most once per interval while messages are flowing and is available on demand from report()
+    */
+    class span_target : public log_target {
+    public:
+      using histogram_map = std::map<xtd::string, latency_histogram>;
+
+      /// receives the formatted report each interval
+      xtd::callback<void(const xtd::string&)> dump_event;
+
+      explicit span_target(std::chrono::milliseconds oInterval = std::chrono::seconds(10))
+        : dump_event(), _interval(oInterval), _last_dump(clock::now()), _lock(), _histograms(), _stacks() {}
+      ~span_target() override = default;
+
+      void operator()(const message::pointer_type& oMessage) override {
+        std::lock_guard<std::mutex> oLock(_lock);
+        add(*oMessage);
+      }
+
+      void write(const message::vector_type& oBatch) override {
+        {
+          std::lock_guard<std::mutex> oLock(_lock);
+          for (const auto & oMessage : oBatch) {
+            add(*oMessage);
+          }
+        }
+        auto iNow = clock::now();
+        if (clock::elapsed(_last_dump, iNow) >= _interval) {
+          _last_dump = iNow;
+          dump_event(report());
+        }
+      }
+
+      /// copy of the histograms collected so far, latencies are in nanoseconds
+      histogram_map histograms() const {
+        std::lock_guard<std::mutex> oLock(_lock);
+        return _histograms;
+      }
+
+      /// one line per span with count, mean and percentiles in nanoseconds
+      xtd::string report() const {
+        auto oHistograms = histograms();
+        xtd::string sRet;
+        for (const auto & oSpan : oHistograms) {
+          const auto & oHist = oSpan.second;
+          sRet += xtd::string::format(oSpan.first, " count=", oHist.count(), " mean=", oHist.mean(), "ns p50=", oHist.percentile(50),
+            "ns p90=", oHist.percentile(90), "ns p99=", oHist.percentile(99), "ns p99.9=", oHist.percentile(99.9), "ns max=", oHist.max(), "ns\n");
+        }
+        return sRet;
+      }
+
+    private:
+      void add(const message& oMessage) {
+        if (type::enter == oMessage._type) {
+          _stacks[oMessage._tid].push_back(oMessage._time);
+        } else if (type::leave == oMessage._type) {
+          auto & oStack = _stacks[oMessage._tid];
+          if (oStack.empty()) return;
+          auto iBegin = oStack.back();
+          oStack.pop_back();
+          _histograms[oMessage._text].record(static_cast<uint64_t>(std::max<int64_t>(0, clock::elapsed(iBegin, oMessage._time).count())));
+        }
+      }
+
+      std::chrono::milliseconds _interval;
+      clock::rep _last_dump;
+      mutable std::mutex _lock;
+      histogram_map _histograms;
+      std::map<thread_id_type, std::vector<clock::rep>> _stacks;
+    };
+
+    /** writes enter and leave messages as Chrome trace_event JSON viewable in chrome://tracing or Perfetto
+    The closing bracket is optional in the trace_event array format so the file stays valid while the process runs
+    */
+    class chrome_trace_target : public log_target {
+    public:
+      explicit chrome_trace_target(const xtd::filesystem::path& oPath) : _file(oPath.string(), std::ios::out | std::ios::trunc), _first(true) {
+        _file << "[";
+      }
+      ~chrome_trace_target() override {
+        _file << "\n]\n";
+      }
+
+      void operator()(const message::pointer_type& oMessage) override {
+        add(*oMessage);
+        _file.flush();
+      }
+
+      void write(const message::vector_type& oBatch) override {
+        for (const auto & oMessage : oBatch) {
+          add(*oMessage);
+        }
+        _file.flush();
+      }
+
+    private:
+      void add(const message& oMessage) {
+        if (type::enter != oMessage._type && type::leave != oMessage._type) return;
+        auto iMicros = std::chrono::duration_cast<std::chrono::microseconds>(oMessage.time().time_since_epoch()).count();
+        _file << (_first ? "\n" : ",\n") << "{\"name\":\"";
+        for (auto ch : oMessage._text) {
+          switch (ch) {
+            case '"': _file << "\\\""; break;
+            case '\\': _file << "\\\\"; break;
+            case '\n': _file << "\\n"; break;
+            case '\r': _file << "\\r"; break;
+            case '\t': _file << "\\t"; break;
+            default:
+              if (static_cast<unsigned char>(ch) < 0x20) {
+                static const char sHex[] = "0123456789abcdef";
+                _file << "\\u00" << sHex[(ch >> 4) & 0xf] << sHex[ch & 0xf];
+              } else {
+                _file << ch;
+              }
+          }
+        }
+        _file << "\",\"ph\":\"" << (type::enter == oMessage._type ? 'B' : 'E') << "\",\"ts\":" << iMicros
+              << ",\"pid\":" << xtd::process::this_process().id() << ",\"tid\":" << oMessage._tid << "}";
+        _first = false;
+      }
+
+      std::ofstream _file;
+      bool _first;
+    };
+
+    void Exit() {
+      {
+        std::lock_guard<std::mutex> oLock(_callback_lock);
+        _callbacks.push_back([this]() {
+          _callbackThreadExit = true;
+        });
+        _callbackCheck.notify_one();
+      }
+      if (_callbackThread.joinable()) {
+        _callbackThread.join();
+        _callbackThreadFinished.get_future().get();
+      }
+    }
+
+
+    template <typename _ty>
+    void AddTarget() {
+      std::lock_guard<std::mutex> oLock(_callback_lock);
+      _logTargets.emplace_back(new _ty);
+    }
+
+    void AddTarget(log_target::pointer_type oTarget) {
+      std::lock_guard<std::mutex> oLock(_callback_lock);
+      _logTargets.push_back(oTarget);
+    }
+
+    /// detaches a target added with AddTarget, messages already handed to the logging thread may still reach it
+    void RemoveTarget(const log_target::pointer_type& oTarget) {
+      std::lock_guard<std::mutex> oLock(_callback_lock);
+      _logTargets.erase(std::remove(_logTargets.begin(), _logTargets.end(), oTarget), _logTargets.end());
+    }
+  private:
+
+#if (XTD_LOG_TARGET_SYSLOG)
+    class syslog_target : public log_target{
+    public:
+
+      syslog_target(){ openlog(nullptr, LOG_PID | LOG_NDELAY, 0); }
+      ~syslog_target() override { closelog(); }
+      void operator()(const message::pointer_type& oMessage) override {
+        int iFacility = LOG_MAKEPRI(LOG_USER, LOG_DEBUG);
+        switch (oMessage->_type){
+          case type::fatal:
+          {
+            iFacility = LOG_MAKEPRI(LOG_USER, LOG_CRIT); 
+            break;
+          }
+          case type::error:
+          {
+            iFacility = LOG_MAKEPRI(LOG_USER, LOG_ERR); 
+            break;
+          }
+          case type::warning:
+          {
+            iFacility = LOG_MAKEPRI(LOG_USER, LOG_WARNING); 
+            break;
+          }
+          case type::info:
+          {
+            iFacility = LOG_MAKEPRI(LOG_USER, LOG_INFO); 
+            break;
+          }
+          case type::debug:
+          case type::enter:
+          case type::leave:
+          {
+            iFacility = LOG_MAKEPRI(LOG_USER, LOG_DEBUG); 
+            break;
+          }
+        }
+        syslog(iFacility, "%s", oMessage->_text.c_str());
+      }
+    };
+#endif
+
+#if (XTD_LOG_TARGET_WINDBG)
+    class win_dbg_target : public log_target {
+    public:
+      ~win_dbg_target() override = default;
+
+      void operator()(const message::pointer_type& oMessage) override {
+        OutputDebugStringA(xtd::string::format(oMessage->_text, "\n").c_str());
+      }
+    };
+#endif
+
+
+#if (XTD_LOG_TARGET_COUT)
+    class std_cout_target : public log_target {
+    public:
+      ~std_cout_target() override = default;
+
+      void operator()(const message::pointer_type& oMessage) override {
+        std::cout << oMessage->_text << '\n';
+      }
+
+      void write(const message::vector_type& oBatch) override {
+        for (const auto & oMessage : oBatch) {
+          std::cout << oMessage->_text << '\n';
+        }
+        std::cout.flush();
+      }
+    };
+#endif
+
+#if (XTD_LOG_TARGET_CSV)
+    class csv_target : public log_target {
+      std::ofstream _logfile;
+      std::mutex _FileLock;
+    public:
+
+
+      void operator()(const message::pointer_type& oMsg) override {
+        static thread_local size_t _StackDepth = 1;
+        if (type::leave == oMsg->_type) --_StackDepth;
+        std::string sMsgPrefix(_StackDepth, ',');
+        auto sMsg = xtd::string::format(oMsg->thread_name(), ",", format_time(oMsg->time()), ",", type_string(oMsg->_type), ",", oMsg->_location.file(), ",", oMsg->_location.line(), sMsgPrefix, oMsg->_text);
+        if (type::enter == oMsg->_type) ++_StackDepth;
+        std::unique_lock<std::mutex> oLock(_FileLock);
+        _logfile << sMsg << '\n';
+      }
+
+      csv_target() : _logfile(), _FileLock() {
+        auto oLogPath = xtd::filesystem::home_directory_path();
+        oLogPath /= xtd::executable::this_executable().path().filename();
+        if (!xtd::filesystem::exists(oLogPath)) xtd::filesystem::create_directories(oLogPath);
+        oLogPath /= xtd::tstring::format(intrinsic_cast(xtd::process::this_process().id()), __(".csv"));
+        _logfile.open(oLogPath.tstring(), std::ios::out);
+      }
+    };
+#endif
+
+    void callback_thread() {
+      _callbackThreadStarted.set_value();
+      //swapped with the shared queues on each wakeup so capacity is retained and the lock is held only to exchange buffers
+      message::vector_type oBatch;
+      callback_deque oCallbacks;
+      log_target::vector_type oTargets;
+      while (!_callbackThreadExit) {
+        {
+          std::unique_lock<std::mutex> oLock(_callback_lock);
+          _callbackCheck.wait(oLock, [this] {
+                                return _callbacks.size() || _messages.size();
+                              });
+          oBatch.swap(_messages);
+          oCallbacks.swap(_callbacks);
+          oTargets = _logTargets;
+        }
+        if (oBatch.size()) {
+          for (const auto & oTarget : oTargets) {
+            oTarget->write(oBatch);
+          }
+          oBatch.clear();
+        }
+        for (const auto & oCallback : oCallbacks) {
+          if (oCallback) {
+            oCallback();
+          }
+        }
+        oCallbacks.clear();
+      }
+      _callbackThreadFinished.set_value();
+    }
+
+    log() : _messages(), _callbacks(), _callbackThread(), _callback_lock(), _callbackCheck(), _logTargets()
+        ,_callbackThreadStarted(), _callbackThreadFinished()
+    {
+
+#if (XTD_LOG_TARGET_SYSLOG)
+      _logTargets.emplace_back(new syslog_target);
+#endif
+
+#if (XTD_LOG_TARGET_WINDBG)
+      _logTargets.emplace_back(new win_dbg_target);
+#endif
+
+#if (XTD_LOG_TARGET_COUT)
+      _logTargets.emplace_back(new std_cout_target);
+#endif
+
+#if (XTD_LOG_TARGET_CSV)
+      _logTargets.emplace_back(new csv_target);
+#endif
+
+      clock::calibrate();
+      _callbackThread = std::thread(&log::callback_thread, this);
+      _callbackThreadStarted.get_future().get();
+    }
+
+    ~log() { Exit(); }
+
+    static std::pair<std::mutex, std::map<thread_id_type, xtd::string>>& thread_names() {
+      static std::pair<std::mutex, std::map<thread_id_type, xtd::string>> _names;
+      return _names;
+    }
+
+    using callback_type = std::function<void()>;
+    using callback_deque = std::deque<callback_type>;
+
+    message::vector_type _messages;
+    callback_deque _callbacks;
+    std::thread _callbackThread;
+    std::mutex _callback_lock;
+    std::condition_variable _callbackCheck;
+    log_target::vector_type _logTargets;
+    std::promise<void> _callbackThreadStarted;
+    std::promise<void> _callbackThreadFinished;
+    bool _callbackThreadExit = false;
+
+  public:
+
+    static log& get() {
+      static log _log;
+      return _log;
+    }
+
+    template <typename ... _arg_ts>
+    inline void write(type mesageType, const source_location& location, _arg_ts&&...oArgs) {
+      auto sMessage = xtd::string::format(std::forward<_arg_ts>(oArgs)...);
+      auto oMessage = std::make_shared<message>(mesageType, location, std::move(sMessage)); {
+        std::lock_guard<std::mutex> oLock(_callback_lock);
+        _messages.push_back(std::move(oMessage));
+      }
+      _callbackCheck.notify_one();
+    }
+
+    /** RAII span that logs an enter message on construction and the matching leave message on destruction
+    Use through TRACE_SCOPE, span_target pairs the two into latency histograms
+    */
+    class trace_scope {
+    public:
+      trace_scope(const source_location& location, const char * name) : _location(location), _name(name) {
+        log::get().write(type::enter, _location, _name);
+      }
+      ~trace_scope() {
+        log::get().write(type::leave, _location, _name);
+      }
+      trace_scope(const trace_scope&) = delete;
+      trace_scope& operator=(const trace_scope&) = delete;
+    private:
+      source_location _location;
+      const char * _name;
+    };
+
+  };
+
+
+}
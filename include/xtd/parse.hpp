@@ -10,11 +10,26 @@ text parsing and AST generation
 #include <xtd/xtd.hpp>
 #include <memory>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <typeinfo>
+#include <unordered_map>
+#include <climits>
+#include <cctype>
+#include <functional>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <xtd/exception.hpp>
 #include <xtd/meta.hpp>
 
 namespace xtd{
 
-  template <typename, bool, typename> class parser;
+  template <typename, bool, typename, bool> class parser;
+  template <typename, bool, typename, bool> class stream_parser;
+  template <typename, typename, bool, typename, bool> class parallel_parser;
 
 
   /// @addtogroup Parsing
@@ -88,31 +103,344 @@ namespace xtd{
       parse_error& operator=(parse_error&& src) = delete;
     };
 
+    /** Arena backed AST
+    An alternative to the tree of shared rule_base objects. Nodes live in one contiguous array, each child list is a span of a shared index array and every node
+    records its parent index, so building and releasing the tree costs a few vector appends instead of an allocation and reference count per node.
+    Reusing an ast object for another parse recycles its storage.
+    @tparam iterator_t iterator type of the parsed input
+    */
+    template <typename iterator_t>
+    class ast{
+    public:
+      using iterator_type = iterator_t;
+      using index_type = uint32_t;
+      /// index of no node, such as the parent of the root
+      static constexpr index_type npos = static_cast<index_type>(-1);
+
+      /// a parsed rule or terminal
+      struct node{
+        const std::type_info * type; ///< declared rule type
+        const std::type_info * impl; ///< implementation type of the rule
+        index_type parent; ///< index of the parent node
+        index_type first_child; ///< offset of the first child index in the child array
+        index_type child_count; ///< number of children
+        size_t begin; ///< offset of the first input character covered by the node
+        size_t end; ///< offset one past the last input character covered by the node
+      };
+
+      ast() : _origin(), _root(npos), _nodes(), _children(){}
+
+      /// index of the root node or npos if the last parse failed
+      index_type root() const{ return _root; }
+      /// number of nodes
+      size_t size() const{ return _nodes.size(); }
+      /// node at an index
+      const node& operator[](index_type i) const{ return _nodes[i]; }
+      /// number of children of node i
+      size_t child_count(index_type i) const{ return _nodes[i].child_count; }
+      /// index of child n of node i
+      index_type child(index_type i, size_t n) const{ return _children[_nodes[i].first_child + n]; }
+      /// index of the parent of node i or npos for the root
+      index_type parent(index_type i) const{ return _nodes[i].parent; }
+      /// determines if node i is the specified rule type
+      bool isa(index_type i, const std::type_info& oType) const{ return oType == *_nodes[i].type || oType == *_nodes[i].impl; }
+      /// first input character covered by node i
+      iterator_type begin(index_type i) const{ return _origin + _nodes[i].begin; }
+      /// one past the last input character covered by node i
+      iterator_type end(index_type i) const{ return _origin + _nodes[i].end; }
+      /// removes every node but keeps the storage for the next parse
+      void clear(){
+        _root = npos;
+        _nodes.clear();
+        _children.clear();
+      }
+
+#if (!DOXY_INVOKED)
+      void start(iterator_type oOrigin){
+        clear();
+        _origin = oOrigin;
+      }
+
+      /// appends a node whose children are the indices in [pChildren, pChildren + iCount)
+      index_type add(const std::type_info& oType, const std::type_info& oImpl, iterator_type oBegin, iterator_type oEnd, const index_type * pChildren, size_t iCount){
+        node oNode;
+        oNode.type = &oType;
+        oNode.impl = &oImpl;
+        oNode.parent = npos;
+        oNode.first_child = static_cast<index_type>(_children.size());
+        oNode.child_count = static_cast<index_type>(iCount);
+        oNode.begin = iCount ? _nodes[pChildren[0]].begin : static_cast<size_t>(oBegin - _origin);
+        oNode.end = static_cast<size_t>(oEnd - _origin);
+        _children.insert(_children.end(), pChildren, pChildren + iCount);
+        _nodes.push_back(oNode);
+        return static_cast<index_type>(_nodes.size() - 1);
+      }
+
+      /// size marker used to discard the nodes of a failed alternative
+      std::pair<size_t, size_t> mark() const{ return std::make_pair(_nodes.size(), _children.size()); }
+      void rollback(const std::pair<size_t, size_t>& oMark){
+        _nodes.resize(oMark.first);
+        _children.resize(oMark.second);
+      }
+
+      /// sets the root and the parent index of every node reachable from it
+      void finish(index_type iRoot){
+        _root = iRoot;
+        _nodes[iRoot].parent = npos;
+        std::vector<index_type> oStack(1, iRoot);
+        while (!oStack.empty()){
+          auto i = oStack.back();
+          oStack.pop_back();
+          for (size_t n = 0; n < _nodes[i].child_count; ++n){
+            auto iChild = child(i, n);
+            _nodes[iChild].parent = i;
+            oStack.push_back(iChild);
+          }
+        }
+      }
+#endif
+
+    private:
+      iterator_type _origin;
+      index_type _root;
+      std::vector<node> _nodes;
+      std::vector<index_type> _children;
+    };
+    template <typename iterator_t> constexpr typename ast<iterator_t>::index_type ast<iterator_t>::npos;
+
+#if (!DOXY_INVOKED)
+    namespace _{
+      /// result of a parsed child in either AST mode
+      struct node_ref{
+        std::shared_ptr<rule_base> rule;
+        uint32_t node;
+      };
+
+      /** packrat memo table
+      Records the outcome of each (rule, position) pair so a rule is parsed at most once per input position, which bounds the parse to linear time.
+      Positions are kept as offsets from the origin so the table can follow its input when the buffer holding it moves.
+      */
+      template <typename iterator_t>
+      class memo_table{
+      public:
+        struct entry{
+          bool success;
+          bool in_progress;
+          bool left_recursive;
+          /// the rule examined the input up to the examined offset, only kept when the parse tracks failures
+          bool touched;
+          size_t examined;
+          size_t end;
+          std::shared_ptr<rule_base> rule;
+          uint32_t node;
+        };
+
+        /// leading items of a repetition that more input can't change
+        struct checkpoint{
+          size_t generation;
+          bool touched;
+          size_t examined;
+          size_t end;
+          std::vector<node_ref> items;
+        };
+
+        explicit memo_table(iterator_t oOrigin, bool bResumable = false) : _origin(oOrigin), _resumable(bResumable), _generation(0), _entries(), _checkpoints(), _fresh(){}
+
+        size_t offset(iterator_t oPosition) const{ return static_cast<size_t>(oPosition - _origin); }
+        iterator_t position(size_t iOffset) const{ return _origin + iOffset; }
+
+        /// moves the table to input that now starts at oOrigin
+        void rebase(iterator_t oOrigin){ _origin = oOrigin; }
+
+        /// removes every entry and moves the table to input that starts at oOrigin
+        void clear(iterator_t oOrigin){
+          _origin = oOrigin;
+          _entries.clear();
+          _checkpoints.clear();
+          _fresh.clear();
+        }
+
+        /** removes the entries that examined the input at or past iEnd since more input could change their outcome
+        The parse that follows is a new generation that may resume repetitions from the checkpoints of earlier ones.
+        */
+        void expire(size_t iEnd){
+          //older entries survived an earlier expire with a smaller end so only the entries added since can reach this one
+          for (const auto & oKey : _fresh){
+            auto oItem = _entries.find(oKey);
+            if (_entries.end() != oItem && oItem->second.touched && oItem->second.examined >= iEnd) _entries.erase(oItem);
+          }
+          _fresh.clear();
+          ++_generation;
+        }
+
+        /// determines if repetitions keep checkpoints for the parse of the next chunk
+        bool resumable() const{ return _resumable; }
+        size_t generation() const{ return _generation; }
+
+        /// finds or adds the checkpoint of a repetition at a position
+        checkpoint& resume_point(const void * pRule, iterator_t oPosition){
+          auto oItem = _checkpoints.find(key(pRule, oPosition));
+          if (_checkpoints.end() != oItem) return oItem->second;
+          auto & oRet = _checkpoints[key(pRule, oPosition)];
+          oRet.generation = _generation;
+          oRet.touched = false;
+          oRet.examined = 0;
+          oRet.end = offset(oPosition);
+          return oRet;
+        }
+
+        /// finds the entry for a rule at a position or nullptr
+        entry * find(const void * pRule, iterator_t oPosition){
+          auto oItem = _entries.find(key(pRule, oPosition));
+          return (_entries.end() == oItem) ? nullptr : &oItem->second;
+        }
+
+        /// adds or resets the entry for a rule at a position. References remain valid as the table grows.
+        entry& insert(const void * pRule, iterator_t oPosition){
+          if (_resumable) _fresh.push_back(key(pRule, oPosition));
+          auto & oRet = _entries[key(pRule, oPosition)];
+          oRet.success = false;
+          oRet.in_progress = true;
+          oRet.left_recursive = false;
+          oRet.touched = false;
+          oRet.examined = 0;
+          oRet.end = offset(oPosition);
+          oRet.rule = nullptr;
+          oRet.node = ast<iterator_t>::npos;
+          return oRet;
+        }
+
+      private:
+        using key_type = std::pair<const void*, size_t>;
+        struct key_hash{
+          size_t operator()(const key_type& oKey) const{
+            return std::hash<const void*>()(oKey.first) ^ (oKey.second * 0x9E3779B97F4A7C15ULL);
+          }
+        };
+        key_type key(const void * pRule, iterator_t oPosition) const{ return key_type(pRule, offset(oPosition)); }
+
+        iterator_t _origin;
+        bool _resumable;
+        size_t _generation;
+        std::unordered_map<key_type, entry, key_hash> _entries;
+        std::unordered_map<key_type, checkpoint, key_hash> _checkpoints;
+        /// keys added since the last expire
+        std::vector<key_type> _fresh;
+      };
+
+      /** furthest failure tracker
+      Keeps the furthest position at which any rule or terminal failed and the distinct rules expected there. Recording a failure neither allocates nor
+      copies so backtracking stays cheap; the parse_error list is only built when the caller asks for diagnostics.
+      */
+      template <typename iterator_t>
+      class failure_tracker{
+      public:
+        static const size_t capacity = 16;
+
+        failure_tracker() : _valid(false), _position(), _count(0), _touched(false), _examined(){}
+
+        void record(const std::type_info& oRule, iterator_t oPosition){
+          touch(oPosition);
+          if (!_valid || _position < oPosition){
+            _valid = true;
+            _position = oPosition;
+            _count = 0;
+          } else if (oPosition < _position){
+            return;
+          }
+          for (size_t i = 0; i < _count; ++i){
+            if (*_expected[i] == oRule) return;
+          }
+          if (_count < capacity){
+            _expected[_count++] = &oRule;
+          }
+        }
+
+        /// notes a position a successful terminal looked at without consuming
+        void touch(iterator_t oPosition){
+          if (!_touched || _examined < oPosition){
+            _touched = true;
+            _examined = oPosition;
+          }
+        }
+
+        /// determines if any failure was recorded
+        bool valid() const{ return _valid; }
+        /// furthest position at which a rule or terminal failed
+        iterator_t position() const{ return _position; }
+        /// determines if any position was examined
+        bool touched() const{ return _touched; }
+        /// furthest position examined by a failure or a lookahead
+        iterator_t examined() const{ return _examined; }
+
+        /// starts tracking the examined position of a nested parse on its own. The returned state is passed to resume() when the nested parse ends.
+        std::pair<bool, iterator_t> suspend(){
+          auto oRet = std::make_pair(_touched, _examined);
+          _touched = false;
+          return oRet;
+        }
+        void resume(const std::pair<bool, iterator_t>& oState){
+          if (oState.first) touch(oState.second);
+        }
+
+        /// builds the parse_error list of the furthest failure
+        typename parse_error<iterator_t>::vector errors() const{
+          typename parse_error<iterator_t>::vector oRet;
+          for (size_t i = 0; i < _count; ++i){
+            oRet.push_back(std::make_shared<parse_error<iterator_t>>(*_expected[i], _position));
+          }
+          return oRet;
+        }
+
+      private:
+        bool _valid;
+        iterator_t _position;
+        size_t _count;
+        const std::type_info * _expected[capacity];
+        bool _touched;
+        iterator_t _examined;
+      };
+    }
+#endif
+
     template <typename iterator_t>
     struct context{
       using iterator_type = iterator_t;
       iterator_type begin;
       iterator_type end;
       std::shared_ptr<rule_base> start_rule;
-      typename parse_error<iterator_t>::vector parse_errors;
-      context(const context& src) : begin(src.begin), end(src.end), start_rule(src.start_rule), parse_errors(src.parse_errors){}
-      context(context&& src) : begin(std::move(src.begin)), end(std::move(src.end)), start_rule(std::move(src.start_rule)), parse_errors(std::move(src.parse_errors)){}
+      /// furthest failure tracker shared by every context of a parse or nullptr when the caller didn't ask for diagnostics
+      _::failure_tracker<iterator_t> * failures;
+      /// packrat memo table shared by every context of a parse or nullptr when memoization is disabled
+      _::memo_table<iterator_t> * memo;
+      /// arena that receives the nodes in place of start_rule or nullptr to build shared rule_base objects
+      ast<iterator_t> * arena;
+      /// arena index of the last parsed node
+      uint32_t node;
+      context(const context& src) : begin(src.begin), end(src.end), start_rule(src.start_rule), failures(src.failures), memo(src.memo), arena(src.arena), node(src.node){}
+      context(context&& src) : begin(std::move(src.begin)), end(std::move(src.end)), start_rule(std::move(src.start_rule)), failures(src.failures), memo(src.memo), arena(src.arena), node(src.node){}
       context& operator=(const context& src){
         if (this == &src) return *this;
         begin = src.begin;
         end = src.end;
         start_rule = src.start_rule;
-        parse_errors = src.parse_errors;
+        failures = src.failures;
+        memo = src.memo;
+        arena = src.arena;
+        node = src.node;
         return *this;
       }
       context& operator=(context&& src){
         begin = std::move(src.begin);
         end = std::move(src.end);
         start_rule = std::move(src.start_rule);
-        parse_errors = std::move(src.parse_errors);
+        failures = src.failures;
+        memo = src.memo;
+        arena = src.arena;
+        node = src.node;
         return *this;
       }
-      context(iterator_t& oBegin, iterator_t& oEnd) : begin(oBegin), end(oEnd), start_rule(nullptr), parse_errors(){}
+      context(iterator_t& oBegin, iterator_t& oEnd) : begin(oBegin), end(oEnd), start_rule(nullptr), failures(nullptr), memo(nullptr), arena(nullptr), node(ast<iterator_t>::npos){}
     };
 
 
@@ -146,7 +474,7 @@ namespace xtd{
       */
       pointer_type parent() { return _parent.lock(); }
     private:
-      template <typename, bool, typename> friend class xtd::parser;
+      template <typename, bool, typename, bool> friend class xtd::parser;
       void set_parent(weak_ptr_t oParent){
         _parent = oParent;
         auto oThis = shared_from_this();
@@ -362,39 +690,858 @@ namespace xtd{
 
       template <typename _decl_t, typename _impl_t, bool _ignore_case, typename _whitespace_t> class parse_helper;
 
-      ///case sensitive string
-      template <typename _decl_t, size_t _len, char(&_str)[_len], typename _whitespace_t>
-      class parse_helper<_decl_t, xtd::parse::string<char[_len], _str>, false, _whitespace_t>{
+      /// lower case conversion usable in constant expressions
+      constexpr char to_lower(char ch){ return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch; }
+      constexpr char to_upper(char ch){ return (ch >= 'a' && ch <= 'z') ? static_cast<char>(ch - 'a' + 'A') : ch; }
+
+      /** only named rules (struct x : rule<x, ...>) are memoized
+      Terminals are cheaper to re-parse than to look up, and inline combinators are bounded by the grammar size once the named rules beneath them are memoized.
+      Leaving inline combinators out also lets them be re-evaluated while a left recursive seed grows.
+      */
+      template <typename _ty> struct is_memoized : std::integral_constant<bool, !std::is_same<_ty, typename _ty::impl_type>::value>{};
+
+      /// unique identity of a rule used as the memo key
+      template <typename _ty> struct rule_id{ static const char value; };
+      template <typename _ty> const char rule_id<_ty>::value = 0;
+
+      /// set of byte values
+      struct char_set{
+        uint64_t bits[4];
+        bool test(char ch) const{ return 0 != (bits[static_cast<unsigned char>(ch) >> 6] & (1ULL << (static_cast<unsigned char>(ch) & 63))); }
+        void set(char ch){ bits[static_cast<unsigned char>(ch) >> 6] |= (1ULL << (static_cast<unsigned char>(ch) & 63)); }
+        void set_all(){ bits[0] = bits[1] = bits[2] = bits[3] = ~0ULL; }
+        char_set& operator|=(const char_set& src){
+          for (size_t i = 0; i < 4; ++i) bits[i] |= src.bits[i];
+          return *this;
+        }
+      };
+
+      /// characters of a whitespace declaration as a constant char_set
+      template <typename> struct whitespace_set;
+      template <> struct whitespace_set<whitespace<>>{
+        static constexpr uint64_t word(unsigned){ return 0; }
+        static constexpr char_set value(){ return char_set{ { 0, 0, 0, 0 } }; }
+      };
+      template <char _head_ch, char... _tail_chs> struct whitespace_set<whitespace<_head_ch, _tail_chs...>>{
+        static constexpr uint64_t word(unsigned iWord){
+          return ((static_cast<unsigned char>(_head_ch) >> 6) == iWord ? (1ULL << (static_cast<unsigned char>(_head_ch) & 63)) : 0) | whitespace_set<whitespace<_tail_chs...>>::word(iWord);
+        }
+        static constexpr char_set value(){ return char_set{ { word(0), word(1), word(2), word(3) } }; }
+      };
+
+      /** FIRST set of a rule or terminal
+      The bytes that can start a match and whether the item can match without consuming input. An or_ skips alternatives that can't start with the next byte
+      instead of parsing into them. Sets are computed once per grammar type on first use because string terminals aren't constant expressions.
+      */
+      struct first_info{
+        char_set chars;
+        bool nullable;
+      };
+
+      /// rules on the current path of the FIRST set computation. a recursive reference is treated as unknown
+      struct first_path{
+        const void * rule;
+        const first_path * next;
+      };
+
+      template <typename _ty, bool _ignore_case> void first_of(first_info& oInfo, const first_path * pPath);
+
+      /// unknown items such as regular expressions might start with anything
+      template <typename _impl_t, bool _ignore_case> struct first_helper{
+        static void compute(first_info& oInfo, const first_path *){
+          oInfo.chars.set_all();
+          oInfo.nullable = true;
+        }
+      };
+
+      template <char _ch, bool _ignore_case> struct first_helper<character<_ch>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path *){
+          oInfo.chars.set(_ch);
+          if (_ignore_case){
+            oInfo.chars.set(to_lower(_ch));
+            oInfo.chars.set(to_upper(_ch));
+          }
+        }
+      };
+
+      template <char _first, char _last, bool _ignore_case> struct first_helper<characters<_first, _last>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path *){
+          for (int i = CHAR_MIN; i <= CHAR_MAX; ++i){
+            auto ch = static_cast<char>(i);
+            auto chTest = _ignore_case ? to_lower(ch) : ch;
+            if (chTest >= (_ignore_case ? to_lower(_first) : _first) && chTest <= (_ignore_case ? to_lower(_last) : _last)) oInfo.chars.set(ch);
+          }
+        }
+      };
+
+      template <size_t _len, char(&_str)[_len], bool _ignore_case> struct first_helper<string<char[_len], _str>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path *){
+          if (_len < 2 || !_str[0]){
+            oInfo.nullable = true;
+            return;
+          }
+          oInfo.chars.set(_str[0]);
+          if (_ignore_case){
+            oInfo.chars.set(to_lower(_str[0]));
+            oInfo.chars.set(to_upper(_str[0]));
+          }
+        }
+      };
+
+      template <bool _ignore_case> struct first_helper<and_<>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path *){ oInfo.nullable = true; }
+      };
+      template <typename _head_t, typename ... _tail_ts, bool _ignore_case> struct first_helper<and_<_head_t, _tail_ts...>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path * pPath){
+          first_info oHead = {};
+          first_of<_head_t, _ignore_case>(oHead, pPath);
+          oInfo.chars |= oHead.chars;
+          if (oHead.nullable) first_helper<and_<_tail_ts...>, _ignore_case>::compute(oInfo, pPath);
+        }
+      };
+
+      template <bool _ignore_case> struct first_helper<or_<>, _ignore_case>{
+        static void compute(first_info&, const first_path *){}
+      };
+      template <typename _head_t, typename ... _tail_ts, bool _ignore_case> struct first_helper<or_<_head_t, _tail_ts...>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path * pPath){
+          first_info oHead = {};
+          first_of<_head_t, _ignore_case>(oHead, pPath);
+          oInfo.chars |= oHead.chars;
+          oInfo.nullable |= oHead.nullable;
+          first_helper<or_<_tail_ts...>, _ignore_case>::compute(oInfo, pPath);
+        }
+      };
+
+      //predicates don't consume input
+      template <typename ... _ts, bool _ignore_case> struct first_helper<not_<_ts...>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path *){ oInfo.nullable = true; }
+      };
+
+      template <typename _ty, bool _ignore_case> struct first_helper<one_or_more_<_ty>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path * pPath){ first_of<_ty, _ignore_case>(oInfo, pPath); }
+      };
+      template <typename _ty, bool _ignore_case> struct first_helper<zero_or_more_<_ty>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path * pPath){
+          first_of<_ty, _ignore_case>(oInfo, pPath);
+          oInfo.nullable = true;
+        }
+      };
+      template <typename _ty, bool _ignore_case> struct first_helper<zero_or_one_<_ty>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path * pPath){
+          first_of<_ty, _ignore_case>(oInfo, pPath);
+          oInfo.nullable = true;
+        }
+      };
+
+      template <typename _ty, bool _ignore_case> void first_of(first_info& oInfo, const first_path * pPath){
+        auto pRule = &rule_id<_ty>::value;
+        for (auto pItem = pPath; pItem; pItem = pItem->next){
+          if (pItem->rule == pRule){
+            oInfo.chars.set_all();
+            oInfo.nullable = true;
+            return;
+          }
+        }
+        first_path oPath{ pRule, pPath };
+        first_helper<typename _ty::impl_type, _ignore_case>::compute(oInfo, &oPath);
+      }
+
+      template <typename _ty, bool _ignore_case> struct first_set{
+        static const first_info& get(){
+          static const first_info oRet = compute();
+          return oRet;
+        }
+      private:
+        static first_info compute(){
+          first_info oRet = {};
+          first_of<_ty, _ignore_case>(oRet, nullptr);
+          return oRet;
+        }
+      };
+
+      /// skips the whitespace characters at the beginning of a range
+      template <typename _whitespace_t, typename _iterator_t>
+      _iterator_t skip_whitespace(_iterator_t oBegin, _iterator_t oEnd){
+        static constexpr char_set oWhitespace = whitespace_set<_whitespace_t>::value();
+        while (oBegin < oEnd && oWhitespace.test(*oBegin)) ++oBegin;
+        return oBegin;
+      }
+
+      /** compiled regular expression
+      The pattern is parsed once into a Thompson NFA which is converted to a DFA by subset construction over byte classes. Matching is anchored at the current
+      position, runs in place over any random access iterator and reads each input character once, so it's linear in the length of the match. The longest match wins.
+      Supports literals, escapes (\\d \\D \\w \\W \\s \\S \\xHH \\r \\n \\t and escaped punctuation), '.', bracket expressions with ranges, negation and [:class:] names,
+      (?:) and capture free groups, alternation, the * + ? {n} {n,} {n,m} quantifiers, and ^ and $ at the ends of the pattern. Other constructs throw.
+      */
+      class regex_program{
       public:
-        template<typename _iterator_t> static bool _parse(context<_iterator_t> &oOuter) {
-          context <_iterator_t> oContext(oOuter);
-          parse_helper<_whitespace_t, void, true, void>::_parse(oContext);
+        static const size_t npos = static_cast<size_t>(-1);
+
+        regex_program(const char * pPattern, bool bIgnoreCase) : _pattern(pPattern), _pos(0), _ignore_case(bIgnoreCase), _anchored_end(false), _nodes(), _nfa(), _classes(), _class_count(0), _table(), _accepting(){
+          if ('^' == _peek()) ++_pos;
+          auto iRoot = _alternation();
+          if (_pos < _pattern.size()) _error("unbalanced )");
+          _compile(iRoot);
+        }
+
+        /** matches the pattern at the beginning of a range
+        @param bExhausted set when the match reached the end of the range with more input possibly extending it
+        @returns the length of the longest match or npos
+        */
+        template <typename _iterator_t>
+        size_t match(_iterator_t oBegin, _iterator_t oEnd, bool& bExhausted) const{
+          size_t iRet = _accepting[0] ? 0 : npos;
+          size_t iLen = 0;
+          uint32_t iState = 0;
+          bExhausted = false;
+          for (auto oPos = oBegin; ; ++oPos){
+            if (!(oPos < oEnd)){
+              bExhausted = true;
+              break;
+            }
+            iState = _table[iState * _class_count + _classes[static_cast<unsigned char>(*oPos)]];
+            if (dead == iState) break;
+            ++iLen;
+            if (_accepting[iState]) iRet = iLen;
+          }
+          if (_anchored_end) return (bExhausted && iRet == iLen) ? iRet : npos;
+          return iRet;
+        }
+
+        /// bytes that can begin a match
+        char_set first() const{
+          char_set oRet = {};
+          for (int i = 0; i < 256; ++i){
+            if (dead != _table[_classes[i]]) oRet.set(static_cast<char>(i));
+          }
+          return oRet;
+        }
+        /// determines if the pattern matches the empty string
+        bool nullable() const{ return _accepting[0]; }
+
+      private:
+        static const uint32_t dead = static_cast<uint32_t>(-1);
+        static const int max_repeat = 1000;
+        static const size_t max_states = 10000;
+
+        struct node{
+          enum kind_t{ set_kind, cat_kind, alt_kind, repeat_kind } kind;
+          char_set chars;
+          std::vector<size_t> children;
+          int min;
+          int max;
+        };
+        struct nfa_state{
+          bool split;
+          char_set chars;
+          std::vector<size_t> outs;
+        };
+
+        [[noreturn]] void _error(const char * sWhat) const{
+          throw exception(here(), std::string("Invalid regular expression '") + _pattern + "': " + sWhat);
+        }
+
+        char _peek() const{ return _pos < _pattern.size() ? _pattern[_pos] : '\0'; }
+
+        size_t _add(typename node::kind_t eKind, std::vector<size_t> oChildren, int iMin = 0, int iMax = 0){
+          node oNode;
+          oNode.kind = eKind;
+          oNode.chars = char_set{};
+          oNode.children = std::move(oChildren);
+          oNode.min = iMin;
+          oNode.max = iMax;
+          _nodes.push_back(std::move(oNode));
+          return _nodes.size() - 1;
+        }
+
+        size_t _set(char_set oChars){
+          auto iRet = _add(node::set_kind, std::vector<size_t>());
+          _nodes[iRet].chars = _fold(oChars);
+          return iRet;
+        }
+
+        /// adds the other case of every letter in the set when ignoring case
+        char_set _fold(char_set oChars) const{
+          if (_ignore_case){
+            for (char ch = 'a'; ch <= 'z'; ++ch){
+              if (oChars.test(ch) || oChars.test(to_upper(ch))){
+                oChars.set(ch);
+                oChars.set(to_upper(ch));
+              }
+            }
+          }
+          return oChars;
+        }
+
+        static char_set _range(int iFirst, int iLast){
+          char_set oRet = {};
+          for (int i = iFirst; i <= iLast; ++i) oRet.set(static_cast<char>(i));
+          return oRet;
+        }
+
+        static char_set _invert(char_set oChars){
+          for (auto & iBits : oChars.bits) iBits = ~iBits;
+          return oChars;
+        }
+
+        /// [:name:] character classes with ASCII semantics
+        char_set _named_class(const std::string& sName) const{
+          auto oUpper = _range('A', 'Z'), oLower = _range('a', 'z'), oDigit = _range('0', '9');
+          char_set oRet = {};
+          if ("alpha" == sName){ oRet = oUpper; oRet |= oLower; }
+          else if ("digit" == sName) oRet = oDigit;
+          else if ("alnum" == sName){ oRet = oUpper; oRet |= oLower; oRet |= oDigit; }
+          else if ("upper" == sName) oRet = oUpper;
+          else if ("lower" == sName) oRet = oLower;
+          else if ("xdigit" == sName){ oRet = oDigit; oRet |= _range('a', 'f'); oRet |= _range('A', 'F'); }
+          else if ("space" == sName){ oRet = _range('\t', '\r'); oRet.set(' '); }
+          else if ("blank" == sName){ oRet.set(' '); oRet.set('\t'); }
+          else if ("print" == sName) oRet = _range(0x20, 0x7e);
+          else if ("graph" == sName) oRet = _range(0x21, 0x7e);
+          else if ("cntrl" == sName){ oRet = _range(0, 0x1f); oRet.set(0x7f); }
+          else if ("punct" == sName){ oRet = _range(0x21, 0x2f); oRet |= _range(0x3a, 0x40); oRet |= _range(0x5b, 0x60); oRet |= _range(0x7b, 0x7e); }
+          else _error("unknown character class");
+          return oRet;
+        }
+
+        static int _hex(char ch){
+          if (ch >= '0' && ch <= '9') return ch - '0';
+          if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+          if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+          return -1;
+        }
+
+        /// parses the escape following a backslash. iChar receives the character of single character escapes or -1
+        char_set _escape(int& iChar){
+          if (_pos >= _pattern.size()) _error("trailing backslash");
+          auto ch = _pattern[_pos++];
+          char_set oRet = {};
+          iChar = -1;
+          switch (ch){
+            case 'd': return _range('0', '9');
+            case 'D': return _invert(_range('0', '9'));
+            case 'w': oRet = _named_class("alnum"); oRet.set('_'); return oRet;
+            case 'W': oRet = _named_class("alnum"); oRet.set('_'); return _invert(oRet);
+            case 's': return _named_class("space");
+            case 'S': return _invert(_named_class("space"));
+            case 'n': iChar = '\n'; break;
+            case 'r': iChar = '\r'; break;
+            case 't': iChar = '\t'; break;
+            case 'f': iChar = '\f'; break;
+            case 'v': iChar = '\v'; break;
+            case '0': iChar = 0; break;
+            case 'x':{
+              auto iHigh = _hex(_peek());
+              auto iLow = (_pos + 1 < _pattern.size()) ? _hex(_pattern[_pos + 1]) : -1;
+              if (iHigh < 0 || iLow < 0) _error("invalid \\x escape");
+              _pos += 2;
+              iChar = iHigh * 16 + iLow;
+              break;
+            }
+            default:
+              if (isalnum(static_cast<unsigned char>(ch))) _error("unsupported escape");
+              iChar = static_cast<unsigned char>(ch);
+          }
+          oRet.set(static_cast<char>(iChar));
+          return oRet;
+        }
+
+        /// parses one bracket expression member. iChar receives the character of single character members or -1
+        char_set _bracket_item(int& iChar){
+          auto ch = _pattern[_pos++];
+          if ('\\' == ch) return _escape(iChar);
+          if ('[' == ch && ':' == _peek()){
+            auto iClose = _pattern.find(":]", _pos + 1);
+            if (std::string::npos == iClose) _error("unterminated character class");
+            auto sName = _pattern.substr(_pos + 1, iClose - _pos - 1);
+            _pos = iClose + 2;
+            iChar = -1;
+            return _named_class(sName);
+          }
+          iChar = static_cast<unsigned char>(ch);
+          char_set oRet = {};
+          oRet.set(ch);
+          return oRet;
+        }
+
+        char_set _bracket(){
+          bool bNegate = false;
+          if ('^' == _peek()){
+            bNegate = true;
+            ++_pos;
+          }
+          char_set oRet = {};
+          bool bFirst = true;
+          while (_pos < _pattern.size() && (bFirst || ']' != _peek())){
+            bFirst = false;
+            int iFirst;
+            auto oItem = _bracket_item(iFirst);
+            if ('-' == _peek() && _pos + 1 < _pattern.size() && ']' != _pattern[_pos + 1] && iFirst >= 0){
+              ++_pos;
+              int iLast;
+              _bracket_item(iLast);
+              if (iLast < iFirst) _error("invalid range");
+              oItem = _range(iFirst, iLast);
+            }
+            oRet |= oItem;
+          }
+          if (']' != _peek()) _error("unterminated bracket expression");
+          ++_pos;
+          //the members are folded before negation so [^a] excludes both cases
+          return bNegate ? _invert(_fold(oRet)) : oRet;
+        }
+
+        size_t _atom(){
+          auto ch = _pattern[_pos++];
+          switch (ch){
+            case '(':{
+              if ('?' == _peek()){
+                if (_pos + 1 >= _pattern.size() || ':' != _pattern[_pos + 1]) _error("unsupported group");
+                _pos += 2;
+              }
+              auto iRet = _alternation();
+              if (')' != _peek()) _error("missing )");
+              ++_pos;
+              return iRet;
+            }
+            case '[': return _set(_bracket());
+            case '.':{
+              auto oChars = _invert(char_set{});
+              oChars.bits[0] &= ~((1ULL << '\n') | (1ULL << '\r'));
+              return _set(oChars);
+            }
+            case '\\':{
+              int iChar;
+              return _set(_escape(iChar));
+            }
+            case '$':
+              if (_pos != _pattern.size()) _error("$ is only supported at the end of the pattern");
+              _anchored_end = true;
+              return _add(node::cat_kind, std::vector<size_t>());
+            case '^': _error("^ is only supported at the beginning of the pattern");
+            case '*': case '+': case '?': _error("nothing to repeat");
+            default:{
+              char_set oChars = {};
+              oChars.set(ch);
+              return _set(oChars);
+            }
+          }
+        }
+
+        /// parses {n}, {n,} or {n,m}. A brace that doesn't start a valid bound is a literal
+        bool _bounds(int& iMin, int& iMax){
+          auto iStart = _pos;
+          auto fnNumber = [this](int& iValue){
+            if (!isdigit(static_cast<unsigned char>(_peek()))) return false;
+            iValue = 0;
+            while (isdigit(static_cast<unsigned char>(_peek()))){
+              iValue = iValue * 10 + (_pattern[_pos++] - '0');
+              if (iValue > max_repeat) _error("repeat count too large");
+            }
+            return true;
+          };
+          ++_pos;
+          if (fnNumber(iMin)){
+            iMax = iMin;
+            if (',' == _peek()){
+              ++_pos;
+              if (!fnNumber(iMax)) iMax = -1;
+            }
+            if ('}' == _peek()){
+              ++_pos;
+              if (iMax >= 0 && iMax < iMin) _error("invalid repeat bounds");
+              return true;
+            }
+          }
+          _pos = iStart;
+          return false;
+        }
+
+        size_t _repeat(){
+          auto iRet = _atom();
+          forever{
+            int iMin, iMax;
+            auto ch = _peek();
+            if ('*' == ch){ iMin = 0; iMax = -1; ++_pos; }
+            else if ('+' == ch){ iMin = 1; iMax = -1; ++_pos; }
+            else if ('?' == ch){ iMin = 0; iMax = 1; ++_pos; }
+            else if ('{' != ch || !_bounds(iMin, iMax)) return iRet;
+            if ('?' == _peek()) _error("lazy quantifiers are not supported");
+            iRet = _add(node::repeat_kind, std::vector<size_t>(1, iRet), iMin, iMax);
+          }
+        }
+
+        size_t _concat(){
+          std::vector<size_t> oItems;
+          while (_pos < _pattern.size() && '|' != _peek() && ')' != _peek()) oItems.push_back(_repeat());
+          return _add(node::cat_kind, std::move(oItems));
+        }
+
+        size_t _alternation(){
+          std::vector<size_t> oItems(1, _concat());
+          while ('|' == _peek()){
+            ++_pos;
+            oItems.push_back(_concat());
+          }
+          return 1 == oItems.size() ? oItems[0] : _add(node::alt_kind, std::move(oItems));
+        }
+
+        size_t _state(bool bSplit, const char_set& oChars, std::vector<size_t> oOuts){
+          nfa_state oState;
+          oState.split = bSplit;
+          oState.chars = oChars;
+          oState.outs = std::move(oOuts);
+          _nfa.push_back(std::move(oState));
+          return _nfa.size() - 1;
+        }
 
-          for (size_t i = 0; (i < (_len-1)) && (oContext.begin < oContext.end); ++i, ++oContext.begin){
-            if (_str[i] != *oContext.begin){
-              oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>>(typeid(_decl_t), oContext.begin));
-              return false;
+        /// builds the NFA of a node that continues at iNext and returns its entry state
+        size_t _build(size_t iNode, size_t iNext){
+          const auto & oNode = _nodes[iNode];
+          switch (oNode.kind){
+            case node::set_kind: return _state(false, oNode.chars, std::vector<size_t>(1, iNext));
+            case node::cat_kind:
+              for (auto oItem = oNode.children.rbegin(); oItem != oNode.children.rend(); ++oItem) iNext = _build(*oItem, iNext);
+              return iNext;
+            case node::alt_kind:{
+              std::vector<size_t> oOuts;
+              for (auto iChild : oNode.children) oOuts.push_back(_build(iChild, iNext));
+              return _state(true, char_set{}, std::move(oOuts));
+            }
+            case node::repeat_kind:{
+              auto iChild = oNode.children[0];
+              if (oNode.max < 0){
+                auto iLoop = _state(true, char_set{}, std::vector<size_t>());
+                auto iBody = _build(iChild, iLoop);
+                _nfa[iLoop].outs = { iBody, iNext };
+                iNext = iLoop;
+              } else{
+                for (int i = oNode.min; i < oNode.max; ++i){
+                  auto iBody = _build(iChild, iNext);
+                  iNext = _state(true, char_set{}, { iBody, iNext });
+                }
+              }
+              for (int i = 0; i < oNode.min; ++i) iNext = _build(iChild, iNext);
+              return iNext;
+            }
+          }
+          return iNext;
+        }
+
+        /// adds the non-split states reachable from iState without consuming input
+        void _closure(size_t iState, std::vector<size_t>& oSet, std::vector<bool>& oSeen) const{
+          std::vector<size_t> oStack(1, iState);
+          while (!oStack.empty()){
+            auto i = oStack.back();
+            oStack.pop_back();
+            if (oSeen[i]) continue;
+            oSeen[i] = true;
+            if (_nfa[i].split){
+              for (auto oOut = _nfa[i].outs.rbegin(); oOut != _nfa[i].outs.rend(); ++oOut) oStack.push_back(*oOut);
+            } else{
+              oSet.push_back(i);
+            }
+          }
+        }
+
+        void _compile(size_t iRoot){
+          //NFA state 0 accepts
+          _state(false, char_set{}, std::vector<size_t>());
+          auto iStart = _build(iRoot, 0);
+          //bytes that every NFA transition treats alike share a class
+          std::map<std::vector<bool>, uint8_t> oSignatures;
+          std::vector<int> oRepresentatives;
+          _classes.resize(256);
+          for (int iByte = 0; iByte < 256; ++iByte){
+            std::vector<bool> oSignature;
+            oSignature.reserve(_nfa.size());
+            for (const auto & oState : _nfa) oSignature.push_back(!oState.split && oState.chars.test(static_cast<char>(iByte)));
+            auto oItem = oSignatures.find(oSignature);
+            if (oSignatures.end() == oItem){
+              oItem = oSignatures.insert(std::make_pair(oSignature, static_cast<uint8_t>(oRepresentatives.size()))).first;
+              oRepresentatives.push_back(iByte);
+            }
+            _classes[iByte] = oItem->second;
+          }
+          _class_count = oRepresentatives.size();
+          //subset construction
+          std::map<std::vector<size_t>, uint32_t> oIds;
+          std::vector<std::vector<size_t>> oStates;
+          auto fnState = [&](std::vector<size_t>& oSet){
+            std::sort(oSet.begin(), oSet.end());
+            auto oItem = oIds.find(oSet);
+            if (oIds.end() != oItem) return oItem->second;
+            if (oStates.size() >= max_states) _error("too many DFA states");
+            auto iId = static_cast<uint32_t>(oStates.size());
+            oIds.insert(std::make_pair(oSet, iId));
+            oStates.push_back(oSet);
+            return iId;
+          };
+          {
+            std::vector<size_t> oSet;
+            std::vector<bool> oSeen(_nfa.size(), false);
+            _closure(iStart, oSet, oSeen);
+            fnState(oSet);
+          }
+          for (size_t iState = 0; iState < oStates.size(); ++iState){
+            _accepting.push_back(std::find(oStates[iState].begin(), oStates[iState].end(), size_t(0)) != oStates[iState].end());
+            _table.resize((iState + 1) * _class_count, static_cast<uint32_t>(dead));
+            for (size_t iClass = 0; iClass < _class_count; ++iClass){
+              auto ch = static_cast<char>(oRepresentatives[iClass]);
+              std::vector<size_t> oNext;
+              std::vector<bool> oSeen(_nfa.size(), false);
+              for (auto iNFA : oStates[iState]){
+                if (_nfa[iNFA].chars.test(ch)) _closure(_nfa[iNFA].outs[0], oNext, oSeen);
+              }
+              if (!oNext.empty()) _table[iState * _class_count + iClass] = fnState(oNext);
             }
           }
+        }
+
+        std::string _pattern;
+        size_t _pos;
+        bool _ignore_case;
+        bool _anchored_end;
+        std::vector<node> _nodes;
+        std::vector<nfa_state> _nfa;
+        std::vector<uint8_t> _classes;
+        size_t _class_count;
+        std::vector<uint32_t> _table;
+        std::vector<bool> _accepting;
+      };
+
+      /// the compiled program of a regex terminal, built once on first use
+      template <size_t _len, char(&_str)[_len], bool _ignore_case> struct regex_cache{
+        static const regex_program& get(){
+          static const regex_program oRet(_str, _ignore_case);
+          return oRet;
+        }
+      };
+
+      template <size_t _len, char(&_str)[_len], bool _ignore_case> struct first_helper<regex<char[_len], _str>, _ignore_case>{
+        static void compute(first_info& oInfo, const first_path *){
+          const auto & oProgram = regex_cache<_len, _str, _ignore_case>::get();
+          oInfo.chars |= oProgram.first();
+          oInfo.nullable = oProgram.nullable();
+        }
+      };
+
+      /// records a failed rule or terminal when the caller asked for diagnostics
+      template <typename _iterator_t>
+      void fail(context<_iterator_t>& oContext, const std::type_info& oRule, _iterator_t oPosition){
+        if (oContext.failures) oContext.failures->record(oRule, oPosition);
+      }
+
+      template <typename _iterator_t> node_ref result(const context<_iterator_t>& oContext){ return node_ref{ oContext.start_rule, oContext.node }; }
 
-          /*
-          Problem: The string comparison algorithms compare character by character and skip any leading or trailing whitespace between terminals.
-            Rules 'ABC' + 'XYZ' maybe defined expecting the two terminals be separated by whitespace but this algorithm could parse the string 'ABCXYZ' as two separate terminals.
-            There's a number of traditional approaches to solving this such as tokenizing before parsing or creating parse tables.
-            A proper handling would compound the complexity of this library beyond it's intended scope, there are plenty of complex parsers around.
-            Currently, the last character parsed is checked against the next character in the stream to see if they're of the same 'class' and fail if so.
-            This isn't ideal because it maybe perfectly valid in some grammars to expect 'ABCXYZ' to appear in the input stream yet successfully parse into independent terminals.
-            This library assumes contiguous alpha-numeric terminals constitute a single terminal so the input stream of 'ABCXYZ' will fail to parse without grammar definition trickery
-          */
-          if (oContext.begin < oContext.end && isalnum(*oContext.begin) && isalnum(_str[_len - 2])){
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oContext.begin));
+      /** sets the result of a terminal
+      @param oBegin first character of the terminal
+      @param oEnd one past the last character of the terminal
+      @param oArgs constructor arguments of the rule_base object
+      */
+      template <typename _decl_t, typename _iterator_t, typename ... _arg_ts>
+      void make_leaf(context<_iterator_t>& oContext, _iterator_t oBegin, _iterator_t oEnd, _arg_ts&&...oArgs){
+        if (oContext.arena){
+          oContext.node = oContext.arena->add(typeid(_decl_t), typeid(typename _decl_t::impl_type), oBegin, oEnd, nullptr, 0);
+          oContext.start_rule = nullptr;
+        } else{
+          oContext.start_rule = std::make_shared<_decl_t>(std::forward<_arg_ts>(oArgs)...);
+        }
+      }
+
+      /// sets the result of a rule from the results of its children
+      template <typename _decl_t, typename _iterator_t, typename ... _child_ts>
+      void make_node(context<_iterator_t>& oContext, _child_ts&&...oChildren){
+        if (oContext.arena){
+          const uint32_t oIndices[] = { oChildren.node..., 0 };
+          oContext.node = oContext.arena->add(typeid(_decl_t), typeid(typename _decl_t::impl_type), oContext.begin, oContext.begin, oIndices, sizeof...(_child_ts));
+          oContext.start_rule = nullptr;
+        } else{
+          oContext.start_rule = std::make_shared<_decl_t>(oChildren.rule...);
+        }
+      }
+
+      /// sets the result of a repetition from a run time list of children
+      template <typename _decl_t, typename _iterator_t>
+      void make_list(context<_iterator_t>& oContext, const std::vector<node_ref>& oChildren){
+        if (oContext.arena){
+          std::vector<uint32_t> oIndices;
+          oIndices.reserve(oChildren.size());
+          for (const auto & oChild : oChildren) oIndices.push_back(oChild.node);
+          oContext.node = oContext.arena->add(typeid(_decl_t), typeid(typename _decl_t::impl_type), oContext.begin, oContext.begin, oIndices.data(), oIndices.size());
+          oContext.start_rule = nullptr;
+        } else{
+          auto oParent = std::make_shared<_decl_t>();
+          for (const auto & oChild : oChildren) oParent->push_back(oChild.rule);
+          oContext.start_rule = oParent;
+        }
+      }
+
+      /** parses a child rule or terminal
+      Every child is parsed through here so that packrat mode can memoize non-terminals. Without a memo table nothing refers
+      to the arena nodes of a failed attempt so they are rolled back here, including the partial matches repetitions end on.
+      A memo entry is seeded as a failure before the rule is parsed. A left recursive rule that reaches its own seed fails that alternative, and then the seed is grown
+      by re-parsing until the match stops getting longer, so directly left recursive rules parse as left associative instead of recursing forever.
+      When failures are tracked each entry also keeps the furthest position its rule examined, which tells a stream parser the entries more input can't change.
+      */
+      template <typename _ty, bool _ignore_case, typename _whitespace_t, typename _iterator_t>
+      bool parse_item(context<_iterator_t>& oContext){
+        using helper_type = parse_helper<_ty, typename _ty::impl_type, _ignore_case, _whitespace_t>;
+        if (!oContext.memo && oContext.arena){
+          auto oMark = oContext.arena->mark();
+          if (helper_type::_parse(oContext)) return true;
+          oContext.arena->rollback(oMark);
+          return false;
+        }
+        if (!oContext.memo || !is_memoized<_ty>::value){
+          return helper_type::_parse(oContext);
+        }
+        auto & oMemo = *oContext.memo;
+        auto pRule = &rule_id<_ty>::value;
+        auto oStart = oContext.begin;
+        if (auto pEntry = oMemo.find(pRule, oStart)){
+          if (pEntry->in_progress){
+            pEntry->left_recursive = true;
+          }
+          //the cached outcome still depends on everything the rule examined
+          if (pEntry->touched && oContext.failures) oContext.failures->touch(oMemo.position(pEntry->examined));
+          if (!pEntry->success){
+            fail(oContext, typeid(_ty), oStart);
             return false;
           }
-          parse_helper<_whitespace_t, void, true, void>::_parse(oContext);
-          oContext.start_rule = std::make_shared<_decl_t>();
-          oOuter = oContext;
+          oContext.begin = oMemo.position(pEntry->end);
+          oContext.start_rule = pEntry->rule;
+          oContext.node = pEntry->node;
           return true;
         }
+        auto & oEntry = oMemo.insert(pRule, oStart);
+        auto oOuterExamined = oContext.failures ? oContext.failures->suspend() : std::make_pair(false, oStart);
+        context<_iterator_t> oAttempt(oContext);
+        auto bRet = helper_type::_parse(oAttempt);
+        if (bRet){
+          oEntry.success = true;
+          oEntry.end = oMemo.offset(oAttempt.begin);
+          oEntry.rule = oAttempt.start_rule;
+          oEntry.node = oAttempt.node;
+          //grow the seed of a left recursive rule
+          while (oEntry.left_recursive){
+            context<_iterator_t> oGrow(oContext);
+            if (!helper_type::_parse(oGrow) || oMemo.offset(oGrow.begin) <= oEntry.end){
+              break;
+            }
+            oEntry.end = oMemo.offset(oGrow.begin);
+            oEntry.rule = oGrow.start_rule;
+            oEntry.node = oGrow.node;
+            oAttempt = oGrow;
+          }
+          oContext = oAttempt;
+        }
+        oEntry.in_progress = false;
+        if (oContext.failures){
+          oEntry.touched = oContext.failures->touched();
+          if (oEntry.touched) oEntry.examined = oMemo.offset(oContext.failures->examined());
+          oContext.failures->resume(oOuterExamined);
+        }
+        return bRet;
+      }
+
+      /** parses the items of a repetition until one fails
+      The memo table of a stream parser keeps the leading items that examined nothing past the end of the buffered input, so the parse of the next chunk
+      resumes after them instead of walking every item of a long repetition again.
+      */
+      template <typename _decl_t, typename _ty, bool _ignore_case, typename _whitespace_t, typename _iterator_t>
+      void parse_items(context<_iterator_t>& oContext, std::vector<node_ref>& oItems){
+        auto pFailures = oContext.failures;
+        if (!pFailures || !oContext.memo || !oContext.memo->resumable()){
+          while (parse_item<_ty, _ignore_case, _whitespace_t>(oContext)){
+            oItems.push_back(result(oContext));
+          }
+          return;
+        }
+        auto & oMemo = *oContext.memo;
+        auto & oCheckpoint = oMemo.resume_point(&rule_id<_decl_t>::value, oContext.begin);
+        //checkpoints of the current generation may have been taken while a left recursive seed was still growing
+        auto bResume = oCheckpoint.generation < oMemo.generation();
+        if (bResume){
+          oItems = oCheckpoint.items;
+          oContext.begin = oMemo.position(oCheckpoint.end);
+          if (oCheckpoint.touched) pFailures->touch(oMemo.position(oCheckpoint.examined));
+        }
+        auto iStable = oItems.size();
+        auto iStableEnd = oMemo.offset(oContext.begin);
+        auto bStableTouched = bResume && oCheckpoint.touched;
+        size_t iStableExamined = bResume ? oCheckpoint.examined : 0;
+        forever{
+          auto oOuterExamined = pFailures->suspend();
+          auto bParsed = parse_item<_ty, _ignore_case, _whitespace_t>(oContext);
+          auto bTouched = pFailures->touched();
+          auto iExamined = bTouched ? oMemo.offset(pFailures->examined()) : 0;
+          pFailures->resume(oOuterExamined);
+          if (!bParsed) break;
+          oItems.push_back(result(oContext));
+          //items after one that reached the end of the input aren't kept either
+          if (iStable + 1 != oItems.size() || (bTouched && iExamined >= oMemo.offset(oContext.end))) continue;
+          iStable = oItems.size();
+          iStableEnd = oMemo.offset(oContext.begin);
+          if (bTouched && (!bStableTouched || iStableExamined < iExamined)){
+            bStableTouched = true;
+            iStableExamined = iExamined;
+          }
+        }
+        if (iStable > oCheckpoint.items.size()){
+          oCheckpoint.generation = oMemo.generation();
+          oCheckpoint.touched = bStableTouched;
+          oCheckpoint.examined = iStableExamined;
+          oCheckpoint.end = iStableEnd;
+          //the kept items are a prefix of the ones just parsed
+          oCheckpoint.items.insert(oCheckpoint.items.end(), oItems.begin() + oCheckpoint.items.size(), oItems.begin() + iStable);
+        }
+      }
+
+      /** matches a string terminal
+      Compares the literal against the input in one pass without copying the context unless the match succeeds.
+      @param pStr literal to match
+      @param iLen length of the literal
+      @param fnEqual compares a literal character to an input character
+      */
+      template <typename _decl_t, typename _whitespace_t, typename _iterator_t, typename _equal_t>
+      bool match_string(context<_iterator_t>& oOuter, const char * pStr, size_t iLen, _equal_t fnEqual){
+        auto oFirst = skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end);
+        auto iAvail = static_cast<size_t>(oOuter.end - oFirst);
+        auto oMismatch = std::mismatch(pStr, pStr + (iLen < iAvail ? iLen : iAvail), oFirst, fnEqual);
+        if (oMismatch.first != pStr + iLen){
+          fail(oOuter, typeid(_decl_t), oMismatch.second);
+          return false;
+        }
+        auto oLast = oMismatch.second;
+        //the separation check below looks one character past a literal that ends in an alphanumeric
+        if (iLen && isalnum(pStr[iLen - 1]) && oOuter.failures) oOuter.failures->touch(oLast);
+        /*
+        Problem: The string comparison algorithms compare character by character and skip any leading or trailing whitespace between terminals.
+          Rules 'ABC' + 'XYZ' maybe defined expecting the two terminals be separated by whitespace but this algorithm could parse the string 'ABCXYZ' as two separate terminals.
+          There's a number of traditional approaches to solving this such as tokenizing before parsing or creating parse tables.
+          A proper handling would compound the complexity of this library beyond it's intended scope, there are plenty of complex parsers around.
+          Currently, the last character parsed is checked against the next character in the stream to see if they're of the same 'class' and fail if so.
+          This isn't ideal because it maybe perfectly valid in some grammars to expect 'ABCXYZ' to appear in the input stream yet successfully parse into independent terminals.
+          This library assumes contiguous alpha-numeric terminals constitute a single terminal so the input stream of 'ABCXYZ' will fail to parse without grammar definition trickery
+        */
+        if (iLen && oLast < oOuter.end && isalnum(*oLast) && isalnum(pStr[iLen - 1])){
+          fail(oOuter, typeid(_decl_t), oLast);
+          return false;
+        }
+        oOuter.begin = skip_whitespace<_whitespace_t>(oLast, oOuter.end);
+        make_leaf<_decl_t>(oOuter, oFirst, oLast);
+        return true;
+      }
+
+      ///case sensitive string
+      template <typename _decl_t, size_t _len, char(&_str)[_len], typename _whitespace_t>
+      class parse_helper<_decl_t, xtd::parse::string<char[_len], _str>, false, _whitespace_t>{
+      public:
+        template<typename _iterator_t> static bool _parse(context<_iterator_t> &oOuter) {
+          return match_string<_decl_t, _whitespace_t>(oOuter, _str, _len - 1, [](char chStr, char chInput){ return chStr == chInput; });
+        }
       };
 
 
@@ -403,88 +1550,37 @@ namespace xtd{
       class parse_helper<_decl_t, parse::string<char[_len], _str>, true, _whitespace_t>{
       public:
         template<typename _iterator_t> static bool _parse(context<_iterator_t> &oOuter) {
-          context <_iterator_t> oContext(oOuter);
-          parse_helper<_whitespace_t, void, true, void>::_parse(oContext);
-          if (oContext.begin >= oContext.end){
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oContext.begin));
-            return false;
-          }
-          for (size_t i = 0; (i < _len-1) && (oContext.begin < oContext.end); ++i, ++oContext.begin){
-            if (tolower(_str[i]) != tolower(*oContext.begin)){
-              oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oContext.begin));
-              return false;
-            }
-          }
-          ///ensure there's an identifiable separation between terminals. this should be done differently
-          if (oContext.begin < oContext.end && isalnum(*oContext.begin) && isalnum(_str[_len - 2])){
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oContext.begin));
-            return false;
-          }
-          parse_helper<_whitespace_t, void, true, void>::_parse(oContext);
-          oContext.start_rule = std::make_shared<_decl_t>();
-          oOuter = oContext;
-          return true;
+          //the literal is lowered once so each input character is converted only once
+          static const std::string sLower = lowered();
+          return match_string<_decl_t, _whitespace_t>(oOuter, sLower.c_str(), _len - 1, [](char chStr, char chInput){ return chStr == to_lower(chInput); });
+        }
+      private:
+        static std::string lowered(){
+          std::string sRet(_str, _len - 1);
+          for (auto & ch : sRet) ch = to_lower(ch);
+          return sRet;
         }
       };
-#if 0
       ///regex
       template <typename _decl_t, size_t _len, char(&_str)[_len], bool _ignore_case, typename _whitespace_t>
       class parse_helper<_decl_t, parse::regex<char[_len], _str>, _ignore_case, _whitespace_t> {
       public:
         template<typename _iterator_t> static bool _parse(context<_iterator_t> &oOuter) {
-          context <_iterator_t> oContext(oOuter);
-          parse_helper<_whitespace_t, void, true, void>::_parse(oContext);
-          static constexpr auto iFlags = boost::regex_constants::ECMAScript | (_ignore_case ? boost::regex_constants::icase : 0);
-          static const boost::regex oRE(_str, iFlags);
-          //boost::match_results<std::string::iterator> oMatches;
-          boost::smatch oMatches;
-          //if (!boost::regex_search(oContext.begin, oContext.end, oMatches, oRE, boost::regex_constants::match_continuous | boost::regex_constants::match_not_null)) {
-          std::string sTemp(oContext.begin, oContext.end);
-          if (!boost::regex_search(sTemp, oMatches, oRE, boost::regex_constants::match_default)) {
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oContext.begin));
-            return false;
-          }
-          
-          oMatches.
-
-          for (const auto & oMatch : oMatches) {
-            std::cout << "Match : " << oMatch << " length:" << oMatch.length()  << "\n";
-            std::cout << "   first : " << *oMatch.first << "\n";
-            std::cout << "   second : " << *oMatch.second << "\n";
-//            std::cout << "   str: " << oMatch.str() << " prefix: " << oMatch.prefix() << " suffix: " << oMatch.suffix() << "\n";
-          }
-
-          return false;
-/*
-        
-          auto oMatch = oMatches[0];
-          auto foo = oMatches.length(0);
-          auto iLen = std::distance(std::cbegin(oMatches), std::cend(oMatches));
-          auto iMax = oMatches.max_size();
-          auto oFirst = *oMatch.first;
-          auto oSecond = *oMatch.second;
-
-          auto x = false;
-          //std::string sval = *oMatches[0].first;
-          auto sVal = std::string(oMatch.begin(), oMatch.end());
-          oContext.begin += sVal.length();
-*/
-          //need to do this oContext.begin += oMatches.length(0);
-
-          ///ensure there's an identifiable separation between terminals. this should be done differently
-/*
-          if (oContext.begin < oContext.end && isalnum(*oContext.begin) && isalnum(_str[_len - 1])) {
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oContext.begin));
+          auto oFirst = skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end);
+          bool bExhausted;
+          auto iLen = regex_cache<_len, _str, _ignore_case>::get().match(oFirst, oOuter.end, bExhausted);
+          //more input could have extended the match
+          if (bExhausted && oOuter.failures) oOuter.failures->touch(oOuter.end);
+          if (regex_program::npos == iLen){
+            fail(oOuter, typeid(_decl_t), oFirst);
             return false;
           }
-          parse_helper<_whitespace_t, void, true, void>::_parse(oContext);
-*/
-          oContext.start_rule = std::make_shared<_decl_t>("");
-          oOuter = oContext;
+          auto oLast = oFirst + iLen;
+          oOuter.begin = skip_whitespace<_whitespace_t>(oLast, oOuter.end);
+          make_leaf<_decl_t>(oOuter, oFirst, oLast, oOuter.arena ? std::string() : std::string(oFirst, oLast));
           return true;
         }
       };
-#endif
       ///whitespace
       template <bool _ignore_case>
       class parse_helper<whitespace<>, void, _ignore_case, void>{
@@ -498,14 +1594,7 @@ namespace xtd{
       public:
         template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oContext) {
-          while (oContext.begin < oContext.end){
-            if (*oContext.begin == _head_ch) {
-              oContext.begin++;
-              continue;
-            }
-            if (parse_helper<whitespace<_tail_chs...>, void, _ignore_case, void>::_parse(oContext)) continue;
-            break;
-          }
+          oContext.begin = skip_whitespace<whitespace<_head_ch, _tail_chs...>>(oContext.begin, oContext.end);
           return false;
         }
       };
@@ -516,16 +1605,13 @@ namespace xtd{
       public:
         template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oOuter) {
-          context<_iterator_t> oContext(oOuter);
-          parse_helper< _whitespace_t, void, true, void>::_parse(oContext);
-          if (oContext.begin < oContext.end && tolower(*oContext.begin) >= tolower(_first) && tolower(*oContext.begin) <= tolower(_last)){
-            oContext.parse_errors.clear();
-            oContext.start_rule = std::make_shared<_decl_t>(*oContext.begin);
-            oContext.begin++;
-            oOuter = oContext;
+          auto oPos = skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end);
+          if (oPos < oOuter.end && to_lower(*oPos) >= to_lower(_first) && to_lower(*oPos) <= to_lower(_last)){
+            make_leaf<_decl_t>(oOuter, oPos, oPos + 1, *oPos);
+            oOuter.begin = oPos + 1;
             return true;
           }
-          oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(characters<_first, _last>), oContext.begin));
+          fail(oOuter, typeid(characters<_first, _last>), oPos);
           return false;
         }
       };
@@ -534,16 +1620,13 @@ namespace xtd{
       public:
         template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oOuter) {
-          context<_iterator_t> oContext(oOuter);
-          parse_helper< _whitespace_t, void, true, void>::_parse(oContext);
-          if (oContext.begin < oContext.end && *oContext.begin >= _first && *oContext.begin <= _last){
-            oContext.parse_errors.clear();
-            oContext.start_rule = std::make_shared<_decl_t>(*oContext.begin);
-            oContext.begin++;
-            oOuter = oContext;
+          auto oPos = skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end);
+          if (oPos < oOuter.end && *oPos >= _first && *oPos <= _last){
+            make_leaf<_decl_t>(oOuter, oPos, oPos + 1, *oPos);
+            oOuter.begin = oPos + 1;
             return true;
           }
-          oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(characters<_first, _last>), oContext.begin));
+          fail(oOuter, typeid(characters<_first, _last>), oPos);
           return false;
         }
       };
@@ -552,20 +1635,17 @@ namespace xtd{
       //character
       template <typename _decl_t, char _ch, typename _whitespace_t>
       class parse_helper<_decl_t, character<_ch>, true, _whitespace_t> {
-        static constexpr char _lower = tolower(_ch);
+        static constexpr char _lower = to_lower(_ch);
       public:
         template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oOuter) {
-          context<_iterator_t> oContext(oOuter);
-          parse_helper< _whitespace_t, void, true, void>::_parse(oContext);
-          if (oContext.begin < oContext.end && tolower(*oContext.begin) == _lower) {
-            oContext.parse_errors.clear();
-            oContext.start_rule = std::make_shared<_decl_t>();
-            oContext.begin++;
-            oOuter = oContext;
+          auto oPos = skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end);
+          if (oPos < oOuter.end && to_lower(*oPos) == _lower){
+            make_leaf<_decl_t>(oOuter, oPos, oPos + 1);
+            oOuter.begin = oPos + 1;
             return true;
           }
-          oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(character<_ch>), oContext.begin));
+          fail(oOuter, typeid(character<_ch>), oPos);
           return false;
         }
       };
@@ -575,16 +1655,13 @@ namespace xtd{
       public:
         template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oOuter) {
-          context<_iterator_t> oContext(oOuter);
-          parse_helper< _whitespace_t, void, true, void>::_parse(oContext);
-          if (oContext.begin < oContext.end && *oContext.begin == _ch) {
-            oContext.parse_errors.clear();
-            oContext.start_rule = std::make_shared<_decl_t>();
-            oContext.begin++;
-            oOuter = oContext;
+          auto oPos = skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end);
+          if (oPos < oOuter.end && *oPos == _ch){
+            make_leaf<_decl_t>(oOuter, oPos, oPos + 1);
+            oOuter.begin = oPos + 1;
             return true;
           }
-          oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(character<_ch>), oContext.begin));
+          fail(oOuter, typeid(character<_ch>), oPos);
           return false;
         }
       };
@@ -598,8 +1675,12 @@ namespace xtd{
         template <typename _iterator_t, typename ... _child_rule_ts>
         static bool _parse(context<_iterator_t>& oOuter) {
           context<_iterator_t> oContext(oOuter);
-          if (!parse_helper<and_<_ParamTs...>, and_<_ParamTs...>, _ignore_case, _whitespace_t>::_parse(oContext)) return true;
-          oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oOuter.begin));
+          if (!parse_item<and_<_ParamTs...>, _ignore_case, _whitespace_t>(oContext)){
+            //a zero width leaf so the enclosing rule has a child to refer to
+            make_leaf<_decl_t>(oOuter, oOuter.begin, oOuter.begin);
+            return true;
+          }
+          fail(oOuter, typeid(_decl_t), oOuter.begin);
           return false;
         }
       };
@@ -610,8 +1691,7 @@ namespace xtd{
       public:
         template <typename _iterator_t, typename ... _child_rule_ts>
         static bool _parse(context<_iterator_t>& oOuter, _child_rule_ts&& ... oChildRules) {
-          oOuter.start_rule = std::make_shared<_decl_t>(std::forward<_child_rule_ts>(oChildRules)...);
-          oOuter.parse_errors.clear();
+          make_node<_decl_t>(oOuter, std::forward<_child_rule_ts>(oChildRules)...);
           return true;
         }
       };
@@ -622,14 +1702,14 @@ namespace xtd{
         template <typename _iterator_t, typename ... _child_rule_ts>
         static bool _parse(context<_iterator_t>& oOuter, _child_rule_ts&& ... oChildRules) {
           context<_iterator_t> oContext(oOuter);
-          auto bRet = parse_helper<_head_t, typename _head_t::impl_type, _ignore_case, _whitespace_t>::_parse(oContext);
+          auto bRet = parse_item<_head_t, _ignore_case, _whitespace_t>(oContext);
           if (!bRet) {
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(and_<_decl_t>), oOuter.begin));
+            fail(oOuter, typeid(and_<_decl_t>), oOuter.begin);
             return false;
           }
-          bRet = parse_helper<_decl_t, parse::and_<_tail_ts...>, _ignore_case, _whitespace_t>::_parse(oContext, std::forward<_child_rule_ts>(oChildRules)..., oContext.start_rule);
+          bRet = parse_helper<_decl_t, parse::and_<_tail_ts...>, _ignore_case, _whitespace_t>::_parse(oContext, std::forward<_child_rule_ts>(oChildRules)..., result(oContext));
           if (!bRet) {
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(and_<_tail_ts...>), oOuter.begin));
+            fail(oOuter, typeid(and_<_tail_ts...>), oOuter.begin);
             return false;
           }
           oOuter = oContext;
@@ -644,23 +1724,32 @@ namespace xtd{
       public:
         template <typename ... _argTs>
         static bool _parse(_argTs...){ return false; }
+        template <typename ... _argTs>
+        static bool _alternative(_argTs...){ return false; }
       };
 
       template <typename _decl_t, typename _head_t, typename ... _tail_ts, bool _ignore_case, typename _whitespace_t >
       class parse_helper < _decl_t, parse::or_<_head_t, _tail_ts...>, _ignore_case, _whitespace_t>{
       public:
-        template <typename _iterator_t, typename ... _child_rule_ts>
+        template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oOuter){
-          context<_iterator_t> oContext(oOuter);
-          auto bRet = parse_helper<_head_t, typename _head_t::impl_type, _ignore_case, _whitespace_t>::_parse(oContext);
-          if (bRet){
-            oOuter = oContext;
-            oOuter.parse_errors.clear();
-            oOuter.start_rule = std::make_shared<_decl_t>(oOuter.start_rule);
-            return true;
+          return _alternative(oOuter, skip_whitespace<_whitespace_t>(oOuter.begin, oOuter.end));
+        }
+
+        /// tries the head alternative if it can start with the next non-whitespace character, then the tail
+        template <typename _iterator_t>
+        static bool _alternative(context<_iterator_t>& oOuter, _iterator_t oNext){
+          const auto & oFirst = first_set<_head_t, _ignore_case>::get();
+          if (oFirst.nullable || (oNext < oOuter.end && oFirst.chars.test(*oNext))){
+            context<_iterator_t> oContext(oOuter);
+            if (parse_item<_head_t, _ignore_case, _whitespace_t>(oContext)){
+              oOuter = oContext;
+              make_node<_decl_t>(oOuter, result(oContext));
+              return true;
+            }
           }
-          oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_head_t), oOuter.begin));
-          return parse_helper<_decl_t, parse::or_<_tail_ts...>, _ignore_case, _whitespace_t>::_parse(oOuter);
+          fail(oOuter, typeid(_head_t), oNext);
+          return parse_helper<_decl_t, parse::or_<_tail_ts...>, _ignore_case, _whitespace_t>::_alternative(oOuter, oNext);
         }
       };
 
@@ -671,12 +1760,11 @@ namespace xtd{
       public:
         template <typename _iterator_t>
         static bool _parse(context<_iterator_t>& oOuter){
-          if (parse_helper<_head_t, typename _head_t::impl_type, _ignore_case, _whitespace_t>::_parse(oOuter)) {
-            oOuter.start_rule = std::make_shared<_decl_t>(oOuter.start_rule);
+          if (parse_item<_head_t, _ignore_case, _whitespace_t>(oOuter)) {
+            make_node<_decl_t>(oOuter, result(oOuter));
           }else {
-            oOuter.start_rule = std::make_shared<_decl_t>();
+            make_node<_decl_t>(oOuter);
           }
-          oOuter.parse_errors.clear();
           return true;
         }
       };
@@ -686,18 +1774,17 @@ namespace xtd{
       template <typename _decl_t, typename _head_t, bool _ignore_case, typename _whitespace_t >
       class parse_helper < _decl_t, parse::one_or_more_<_head_t>, _ignore_case, _whitespace_t> {
       public:
-        template <typename _iterator_t, typename ... _child_rule_ts>
-        static bool _parse(context<_iterator_t>& oOuter,_child_rule_ts&&...oChildren ){
+        template <typename _iterator_t>
+        static bool _parse(context<_iterator_t>& oOuter){
           context<_iterator_t> oContext(oOuter);
-          auto bRet = parse_helper<_head_t, typename _head_t::impl_type, _ignore_case, _whitespace_t>::_parse(oContext);
-          if (!bRet) {
-            oOuter.parse_errors.push_back(std::make_shared<parse::parse_error<_iterator_t>>(typeid(_decl_t), oOuter.begin));
-            oOuter.start_rule = std::make_shared<_decl_t>(std::forward<_child_rule_ts>(oChildren)...);
+          std::vector<node_ref> oItems;
+          parse_items<_decl_t, _head_t, _ignore_case, _whitespace_t>(oContext, oItems);
+          if (oItems.empty()){
+            fail(oOuter, typeid(_decl_t), oOuter.begin);
             return false;
           }
-          _parse(oContext, std::forward<_child_rule_ts>(oChildren)..., oContext.start_rule);
-          oContext.parse_errors.clear();
           oOuter = oContext;
+          make_list<_decl_t>(oOuter, oItems);
           return true;
         }
       };
@@ -710,13 +1797,10 @@ namespace xtd{
         template <typename _iterator_t, typename ... _child_rule_ts>
         static bool _parse(context<_iterator_t>& oOuter, _child_rule_ts&&...oChildren){
           context<_iterator_t> oContext(oOuter);
-          auto oParent = std::make_shared<parse::zero_or_more_<_ty>>();
-          while(parse_helper<_ty, typename _ty::impl_type, _ignore_case, _whitespace_t>::_parse(oContext)){
-            oParent->push_back(oContext.start_rule);
-          }
+          std::vector<node_ref> oItems;
+          parse_items<parse::zero_or_more_<_ty>, _ty, _ignore_case, _whitespace_t>(oContext, oItems);
           oOuter = oContext;
-          oOuter.parse_errors.clear();
-          oOuter.start_rule = oParent;
+          make_list<parse::zero_or_more_<_ty>>(oOuter, oItems);
           return true;
         }
       };
@@ -743,31 +1827,331 @@ namespace xtd{
   @tparam _rule_t The start rule of the grammar
   @tparam _ignore_case Specifies whether case should be ignored during the parse
   @tparam _whitespace_t A specialization of xtd::parse::whitespace that specifies the characters to ignore
+  @tparam _packrat Memoizes the result of every non-terminal at every input position. Guarantees linear time on grammars that backtrack heavily and permits directly left recursive rules, at the cost of memory proportional to the input.
   */
-  template <typename _rule_t, bool _ignore_case = false, typename _whitespace_t = xtd::parse::whitespace<>> class  parser {
+  template <typename _rule_t, bool _ignore_case = false, typename _whitespace_t = xtd::parse::whitespace<>, bool _packrat = false> class  parser {
   public:
 
     /** Parses text
     @param begin the beginning iterator of the text to parse
     @param end the end iterator of the text to parse
+    @param errors receives the rules expected at the furthest position the parse reached when the parse fails
     @returns a fully constructed AST of type _RuleT if the parse succeeds or a nullptr if failed
     */
     template <typename _iterator_t> static bool parse(_iterator_t begin, _iterator_t end, typename _rule_t::pointer_type& ast, typename parse::parse_error<_iterator_t>::vector& errors) {
+      parse::_::failure_tracker<_iterator_t> oFailures;
+      auto bRet = _parse(begin, end, ast, &oFailures);
+      errors = bRet ? typename parse::parse_error<_iterator_t>::vector() : oFailures.errors();
+      return bRet;
+    }
+    template <typename _iterator_t> static bool parse(_iterator_t begin, _iterator_t end, typename _rule_t::pointer_type& ast) {
+      return _parse(begin, end, ast, static_cast<parse::_::failure_tracker<_iterator_t>*>(nullptr));
+    }
+
+    /** Parses text into an arena backed AST
+    @param begin the beginning iterator of the text to parse
+    @param end the end iterator of the text to parse
+    @param ast receives the nodes. Previous content is discarded but its storage is reused.
+    @returns true if the whole input parsed
+    */
+    template <typename _iterator_t> static bool parse(_iterator_t begin, _iterator_t end, parse::ast<_iterator_t>& ast) {
+      typename parse::context<_iterator_t> oContext{begin, end};
+      std::unique_ptr<parse::_::memo_table<_iterator_t>> oMemo(_packrat ? new parse::_::memo_table<_iterator_t>(begin) : nullptr);
+      oContext.memo = oMemo.get();
+      ast.start(begin);
+      oContext.arena = &ast;
+      if (!parse::_::parse_item<_rule_t, _ignore_case, _whitespace_t>(oContext) || oContext.begin < oContext.end){
+        ast.clear();
+        return false;
+      }
+      ast.finish(oContext.node);
+      return true;
+    }
+
+  private:
+    template <typename, bool, typename, bool> friend class stream_parser;
+    template <typename, typename, bool, typename, bool> friend class parallel_parser;
+
+    template <typename _iterator_t> static bool _parse(_iterator_t begin, _iterator_t end, typename _rule_t::pointer_type& ast, parse::_::failure_tracker<_iterator_t> * pFailures) {
+      auto oLast = begin;
+      typename _rule_t::pointer_type oAST;
+      if (!_parse_prefix(begin, end, oLast, oAST, pFailures)) return false;
+      if (oLast < end){
+        if (pFailures) pFailures->record(typeid(_rule_t), oLast);
+        return false;
+      }
+      ast = oAST;
+      return true;
+    }
+
+    /** parses the rule from the beginning of the input without requiring it to consume all of it. oLast receives the end of the match
+    pMemo supplies a memo table that outlives the call, otherwise a packrat parser uses one of its own.
+    */
+    template <typename _iterator_t> static bool _parse_prefix(_iterator_t begin, _iterator_t end, _iterator_t& oLast, typename _rule_t::pointer_type& ast, parse::_::failure_tracker<_iterator_t> * pFailures, parse::_::memo_table<_iterator_t> * pMemo = nullptr) {
       typename parse::context<_iterator_t> oContext{begin, end};
+      std::unique_ptr<parse::_::memo_table<_iterator_t>> oMemo(_packrat && !pMemo ? new parse::_::memo_table<_iterator_t>(begin) : nullptr);
+      oContext.memo = pMemo ? pMemo : oMemo.get();
+      oContext.failures = pFailures;
 
-      auto bRet = parse::_::parse_helper<_rule_t, typename _rule_t::impl_type, _ignore_case, _whitespace_t>::_parse(oContext);
-      errors = oContext.parse_errors;
-      if (oContext.begin  < oContext.end) return false;
+      if (!parse::_::parse_item<_rule_t, _ignore_case, _whitespace_t>(oContext)) return false;
+      oLast = oContext.begin;
       auto oAST = oContext.start_rule;
       oAST->set_parent(oAST);
       ast = oAST;
-      return bRet;
+      return true;
     }
-    template <typename _iterator_t> static bool parse(_iterator_t begin, _iterator_t end, typename _rule_t::pointer_type& ast) {
-      typename parse::parse_error<_iterator_t>::vector oErrors;
-      return parse(begin, end, ast, oErrors);
+
+  };
+
+  /** Incremental parser for chunked input
+  Protocol streams such as DICT, HTTP or mail arrive in pieces. A stream_parser accepts the pieces as they arrive and emits each complete top level _rule_t as soon
+  as it is recognised. Only the bytes of the message in progress are buffered.
+  A match is complete once no rule or terminal examined the end of the buffered input, so a message that could still be extended by more data, or whose
+  parse failed only because the data ran out, waits for the next chunk.
+  Without _packrat each chunk re-parses the message in progress from its beginning, so a message that arrives in k chunks costs k parses of its buffered prefix.
+  With _packrat the memo table of the message in progress is kept between chunks. Only the rules that examined the end of the buffered input are parsed
+  again and repetitions resume after the items that were already complete, so no complete rule is parsed twice. Each chunk still rebuilds the item list of
+  a repetition that spans chunks, a pointer copy per item, and a single terminal that spans many chunks, such as a large body matched by one regex, is still
+  rescanned by each chunk.
+  @tparam _rule_t The rule of a single top level message
+  @tparam _ignore_case Specifies whether case should be ignored during the parse
+  @tparam _whitespace_t A specialization of xtd::parse::whitespace that specifies the characters to ignore
+  @tparam _packrat Memoizes non-terminals while each message is parsed
+  */
+  template <typename _rule_t, bool _ignore_case = false, typename _whitespace_t = xtd::parse::whitespace<>, bool _packrat = false> class stream_parser {
+  public:
+    using pointer_type = typename _rule_t::pointer_type;
+    using parser_type = parser<_rule_t, _ignore_case, _whitespace_t, _packrat>;
+    /// receives each message with the raw bytes it was parsed from. The bytes are only valid during the call.
+    using handler_type = std::function<void(pointer_type, const char *, const char *)>;
+
+    explicit stream_parser(handler_type oHandler) : _handler(std::move(oHandler)), _buffer(), _consumed(0), _failed(false), _error_position(0), _stream_position(0),
+      _memo(_packrat ? new parse::_::memo_table<iterator_type>(nullptr, true) : nullptr){}
+
+    /** Appends a chunk of input and emits every message it completes
+    @param pData chunk of input
+    @param iLen length of the chunk
+    @returns false once the stream contains a syntax error. The stream stays failed until reset().
+    */
+    bool push(const char * pData, size_t iLen){
+      if (_failed) return false;
+      if (!iLen) return true;
+      _buffer.insert(_buffer.end(), pData, pData + iLen);
+      return _drain(false);
     }
+    bool push(const std::string& sData){ return push(sData.data(), sData.size()); }
 
+    /** Ends the stream
+    The remaining input is parsed without waiting for more data.
+    @returns true if the remaining input was empty or parsed into complete messages
+    */
+    bool finish(){
+      if (_failed) return false;
+      if (!_drain(true)) return false;
+      iterator_type oBegin = _buffer.data() + _consumed;
+      iterator_type oEnd = _buffer.data() + _buffer.size();
+      auto oRest = parse::_::skip_whitespace<_whitespace_t>(oBegin, oEnd);
+      if (oRest < oEnd){
+        _fail(oRest);
+        return false;
+      }
+      return true;
+    }
+
+    /// discards the buffered input and any failure
+    void reset(){
+      _buffer.clear();
+      _consumed = 0;
+      _failed = false;
+      _error_position = 0;
+      _stream_position = 0;
+      if (_memo) _memo->clear(nullptr);
+    }
+
+    /// determines if a syntax error was found
+    bool failed() const{ return _failed; }
+    /// offset in the stream of the furthest position reached by the failed parse
+    uint64_t error_position() const{ return _error_position; }
+    /// number of bytes of the message in progress
+    size_t buffered() const{ return _buffer.size() - _consumed; }
+
+  private:
+    using iterator_type = const char *;
+
+    bool _drain(bool bFinal){
+      while (_consumed < _buffer.size()){
+        iterator_type oBegin = _buffer.data() + _consumed;
+        iterator_type oEnd = _buffer.data() + _buffer.size();
+        auto oLast = oBegin;
+        pointer_type oAST;
+        parse::_::failure_tracker<iterator_type> oFailures;
+        //the buffer may have moved since the last chunk but the offsets within the message haven't
+        if (_memo) _memo->rebase(oBegin);
+        auto bParsed = parser_type::_parse_prefix(oBegin, oEnd, oLast, oAST, &oFailures, _memo.get());
+        //anything that looked at the end of the buffer might turn out differently once more data arrives
+        auto bIncomplete = !bFinal && oFailures.touched() && !(oFailures.examined() < oEnd);
+        if (bIncomplete){
+          if (_memo) _memo->expire(static_cast<size_t>(oEnd - oBegin));
+          break;
+        }
+        if (_memo) _memo->clear(nullptr);
+        if (!bParsed){
+          _fail(oFailures.valid() ? oFailures.position() : oBegin);
+          return false;
+        }
+        if (oLast == oBegin) break;
+        auto iLen = static_cast<size_t>(oLast - oBegin);
+        _consumed += iLen;
+        _stream_position += iLen;
+        _handler(oAST, oBegin, oLast);
+      }
+      //reclaim the consumed prefix once it outweighs the message in progress
+      if (_consumed && _consumed >= _buffer.size() - _consumed){
+        _buffer.erase(_buffer.begin(), _buffer.begin() + _consumed);
+        _consumed = 0;
+      }
+      return true;
+    }
+
+    void _fail(iterator_type oPosition){
+      _failed = true;
+      _error_position = _stream_position + static_cast<uint64_t>(oPosition - (_buffer.data() + _consumed));
+    }
+
+    handler_type _handler;
+    std::vector<char> _buffer;
+    size_t _consumed;
+    bool _failed;
+    uint64_t _error_position;
+    uint64_t _stream_position;
+    /// memo table of the message in progress when _packrat
+    std::unique_ptr<parse::_::memo_table<iterator_type>> _memo;
+  };
+
+  /** Parallel parser for record oriented input
+  Large inputs made of independent records, such as log lines, mail headers or mbox messages, are split into chunks at record boundaries and the chunks are
+  parsed concurrently. The records of every chunk are stitched back together in input order.
+  The workers take chunks from a shared counter and there are several chunks per worker, so chunks that are slower to parse than others are balanced out.
+  A chunk boundary is placed after the first match of _boundary_t at or after each evenly spaced split point, so _boundary_t must only match where one record
+  ends and the next begins and must consume input. The not_<not_<x>> idiom matches x without consuming it, e.g. and_<LF, not_<not_<FROM>>> splits an mbox
+  before each "From " line.
+  @tparam _record_t The rule of a single record
+  @tparam _boundary_t The rule that separates records
+  @tparam _ignore_case Specifies whether case should be ignored during the parse
+  @tparam _whitespace_t A specialization of xtd::parse::whitespace that specifies the characters to ignore
+  @tparam _packrat Memoizes non-terminals while each record is parsed
+  */
+  template <typename _record_t, typename _boundary_t, bool _ignore_case = false, typename _whitespace_t = xtd::parse::whitespace<>, bool _packrat = false> class parallel_parser {
+  public:
+    using pointer_type = typename _record_t::pointer_type;
+    using record_parser = parser<_record_t, _ignore_case, _whitespace_t, _packrat>;
+    using boundary_parser = parser<_boundary_t, _ignore_case, _whitespace_t, false>;
+    /// the input is split into this many chunks per thread so a slow chunk doesn't leave the other workers idle
+    static const size_t chunks_per_thread = 4;
+
+    /** Parses a range of records
+    @param begin the beginning iterator of the text to parse
+    @param end the end iterator of the text to parse
+    @param records receives the records in input order. When the parse fails it holds the records that precede the error.
+    @param error receives the furthest position reached by the failed parse of the first invalid record
+    @param iThreads number of worker threads. Zero uses one per hardware thread.
+    @param iMinChunk inputs are not split into chunks smaller than this
+    @returns true if the whole input parsed into records
+    */
+    template <typename _iterator_t>
+    static bool parse(_iterator_t begin, _iterator_t end, std::vector<pointer_type>& records, _iterator_t& error, size_t iThreads = 0, size_t iMinChunk = 64 * 1024) {
+      if (!iThreads) iThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+      auto oBounds = split(begin, end, iThreads * chunks_per_thread, iMinChunk);
+      auto iChunks = oBounds.size() - 1;
+      std::vector<chunk<_iterator_t>> oChunks(iChunks);
+      std::atomic<size_t> iNext(0);
+      std::exception_ptr pException;
+      std::mutex oLock;
+      auto fnWorker = [&](){
+        try{
+          for (auto i = iNext++; i < iChunks; i = iNext++){
+            _parse_chunk(oBounds[i], oBounds[i + 1], oChunks[i]);
+          }
+        } catch (...){
+          std::lock_guard<std::mutex> oGuard(oLock);
+          if (!pException) pException = std::current_exception();
+          iNext = iChunks;
+        }
+      };
+      std::vector<std::thread> oThreads;
+      for (size_t i = 1; i < std::min(iThreads, iChunks); ++i) oThreads.emplace_back(fnWorker);
+      fnWorker();
+      for (auto & oThread : oThreads) oThread.join();
+      if (pException) std::rethrow_exception(pException);
+
+      records.clear();
+      for (auto & oChunk : oChunks){
+        records.insert(records.end(), std::make_move_iterator(oChunk.records.begin()), std::make_move_iterator(oChunk.records.end()));
+        if (oChunk.failed){
+          error = oChunk.error;
+          return false;
+        }
+      }
+      return true;
+    }
+
+    template <typename _iterator_t>
+    static bool parse(_iterator_t begin, _iterator_t end, std::vector<pointer_type>& records, size_t iThreads = 0, size_t iMinChunk = 64 * 1024) {
+      auto oError = begin;
+      return parse(begin, end, records, oError, iThreads, iMinChunk);
+    }
+
+    /** Finds the chunk boundaries of a range
+    @returns the positions that begin each chunk followed by end
+    */
+    template <typename _iterator_t>
+    static std::vector<_iterator_t> split(_iterator_t begin, _iterator_t end, size_t iChunks, size_t iMinChunk = 64 * 1024) {
+      auto iSize = static_cast<size_t>(end - begin);
+      iChunks = std::max<size_t>(1, std::min(iChunks, iSize / std::max<size_t>(1, iMinChunk)));
+      std::vector<_iterator_t> oRet(1, begin);
+      const auto & oFirst = parse::_::first_set<_boundary_t, _ignore_case>::get();
+      for (size_t i = 1; i < iChunks; ++i){
+        auto oPos = begin + static_cast<std::ptrdiff_t>(iSize / iChunks * i);
+        if (oPos < oRet.back()) continue;
+        for (; oPos < end; ++oPos){
+          if (!oFirst.nullable && !oFirst.chars.test(*oPos)) continue;
+          auto oLast = oPos;
+          typename _boundary_t::pointer_type oAST;
+          if (boundary_parser::_parse_prefix(oPos, end, oLast, oAST, static_cast<parse::_::failure_tracker<_iterator_t>*>(nullptr)) && oRet.back() < oLast){
+            oPos = oLast;
+            break;
+          }
+        }
+        if (!(oPos < end)) break;
+        oRet.push_back(oPos);
+      }
+      oRet.push_back(end);
+      return oRet;
+    }
+
+  private:
+    template <typename _iterator_t> struct chunk{
+      std::vector<pointer_type> records;
+      bool failed = false;
+      _iterator_t error;
+    };
+
+    template <typename _iterator_t>
+    static void _parse_chunk(_iterator_t begin, _iterator_t end, chunk<_iterator_t>& oChunk){
+      auto oPos = begin;
+      while (parse::_::skip_whitespace<_whitespace_t>(oPos, end) < end){
+        auto oLast = oPos;
+        pointer_type oAST;
+        parse::_::failure_tracker<_iterator_t> oFailures;
+        if (!record_parser::_parse_prefix(oPos, end, oLast, oAST, &oFailures) || oLast == oPos){
+          oChunk.failed = true;
+          oChunk.error = oFailures.valid() ? oFailures.position() : oPos;
+          return;
+        }
+        oChunk.records.push_back(std::move(oAST));
+        oPos = oLast;
+      }
+    }
   };
   ///@}
 
@@ -11,37 +11,175 @@ transport neutral light weight IPC/RPC library
 #include <mutex>
 #include <condition_variable>
 #include <future>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <typeinfo>
+#include <limits>
+#include <functional>
+#include <deque>
+#include <map>
+#if (__cplusplus >= 201703L)
+  #include <optional>
+#endif
+#include <cassert>
 
 #include <xtd/socket.hpp>
 #include <xtd/concurrent/hash_map.hpp>
+#include <xtd/concurrent/spin_lock.hpp>
 #include <xtd/memory.hpp>
 #include <xtd/debug.hpp>
-#include <xtd/windows/pipe.hpp>
+
+#if (XTD_OS_WINDOWS & XTD_OS)
+  #include <xtd/windows/pipe.hpp>
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/syscall.h>
+  #include <linux/futex.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <climits>
+  #include <ctime>
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <signal.h>
+#endif
 
 namespace xtd{
   namespace rpc {
-    template <typename, typename> struct rpc_call;
+    struct raw_codec;
+    struct compact_codec;
+    template <typename, typename, typename = raw_codec> struct rpc_call;
 
     template <typename, typename...> struct rpc_server;
     template <typename, typename...> struct rpc_client;
+    template <typename, typename...> class rpc_batch;
+
+    namespace _ {
+      /// 64 bit FNV-1a hash of a null terminated string
+      constexpr uint64_t fnv1a(const char * sz, uint64_t iHash = 14695981039346656037ULL) {
+        return *sz ? fnv1a(sz + 1, (iHash ^ static_cast<uint8_t>(*sz)) * 1099511628211ULL) : iHash;
+      }
+
+      template <typename, typename = void> struct has_wire_name : std::false_type {};
+      template <typename _ty> struct has_wire_name<_ty, xtd::void_t<decltype(_ty::wire_name)>> : std::true_type {};
+
+      template <typename _ty> uint64_t wire_id(std::true_type) { return fnv1a(_ty::wire_name); }
+      template <typename _ty> uint64_t wire_id(std::false_type) {
+        static const uint64_t iRet = fnv1a(typeid(_ty).name());
+        return iRet;
+      }
+
+      /// position of a call in a client or server call list
+      template <typename, typename...> struct call_index;
+      template <typename _ty, typename ... _tail_ts> struct call_index<_ty, _ty, _tail_ts...> : std::integral_constant<uint32_t, 0> {};
+      template <typename _ty, typename _head_t, typename ... _tail_ts> struct call_index<_ty, _head_t, _tail_ts...> : std::integral_constant<uint32_t, 1 + call_index<_ty, _tail_ts...>::value> {};
+
+      /// reserved wire id of a batch envelope
+      constexpr uint64_t batch_wire_id = fnv1a("xtd::rpc::batch");
+      /** batched replies start at this alignment so they unmarshal with the same padding they were marshaled with
+      A reply is marshaled right after the payload header, so the alignment is measured from the end of the header rather than
+      from the start of the payload. The header is 12 bytes rather than 16 where size_t is 32 bits.
+      */
+      constexpr size_t batch_alignment = 16;
+    }
 
     /*
      * payload
      */
     using payload_t = std::vector<uint8_t>;
 
+    /** read cursor over an immutable received payload
+    Unmarshaling advances the cursor instead of erasing consumed bytes from the front of the payload
+    */
+    class payload_reader {
+    public:
+      payload_reader(const uint8_t * begin, const uint8_t * end) : _begin(begin), _pos(begin), _end(end) {}
+      explicit payload_reader(const payload_t& oPayload) : payload_reader(oPayload.data(), oPayload.data() + oPayload.size()) {}
+
+      /// returns a pointer to the next len bytes and advances past them
+      const uint8_t * read(size_t len) {
+        if (static_cast<size_t>(_end - _pos) < len) throw xtd::exception(here(), "Malformed payload");
+        auto pRet = _pos;
+        _pos += len;
+        return pRet;
+      }
+
+      template <typename _ty> _ty peek() const {
+        static_assert(std::is_pod<_ty>::value, "Invalid POD type for peek");
+        if (static_cast<size_t>(_end - _pos) < sizeof(_ty)) throw xtd::exception(here(), "Malformed payload");
+        _ty oRet;
+        memcpy(&oRet, _pos, sizeof(_ty));
+        return oRet;
+      }
+
+      void skip(size_t len) { read(len); }
+
+      /// reader over the next len bytes with offsets still relative to the start of this payload, this reader advances past them
+      payload_reader sub(size_t len) {
+        auto pBegin = read(len);
+        payload_reader oRet(*this);
+        oRet._pos = pBegin;
+        oRet._end = pBegin + len;
+        return oRet;
+      }
+
+      /// advances to the next offset from the start of the payload that is a multiple of alignment
+      void align(size_t alignment) { skip(padding(offset(), alignment)); }
+
+      size_t offset() const { return static_cast<size_t>(_pos - _begin); }
+      size_t remaining() const { return static_cast<size_t>(_end - _pos); }
+
+      static size_t padding(size_t offset, size_t alignment) { return (alignment - (offset % alignment)) % alignment; }
+
+    private:
+      const uint8_t * _begin;
+      const uint8_t * _pos;
+      const uint8_t * _end;
+    };
+
+    /** non-owning view over an array of POD values
+    Marshals with the same wire format as std::vector<_ty> but unmarshals pointing directly into the received payload, so it is only valid while the payload is alive.
+    Server side handlers can declare array_view parameters to receive large arrays without copying them.
+    */
+    template <typename _ty> class array_view {
+    public:
+      static_assert(std::is_pod<_ty>::value, "Invalid POD type for array_view");
+      using value_type = _ty;
+      using const_iterator = const _ty*;
+
+      array_view() : _data(nullptr), _size(0) {}
+      array_view(const _ty * data, size_t size) : _data(data), _size(size) {}
+      array_view(const std::vector<_ty>& src) : _data(src.data()), _size(src.size()) {} //NOSONAR
+
+      const _ty * data() const { return _data; }
+      size_t size() const { return _size; }
+      bool empty() const { return 0 == _size; }
+      const_iterator begin() const { return _data; }
+      const_iterator end() const { return _data + _size; }
+      const _ty& operator[](size_t index) const { return _data[index]; }
+
+    private:
+      const _ty * _data;
+      size_t _size;
+    };
+
     template <bool _skip_in_only, typename ...> struct marshaler;
 
+    //recursion terminator, takes the buffers by reference since passing them through an ellipsis copies them
     template <bool _skip_in_only> struct marshaler<_skip_in_only> {
-      static void marshal(...) {}
-      static void unmarshal(...) {}
+      static void marshal(payload_t&) {}
+      static void unmarshal(payload_reader&) {}
     };
     //skip const references
     template <typename _head_t, typename ... _tail_ts> struct marshaler<true, const _head_t&, _tail_ts...> {
       static void marshal(payload_t& oPayload, const _head_t&, _tail_ts&&...oTail) {
         marshaler<true, _tail_ts...>::marshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
-      static void unmarshal(payload_t& oPayload, const _head_t&, _tail_ts&&...oTail) {
+      static void unmarshal(payload_reader& oPayload, const _head_t&, _tail_ts&&...oTail) {
         marshaler<true, _tail_ts...>::unmarshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
     };
@@ -51,7 +189,7 @@ namespace xtd{
       static void marshal(payload_t& oPayload, const _head_t&, _tail_ts&&...oTail) {
         marshaler<true, _tail_ts...>::marshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
-      static void unmarshal(payload_t& oPayload, const _head_t&, _tail_ts&&...oTail) {
+      static void unmarshal(payload_reader& oPayload, const _head_t&, _tail_ts&&...oTail) {
         marshaler<true, _tail_ts...>::unmarshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
     };
@@ -64,21 +202,26 @@ namespace xtd{
         oPayload.insert(oPayload.end(), ptr, ptr + sizeof(_head_t));
         marshaler<false, _tail_ts...>::marshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
-      static void unmarshal(payload_t& oPayload, _head_t& oHead, _tail_ts&&...oTail) {
+      static void unmarshal(payload_reader& oPayload, _head_t& oHead, _tail_ts&&...oTail) {
         static_assert(std::is_pod<_head_t>::value, "Invalid POD type for unmarshal");
-        oHead = *reinterpret_cast<const _head_t*>(&oPayload.at(0));
-        oPayload.erase(oPayload.begin(), oPayload.begin() + sizeof(_head_t));
+        memcpy(&oHead, oPayload.read(sizeof(_head_t)), sizeof(_head_t));
         marshaler<false, _tail_ts...>::unmarshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
     };
 
+    //const reference - marshals the same as a reference
+    template <typename _head_t, typename ... _tail_ts> struct marshaler<false, const _head_t&, _tail_ts...> {
+      static void marshal(payload_t& oPayload, const _head_t& oHead, _tail_ts&&...oTail) {
+        marshaler<false, _head_t&, _tail_ts...>::marshal(oPayload, oHead, std::forward<_tail_ts>(oTail)...);
+      }
+    };
 
     //POD byval - delegate to POD reference
     template <bool _skip_in_only, typename _head_t, typename ... _tail_ts> struct marshaler<_skip_in_only, _head_t, _tail_ts...> {
       static void marshal(payload_t& oPayload, const _head_t& oHead, _tail_ts&&...oTail) {
         marshaler<_skip_in_only, _head_t&, _tail_ts...>::marshal(oPayload, oHead, std::forward<_tail_ts>(oTail)...);
       }
-      static void unmarshal(payload_t& oPayload, _head_t& oHead, _tail_ts&&...oTail) {
+      static void unmarshal(payload_reader& oPayload, _head_t& oHead, _tail_ts&&...oTail) {
         marshaler<false, _head_t&, _tail_ts...>::unmarshal(oPayload, oHead, std::forward<_tail_ts>(oTail)...);
       }
     };
@@ -87,42 +230,350 @@ namespace xtd{
     template <typename ... _tail_ts> struct marshaler<false, std::string&, _tail_ts...> {
       static void marshal(payload_t& oPayload, const std::string& oHead, _tail_ts&&...oTail) {
         marshaler<false, size_t>::marshal(oPayload, oHead.size());
-        std::copy(oHead.begin(), oHead.end(), std::back_inserter(oPayload));
+        oPayload.insert(oPayload.end(), oHead.begin(), oHead.end());
         marshaler<false, _tail_ts...>::marshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
-      static void unmarshal(payload_t& oPayload, std::string& oHead, _tail_ts&&...oTail) {
+      static void unmarshal(payload_reader& oPayload, std::string& oHead, _tail_ts&&...oTail) {
         size_t len;
         marshaler<false, size_t>::unmarshal(oPayload, len);
-        oHead.reserve(len);
-        oHead.resize(0, 0);
-        std::copy(oPayload.begin(), oPayload.begin() + len, std::back_inserter(oHead));
-        oPayload.erase(oPayload.begin(), oPayload.begin() + len);
+        oHead.assign(reinterpret_cast<const char*>(oPayload.read(len)), len);
         marshaler<false, _tail_ts...>::unmarshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
     };
+
+    namespace _ {
+      /** array wire format shared by std::vector and array_view
+      POD arrays are a length followed by padding to the element alignment and the raw elements so they can be copied with a single memcpy or viewed in place
+      */
+      template <typename _item_t, bool _is_pod = std::is_pod<_item_t>::value> struct array_marshaler {
+        static void marshal(payload_t& oPayload, const _item_t * pItems, size_t len) {
+          marshaler<false, size_t>::marshal(oPayload, len);
+          oPayload.resize(oPayload.size() + payload_reader::padding(oPayload.size(), alignof(_item_t)), 0);
+          auto ptr = reinterpret_cast<const uint8_t*>(pItems);
+          oPayload.insert(oPayload.end(), ptr, ptr + (len * sizeof(_item_t)));
+        }
+        static const _item_t * unmarshal(payload_reader& oPayload, size_t& len) {
+          marshaler<false, size_t>::unmarshal(oPayload, len);
+          oPayload.align(alignof(_item_t));
+          if (len > oPayload.remaining() / sizeof(_item_t)) throw xtd::exception(here(), "Malformed payload");
+          return reinterpret_cast<const _item_t*>(oPayload.read(len * sizeof(_item_t)));
+        }
+        static void unmarshal(payload_reader& oPayload, std::vector<_item_t>& oItems) {
+          size_t len;
+          auto pItems = unmarshal(oPayload, len);
+          oItems.resize(len);
+          if (len) memcpy(oItems.data(), pItems, len * sizeof(_item_t));
+        }
+      };
+
+      template <typename _item_t> struct array_marshaler<_item_t, false> {
+        static void marshal(payload_t& oPayload, const _item_t * pItems, size_t len) {
+          marshaler<false, size_t>::marshal(oPayload, len);
+          for (; len; --len, ++pItems) marshaler<false, _item_t&>::marshal(oPayload, *pItems);
+        }
+        static void unmarshal(payload_reader& oPayload, std::vector<_item_t>& oItems) {
+          size_t len;
+          marshaler<false, size_t>::unmarshal(oPayload, len);
+          oItems.clear();
+          oItems.reserve(std::min(len, oPayload.remaining()));
+          for (; len > 0; --len) {
+            oItems.emplace_back();
+            marshaler<false, _item_t&>::unmarshal(oPayload, oItems.back());
+          }
+        }
+      };
+    }
+
     //vector
     template <typename _item_t, typename ... _tail_ts> struct marshaler<false, std::vector<_item_t>&, _tail_ts...> {
       static void marshal(payload_t& oPayload, const std::vector<_item_t>& oHead, _tail_ts&&...oTail) {
-        marshaler<false, size_t>::marshal(oPayload, oHead.size());
-        for (const auto & oItem : oHead) marshaler<false, _item_t&>::marshal(oPayload, oItem);
+        _::array_marshaler<_item_t>::marshal(oPayload, oHead.data(), oHead.size());
+        marshaler<false, _tail_ts...>::marshal(oPayload, std::forward<_tail_ts>(oTail)...);
+      }
+      static void unmarshal(payload_reader& oPayload, std::vector<_item_t>& oHead, _tail_ts&&...oTail) {
+        _::array_marshaler<_item_t>::unmarshal(oPayload, oHead);
+        marshaler<false, _tail_ts...>::unmarshal(oPayload, std::forward<_tail_ts>(oTail)...);
+      }
+    };
+
+    //array_view
+    template <typename _item_t, typename ... _tail_ts> struct marshaler<false, array_view<_item_t>&, _tail_ts...> {
+      static void marshal(payload_t& oPayload, const array_view<_item_t>& oHead, _tail_ts&&...oTail) {
+        _::array_marshaler<_item_t>::marshal(oPayload, oHead.data(), oHead.size());
         marshaler<false, _tail_ts...>::marshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
-      static void unmarshal(payload_t& oPayload, std::vector<_item_t>& oHead, _tail_ts&&...oTail) {
+      static void unmarshal(payload_reader& oPayload, array_view<_item_t>& oHead, _tail_ts&&...oTail) {
         size_t len;
-        marshaler<false, size_t>::unmarshal(oPayload, len);
-        oHead.reserve(len);
-        oHead.clear();
-        for (; len > 0; --len) {
-          _item_t oItem;
-          marshaler<false, _item_t&>::unmarshal(oPayload, oItem);
-          oHead.push_back(oItem);
-        }
+        auto pItems = _::array_marshaler<_item_t>::unmarshal(oPayload, len);
+        oHead = array_view<_item_t>(pItems, len);
         marshaler<false, _tail_ts...>::unmarshal(oPayload, std::forward<_tail_ts>(oTail)...);
       }
     };
 
+    /** default codec, marshals with the fixed width marshaler
+    Integers and lengths are written in native width and parameters must be POD, std::string, std::vector or array_view
+    */
+    struct raw_codec {
+      template <typename ... _param_ts, typename ... _arg_ts> static void marshal_args(payload_t& oPayload, _arg_ts&&...oArgs) {
+        marshaler<false, _arg_ts...>::marshal(oPayload, std::forward<_arg_ts>(oArgs)...);
+      }
+      template <typename _ty> static void marshal(payload_t& oPayload, const _ty& oVal) {
+        marshaler<false, _ty&>::marshal(oPayload, oVal);
+      }
+      template <typename _ty> static void unmarshal(payload_reader& oPayload, _ty& oVal) {
+        marshaler<false, _ty&>::unmarshal(oPayload, oVal);
+      }
+    };
+
+    namespace _ {
+      /// writes an unsigned LEB128 varint
+      inline void write_varint(payload_t& oPayload, uint64_t iVal) {
+        uint8_t oBuf[10];
+        size_t i = 0;
+        for (; iVal >= 0x80; iVal >>= 7) oBuf[i++] = static_cast<uint8_t>(iVal) | 0x80;
+        oBuf[i++] = static_cast<uint8_t>(iVal);
+        oPayload.insert(oPayload.end(), oBuf, oBuf + i);
+      }
+
+      inline uint64_t read_varint(payload_reader& oPayload) {
+        uint64_t iRet = 0;
+        for (unsigned iShift = 0; iShift < 64; iShift += 7) {
+          auto iByte = *oPayload.read(1);
+          iRet |= static_cast<uint64_t>(iByte & 0x7f) << iShift;
+          if (!(iByte & 0x80)) return iRet;
+        }
+        throw xtd::exception(here(), "Malformed payload");
+      }
+
+      /// reads a varint length of items that each occupy at least one byte
+      inline size_t read_length(payload_reader& oPayload) {
+        auto iRet = read_varint(oPayload);
+        if (iRet > oPayload.remaining()) throw xtd::exception(here(), "Malformed payload");
+        return static_cast<size_t>(iRet);
+      }
+
+      template <typename _ty, typename = void> struct compact;
+
+      /// passes each field of a struct to the compact encoder
+      struct compact_encoder {
+        payload_t& _payload;
+        void operator()() {}
+        template <typename _head_t, typename ... _tail_ts> void operator()(const _head_t& oHead, const _tail_ts&...oTail) {
+          compact<_head_t>::encode(_payload, oHead);
+          (*this)(oTail...);
+        }
+      };
+
+      /// fills each field of a struct from the compact decoder
+      struct compact_decoder {
+        payload_reader& _payload;
+        void operator()() {}
+        template <typename _head_t, typename ... _tail_ts> void operator()(_head_t& oHead, _tail_ts&...oTail) {
+          compact<_head_t>::decode(_payload, oHead);
+          (*this)(oTail...);
+        }
+      };
+
+      template <typename _ty, typename = void> struct has_rpc_fields : std::false_type {};
+      template <typename _ty> struct has_rpc_fields<_ty, xtd::void_t<decltype(std::declval<_ty&>().rpc_fields(std::declval<compact_encoder&>()))>> : std::true_type {};
+
+      //structs exposing their fields through rpc_fields, otherwise raw POD bytes
+      template <typename _ty, typename> struct compact {
+        static void encode(payload_t& oPayload, const _ty& oVal) { encode(oPayload, oVal, has_rpc_fields<_ty>()); }
+        static void decode(payload_reader& oPayload, _ty& oVal) { decode(oPayload, oVal, has_rpc_fields<_ty>()); }
+      private:
+        static void encode(payload_t& oPayload, const _ty& oVal, std::true_type) {
+          compact_encoder oEncoder{ oPayload };
+          //rpc_fields is only required to be non-const since it both reads and fills fields
+          const_cast<_ty&>(oVal).rpc_fields(oEncoder);
+        }
+        static void decode(payload_reader& oPayload, _ty& oVal, std::true_type) {
+          compact_decoder oDecoder{ oPayload };
+          oVal.rpc_fields(oDecoder);
+        }
+        static void encode(payload_t& oPayload, const _ty& oVal, std::false_type) {
+          static_assert(std::is_pod<_ty>::value, "Type must be POD or declare rpc_fields");
+          auto ptr = reinterpret_cast<const uint8_t*>(&oVal);
+          oPayload.insert(oPayload.end(), ptr, ptr + sizeof(_ty));
+        }
+        static void decode(payload_reader& oPayload, _ty& oVal, std::false_type) {
+          memcpy(&oVal, oPayload.read(sizeof(_ty)), sizeof(_ty));
+        }
+      };
+
+      template <> struct compact<bool> {
+        static void encode(payload_t& oPayload, bool bVal) { oPayload.push_back(bVal ? 1 : 0); }
+        static void decode(payload_reader& oPayload, bool& bVal) { bVal = 0 != *oPayload.read(1); }
+      };
+
+      //unsigned integers as LEB128
+      template <typename _ty> struct compact<_ty, typename std::enable_if<std::is_integral<_ty>::value && std::is_unsigned<_ty>::value && !std::is_same<_ty, bool>::value>::type> {
+        static void encode(payload_t& oPayload, _ty iVal) { write_varint(oPayload, iVal); }
+        static void decode(payload_reader& oPayload, _ty& iVal) {
+          auto iRet = read_varint(oPayload);
+          if (iRet > std::numeric_limits<_ty>::max()) throw xtd::exception(here(), "Malformed payload");
+          iVal = static_cast<_ty>(iRet);
+        }
+      };
+
+      //signed integers zigzag encoded so small negative values stay short
+      template <typename _ty> struct compact<_ty, typename std::enable_if<std::is_integral<_ty>::value && std::is_signed<_ty>::value>::type> {
+        using unsigned_type = typename std::make_unsigned<_ty>::type;
+        static void encode(payload_t& oPayload, _ty iVal) {
+          write_varint(oPayload, (static_cast<uint64_t>(static_cast<int64_t>(iVal)) << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(iVal) >> 63));
+        }
+        static void decode(payload_reader& oPayload, _ty& iVal) {
+          auto iRaw = read_varint(oPayload);
+          auto iRet = static_cast<int64_t>((iRaw >> 1) ^ (~(iRaw & 1) + 1));
+          if (iRet < std::numeric_limits<_ty>::min() || iRet > std::numeric_limits<_ty>::max()) throw xtd::exception(here(), "Malformed payload");
+          iVal = static_cast<_ty>(iRet);
+        }
+      };
+
+      template <typename _ty> struct compact<_ty, typename std::enable_if<std::is_enum<_ty>::value>::type> {
+        using underlying_type = typename std::underlying_type<_ty>::type;
+        static void encode(payload_t& oPayload, _ty eVal) { compact<underlying_type>::encode(oPayload, static_cast<underlying_type>(eVal)); }
+        static void decode(payload_reader& oPayload, _ty& eVal) {
+          underlying_type iVal;
+          compact<underlying_type>::decode(oPayload, iVal);
+          eVal = static_cast<_ty>(iVal);
+        }
+      };
+
+      template <> struct compact<std::string> {
+        static void encode(payload_t& oPayload, const std::string& sVal) {
+          write_varint(oPayload, sVal.size());
+          oPayload.insert(oPayload.end(), sVal.begin(), sVal.end());
+        }
+        static void decode(payload_reader& oPayload, std::string& sVal) {
+          auto iLen = read_length(oPayload);
+          sVal.assign(reinterpret_cast<const char*>(oPayload.read(iLen)), iLen);
+        }
+      };
+
+      //vectors of floating point or byte sized values are copied in bulk, others item by item
+      template <typename _item_t> struct compact<std::vector<_item_t>> {
+        using bulk = std::integral_constant<bool, std::is_floating_point<_item_t>::value || (std::is_integral<_item_t>::value && 1 == sizeof(_item_t) && !std::is_same<_item_t, bool>::value)>;
+        static void encode(payload_t& oPayload, const std::vector<_item_t>& oVal) {
+          write_varint(oPayload, oVal.size());
+          encode(oPayload, oVal, bulk());
+        }
+        static void decode(payload_reader& oPayload, std::vector<_item_t>& oVal) {
+          auto iLen = read_length(oPayload);
+          decode(oPayload, oVal, iLen, bulk());
+        }
+      private:
+        static void encode(payload_t& oPayload, const std::vector<_item_t>& oVal, std::true_type) {
+          auto ptr = reinterpret_cast<const uint8_t*>(oVal.data());
+          oPayload.insert(oPayload.end(), ptr, ptr + (oVal.size() * sizeof(_item_t)));
+        }
+        static void encode(payload_t& oPayload, const std::vector<_item_t>& oVal, std::false_type) {
+          for (const auto & oItem : oVal) compact<_item_t>::encode(oPayload, oItem);
+        }
+        static void decode(payload_reader& oPayload, std::vector<_item_t>& oVal, size_t iLen, std::true_type) {
+          if (iLen > oPayload.remaining() / sizeof(_item_t)) throw xtd::exception(here(), "Malformed payload");
+          oVal.resize(iLen);
+          if (iLen) memcpy(oVal.data(), oPayload.read(iLen * sizeof(_item_t)), iLen * sizeof(_item_t));
+        }
+        static void decode(payload_reader& oPayload, std::vector<_item_t>& oVal, size_t iLen, std::false_type) {
+          oVal.resize(iLen);
+          for (size_t i = 0; i < iLen; ++i) {
+            _item_t oItem;
+            compact<_item_t>::decode(oPayload, oItem);
+            oVal[i] = std::move(oItem);
+          }
+        }
+      };
+
+      template <typename _first_t, typename _second_t> struct compact<std::pair<_first_t, _second_t>> {
+        static void encode(payload_t& oPayload, const std::pair<_first_t, _second_t>& oVal) {
+          compact<_first_t>::encode(oPayload, oVal.first);
+          compact<_second_t>::encode(oPayload, oVal.second);
+        }
+        static void decode(payload_reader& oPayload, std::pair<_first_t, _second_t>& oVal) {
+          compact<_first_t>::decode(oPayload, oVal.first);
+          compact<_second_t>::decode(oPayload, oVal.second);
+        }
+      };
+
+      template <typename _map_t> struct compact_map {
+        using key_type = typename _map_t::key_type;
+        using mapped_type = typename _map_t::mapped_type;
+        static void encode(payload_t& oPayload, const _map_t& oVal) {
+          write_varint(oPayload, oVal.size());
+          for (const auto & oItem : oVal) {
+            compact<key_type>::encode(oPayload, oItem.first);
+            compact<mapped_type>::encode(oPayload, oItem.second);
+          }
+        }
+        static void decode(payload_reader& oPayload, _map_t& oVal) {
+          oVal.clear();
+          for (auto iLen = read_length(oPayload); iLen; --iLen) {
+            key_type oKey;
+            compact<key_type>::decode(oPayload, oKey);
+            compact<mapped_type>::decode(oPayload, oVal[oKey]);
+          }
+        }
+      };
+
+      template <typename _key_t, typename _value_t, typename ... _ts> struct compact<std::map<_key_t, _value_t, _ts...>> : compact_map<std::map<_key_t, _value_t, _ts...>> {};
+      template <typename _key_t, typename _value_t, typename ... _ts> struct compact<std::unordered_map<_key_t, _value_t, _ts...>> : compact_map<std::unordered_map<_key_t, _value_t, _ts...>> {};
+
+#if (__cplusplus >= 201703L)
+      template <typename _ty> struct compact<std::optional<_ty>> {
+        static void encode(payload_t& oPayload, const std::optional<_ty>& oVal) {
+          compact<bool>::encode(oPayload, oVal.has_value());
+          if (oVal) compact<_ty>::encode(oPayload, *oVal);
+        }
+        static void decode(payload_reader& oPayload, std::optional<_ty>& oVal) {
+          bool bHasValue;
+          compact<bool>::decode(oPayload, bHasValue);
+          if (!bHasValue) {
+            oVal.reset();
+            return;
+          }
+          _ty oItem;
+          compact<_ty>::decode(oPayload, oItem);
+          oVal = std::move(oItem);
+        }
+      };
+#endif
+    }
+
+    /** compact codec for bandwidth limited links
+    Integers and lengths are LEB128 varints, signed integers zigzag encoded. Handles std::string, std::vector, std::map,
+    std::unordered_map, std::pair, std::optional (C++17) and user structs that list their fields through a visitor hook:
+    @code
+    struct person {
+      std::string name;
+      std::vector<int> scores;
+      template <typename _visitor_t> void rpc_fields(_visitor_t& oVisitor) { oVisitor(name, scores); }
+    };
+    class Store : public xtd::rpc::rpc_call<Store, bool(person), xtd::rpc::compact_codec> {};
+    @endcode
+    Other types must be POD and are copied as raw bytes. Arguments are converted to the declared parameter types before
+    they are encoded.
+    */
+    struct compact_codec {
+      template <typename ... _param_ts, typename ... _arg_ts> static void marshal_args(payload_t& oPayload, _arg_ts&&...oArgs) {
+        int oDummy[] = { 0, (_::compact<typename std::decay<_param_ts>::type>::encode(oPayload, std::forward<_arg_ts>(oArgs)), 0)... };
+        (void)oDummy;
+      }
+      template <typename _ty> static void marshal(payload_t& oPayload, const _ty& oVal) {
+        _::compact<_ty>::encode(oPayload, oVal);
+      }
+      template <typename _ty> static void unmarshal(payload_reader& oPayload, _ty& oVal) {
+        _::compact<_ty>::decode(oPayload, oVal);
+      }
+    };
+
+    /** wire payload
+    The header holds the length of the whole payload, filled in by embed_length before it is sent, followed by the
+    request id the client uses to match a reply to its call. Servers echo the id back unchanged.
+    */
     struct payload : std::vector<uint8_t> {
-      payload() : vector(sizeof(size_t), 0) {}
+      static constexpr size_t header_size = sizeof(size_t) + sizeof(uint64_t);
+      payload() : vector(header_size, 0) {}
       template <typename _ty> _ty peek() const {
         static_assert(std::is_pod<_ty>::value, "Invalid POD type for peek");
         return *reinterpret_cast<const _ty*>(&at(0));
@@ -131,78 +582,428 @@ namespace xtd{
         auto * iLen = reinterpret_cast<size_t*>(&at(0));
         *iLen = size();
       }
+      uint64_t request_id() const {
+        uint64_t iRet;
+        memcpy(&iRet, data() + sizeof(size_t), sizeof(uint64_t));
+        return iRet;
+      }
+      void request_id(uint64_t iRequest) {
+        memcpy(data() + sizeof(size_t), &iRequest, sizeof(uint64_t));
+      }
+      /// read cursor positioned after the header
+      payload_reader reader() const {
+        payload_reader oRet(*this);
+        oRet.skip(header_size);
+        return oRet;
+      }
+      /// empties the payload back to just the header while keeping the request id and the allocated capacity
+      void reset() {
+        resize(header_size);
+      }
     };
 
-#if 0
-    /** tcp/ip transport
+    /** free list of payload buffers that keeps their capacity between calls
+    Buffers are handed out with acquire() and returned when the handle is destroyed. Once the pool is warm a call
+    that fits in a previously used buffer performs no heap allocation for its payload.
     */
-    class tcp_transport {
-      socket::ipv4address _address;
-      xtd::socket::ipv4_tcp_stream _socket;
-      std::unique_ptr<std::thread> _server_thread;
-      bool _stop_server;
-      xtd::concurrent::hash_map<std::thread::id, std::thread> _clients;
-      bool _client_connected;
+    class payload_pool {
+    public:
+      /// owning handle to a pooled payload
+      class handle {
+      public:
+        handle(handle&& src) : _pool(src._pool), _payload(std::move(src._payload)) {}
+        handle(const handle&) = delete;
+        handle& operator=(const handle&) = delete;
+        ~handle() {
+          if (_payload) _pool.release(std::move(_payload));
+        }
+        payload& operator*() const { return *_payload; }
+        payload * operator->() const { return _payload.get(); }
+      private:
+        friend class payload_pool;
+        handle(payload_pool& oPool, std::unique_ptr<payload>&& oPayload) : _pool(oPool), _payload(std::move(oPayload)) {}
+        payload_pool& _pool;
+        std::unique_ptr<payload> _payload;
+      };
+
+      /**
+      @param max_buffers number of idle buffers kept
+      @param max_capacity buffers that grew beyond this many bytes are freed instead of retained
+      */
+      explicit payload_pool(size_t max_buffers = 4, size_t max_capacity = 1024 * 1024)
+        : _lock(), _free(), _max_buffers(max_buffers), _max_capacity(max_capacity) {
+        _free.reserve(max_buffers);
+      }
+      payload_pool(const payload_pool&) = delete;
+      payload_pool& operator=(const payload_pool&) = delete;
 
+      handle acquire() {
+        {
+          xtd::concurrent::spin_lock::scope_locker oLock(_lock);
+          if (_free.size()) {
+            auto oRet = std::move(_free.back());
+            _free.pop_back();
+            return handle(*this, std::move(oRet));
+          }
+        }
+        return handle(*this, std::unique_ptr<payload>(new payload));
+      }
+
+    private:
+      void release(std::unique_ptr<payload>&& oPayload) {
+        if (oPayload->capacity() > _max_capacity) return;
+        oPayload->reset();
+        xtd::concurrent::spin_lock::scope_locker oLock(_lock);
+        if (_free.size() < _max_buffers) _free.push_back(std::move(oPayload));
+      }
+
+      xtd::concurrent::spin_lock _lock;
+      std::vector<std::unique_ptr<payload>> _free;
+      size_t _max_buffers;
+      size_t _max_capacity;
+    };
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+    /** stream socket transport driven by epoll
+    The server runs a fixed set of I/O threads, each with its own epoll set. The non-blocking listener is shared by all of
+    them and every accepted connection stays on the thread that accepted it, so a handful of threads serve thousands of
+    clients. Requests that arrive back to back on a connection are dispatched in order and their replies coalesced into
+    as few sends as possible. A connection announcing a request larger than max_request is closed. The client side is a
+    single blocking connection opened on the first transact.
+    @tparam _address_t socket address type such as xtd::socket::ipv4address or xtd::socket::unix_address
+    */
+    template <typename _address_t> class stream_transport {
     public:
-      using pointer_type = std::shared_ptr<tcp_transport>;
+      using pointer_type = std::shared_ptr<stream_transport>;
+      using address_type = _address_t;
+
+      /**
+      @param oAddress address the server listens on or the client connects to. A server bound to port 0 updates it to the assigned port
+      @param io_threads number of server I/O threads
+      @param max_request largest request in bytes the server accepts
+      */
+      explicit stream_transport(const address_type& oAddress, size_t io_threads = 1, size_t max_request = 64 * 1024 * 1024)
+        : _address(oAddress), _io_threads(io_threads ? io_threads : 1), _max_request(max_request), _threads(), _listen_fd(-1), _stop_fd(-1), _requests(64), _client_fd(-1), _send_lock(), _transact_lock() {}
+
+      ~stream_transport() {
+        if (_threads.size()) stop_server();
+        if (-1 != _client_fd) close(_client_fd);
+      }
+
+      stream_transport(const stream_transport&) = delete;
+      stream_transport& operator=(const stream_transport&) = delete;
 
-      tcp_transport(const socket::ipv4address& oAddress)
-        : _address(oAddress), _socket(), _server_thread(), _stop_server(false), _clients(), _client_connected(false) {}
+      const address_type& address() const { return _address; }
 
       template <typename _server_t> void start_server(_server_t& oServer) {
-        _stop_server = false;
-        std::shared_ptr<std::promise<void>> oServerStarted(new std::promise<void>);
-        _server_thread = xtd::make_unique<std::thread>([&, &oServer, oServerStarted] {
-          oServerStarted->set_value();
-          _socket.bind(_address);
-          bool ExitThread = false;
-          payload oPayload;
-          while (!_stop_server && !ExitThread) {
-            _socket.listen();
-            auto oClient = _socket.accept<xtd::socket::ipv4_tcp_stream>();
-            std::shared_ptr<xtd::socket::ipv4_tcp_stream> oClientSocket(new xtd::socket::ipv4_tcp_stream(std::move(oClient)));
-            std::thread oClientThread([&, oClientSocket, &oServer]() {
-              oClientSocket->onError.connect([&ExitThread]() {
-                ERR("Socket error");
-                ExitThread = true;
-              });
-              oClientSocket->onRead.connect([&]() {
-                oClientSocket->read<payload::_super_t>(oPayload);
-                oServer.invoke(oPayload);
-              });
-              oClientSocket->onWrite.connect([&]() {
-                if (oPayload.size()) {
-                  oClientSocket->write<payload::_super_t>(oPayload);
+        if (_threads.size()) throw xtd::exception(here(), "Socket server already running");
+        if (AF_UNIX == address_type::address_family) unlink(reinterpret_cast<const sockaddr_un&>(_address).sun_path);
+        _listen_fd = xtd::socket::exception::throw_if(::socket(address_type::address_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0), [](int i) { return -1 == i; });
+        int iOn = 1;
+        setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &iOn, sizeof(iOn));
+        socklen_t iLen = sizeof(address_type);
+        if (bind(_listen_fd, reinterpret_cast<const sockaddr*>(&_address), sizeof(address_type)) || listen(_listen_fd, SOMAXCONN) ||
+            getsockname(_listen_fd, reinterpret_cast<sockaddr*>(&_address), &iLen)) {
+          close(_listen_fd);
+          _listen_fd = -1;
+          throw xtd::socket::exception(here(), "Failed to listen");
+        }
+        _stop_fd = xtd::socket::exception::throw_if(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK), [](int i) { return -1 == i; });
+        for (size_t i = 0; i < _io_threads; ++i) {
+          auto iEpoll = xtd::socket::exception::throw_if(epoll_create1(EPOLL_CLOEXEC), [](int i) { return -1 == i; });
+          listen_on(iEpoll);
+          epoll_event oEvent;
+          oEvent.events = EPOLLIN;
+          oEvent.data.ptr = &_stop_fd;
+          epoll_ctl(iEpoll, EPOLL_CTL_ADD, _stop_fd, &oEvent);
+          _threads.emplace_back(new std::thread([this, iEpoll, &oServer]() { io_thread(iEpoll, oServer); }));
+        }
+      }
+
+      void stop_server() {
+        if (!_threads.size()) throw xtd::exception(here(), "Socket server not running");
+        uint64_t iOne = 1;
+        xtd::socket::exception::throw_if(write(_stop_fd, &iOne, sizeof(iOne)), [](ssize_t i) { return sizeof(uint64_t) != i; });
+        for (auto & oThread : _threads) oThread->join();
+        _threads.clear();
+        close(_stop_fd);
+        close(_listen_fd);
+        _stop_fd = _listen_fd = -1;
+        if (AF_UNIX == address_type::address_family) unlink(reinterpret_cast<const sockaddr_un&>(_address).sun_path);
+      }
+
+      /// writes a request to the connection, concurrent senders are serialized
+      void send(payload& oPayload) {
+        std::lock_guard<std::mutex> oLock(_send_lock);
+        if (-1 == _client_fd) connect();
+        oPayload.embed_length();
+        if (!send_all(oPayload.data(), oPayload.size())) disconnect("Socket send failed");
+      }
+
+      /// reads the next reply, only one thread may receive at a time
+      void receive(payload& oPayload) {
+        if (-1 == _client_fd) throw xtd::socket::exception(here(), "Socket not connected");
+        size_t iLen;
+        if (!recv_all(reinterpret_cast<uint8_t*>(&iLen), sizeof(size_t)) || iLen < payload::header_size) {
+          std::lock_guard<std::mutex> oLock(_send_lock);
+          disconnect("Socket receive failed");
+        }
+        oPayload.resize(iLen);
+        memcpy(oPayload.data(), &iLen, sizeof(size_t));
+        if (!recv_all(oPayload.data() + sizeof(size_t), iLen - sizeof(size_t))) {
+          std::lock_guard<std::mutex> oLock(_send_lock);
+          disconnect("Socket receive failed");
+        }
+      }
+
+      void transact(payload& oPayload) {
+        std::lock_guard<std::mutex> oLock(_transact_lock);
+        send(oPayload);
+        receive(oPayload);
+      }
+
+      /// breaks the client connection so a receive blocked on it fails
+      void shutdown() {
+        std::lock_guard<std::mutex> oLock(_send_lock);
+        if (-1 != _client_fd) ::shutdown(_client_fd, SHUT_RDWR);
+      }
+
+    private:
+      /** per connection state owned by the I/O thread that accepted it
+      Replies completed by server workers are queued and sent from the worker under the connection's lock, requests run
+      inline leave their replies for the I/O thread to send together.
+      */
+      struct connection {
+        using pointer = std::shared_ptr<connection>;
+        explicit connection(int fd) : _fd(fd), _io_thread(std::this_thread::get_id()), _in(), _lock(), _out(), _sent(0) {}
+        ~connection() { close(_fd); }
+        int _fd;
+        std::thread::id _io_thread;
+        payload_t _in; //partial request left over from the last read
+        std::mutex _lock; //guards the reply queue
+        payload_t _out; //replies not yet accepted by the socket
+        size_t _sent;
+      };
+
+      static constexpr size_t read_size = 64 * 1024;
+      /// how long a thread stops accepting after running out of descriptors or memory
+      static constexpr int accept_backoff_ms = 100;
+
+      static uint32_t exclusive_flag() {
+#if defined(EPOLLEXCLUSIVE)
+        return EPOLLEXCLUSIVE;
+#else
+        return 0;
+#endif
+      }
+
+      template <typename _server_t> void io_thread(int iEpoll, _server_t& oServer) {
+        std::map<connection*, typename connection::pointer> oConnections;
+        std::vector<uint8_t> oScratch(read_size);
+        epoll_event oEvents[64];
+        bool bListening = true;
+        forever {
+          auto iCount = epoll_wait(iEpoll, oEvents, 64, bListening ? -1 : accept_backoff_ms);
+          if (-1 == iCount && EINTR == errno) continue;
+          if (-1 == iCount) break;
+          if (!bListening) bListening = listen_on(iEpoll);
+          bool bStop = false;
+          for (int i = 0; i < iCount; ++i) {
+            if (&_stop_fd == oEvents[i].data.ptr) {
+              bStop = true;
+            } else if (&_listen_fd == oEvents[i].data.ptr) {
+              if (bListening && !accept_all(iEpoll, oConnections)) {
+                //the pending connection keeps the listener readable so it's parked until descriptors free up
+                epoll_ctl(iEpoll, EPOLL_CTL_DEL, _listen_fd, nullptr);
+                bListening = false;
+              }
+            } else {
+              auto oFound = oConnections.find(static_cast<connection*>(oEvents[i].data.ptr));
+              if (oConnections.end() == oFound) continue;
+              auto & oConnection = oFound->second;
+              bool bOpen = !(oEvents[i].events & (EPOLLERR | EPOLLHUP));
+              try {
+                if (bOpen && (oEvents[i].events & (EPOLLIN | EPOLLRDHUP))) bOpen = read_requests(oConnection, oServer, oScratch);
+                if (bOpen) {
+                  std::lock_guard<std::mutex> oLock(oConnection->_lock);
+                  bOpen = flush(*oConnection);
                 }
-              });
-              payload oPayload;
-              for (;;) {
-                oClientSocket->select(250);
+              } catch (...) {
+                bOpen = false;
               }
-            });
-            oClientThread.detach();
+              if (!bOpen) {
+                //workers may still hold the connection so it must stop raising events before it is forgotten
+                epoll_ctl(iEpoll, EPOLL_CTL_DEL, oConnection->_fd, nullptr);
+                oConnections.erase(oFound);
+              }
+            }
           }
-        });
-        oServerStarted->get_future().get();
+          if (bStop) break;
+        }
+        close(iEpoll);
       }
-      void stop_server() {
-        //TODO: implement stop_server
-        TODO("implement stop_server")
+
+      /// adds the shared listener to a thread's epoll set
+      bool listen_on(int iEpoll) {
+        epoll_event oEvent;
+        oEvent.events = EPOLLIN | exclusive_flag();
+        oEvent.data.ptr = &_listen_fd;
+        return 0 == epoll_ctl(iEpoll, EPOLL_CTL_ADD, _listen_fd, &oEvent);
       }
 
-      void transact(payload& oPayload) {
-        if (!_client_connected) {
-          _socket.connect(_address);
-          _client_connected = true;
+      /// accepts every pending connection, returns false when the process is out of descriptors or memory
+      bool accept_all(int iEpoll, std::map<connection*, typename connection::pointer>& oConnections) {
+        forever {
+          auto iFD = accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+          if (-1 == iFD) {
+            if (EINTR == errno || ECONNABORTED == errno) continue;
+            return !(EMFILE == errno || ENFILE == errno || ENOBUFS == errno || ENOMEM == errno);
+          }
+          if (AF_UNIX != address_type::address_family) {
+            int iOn = 1;
+            setsockopt(iFD, IPPROTO_TCP, TCP_NODELAY, &iOn, sizeof(iOn));
+          }
+          typename connection::pointer oConnection(new connection(iFD));
+          epoll_event oEvent;
+          oEvent.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+          oEvent.data.ptr = oConnection.get();
+          if (epoll_ctl(iEpoll, EPOLL_CTL_ADD, iFD, &oEvent)) continue;
+          auto pConnection = oConnection.get();
+          oConnections[pConnection] = std::move(oConnection);
+        }
+      }
+
+      /// drains the socket dispatching every complete request, returns false when the connection should be closed
+      template <typename _server_t> bool read_requests(const typename connection::pointer& pConnection, _server_t& oServer, std::vector<uint8_t>& oScratch) {
+        connection& oConnection = *pConnection;
+        forever {
+          auto iRead = ::recv(oConnection._fd, oScratch.data(), oScratch.size(), 0);
+          if (0 == iRead) return false;
+          if (iRead < 0) {
+            if (EINTR == errno) continue;
+            return EAGAIN == errno || EWOULDBLOCK == errno;
+          }
+          const uint8_t * pBegin = oScratch.data();
+          const uint8_t * pEnd = pBegin + iRead;
+          if (oConnection._in.size()) {
+            oConnection._in.insert(oConnection._in.end(), pBegin, pEnd);
+            pBegin = oConnection._in.data();
+            pEnd = pBegin + oConnection._in.size();
+          }
+          auto pNext = dispatch(oServer, pConnection, pBegin, pEnd);
+          if (!pNext) return false;
+          if (oConnection._in.size()) {
+            oConnection._in.erase(oConnection._in.begin(), oConnection._in.begin() + (pNext - pBegin));
+          } else {
+            oConnection._in.assign(pNext, pEnd);
+          }
+          std::lock_guard<std::mutex> oLock(oConnection._lock);
+          if (oConnection._out.size() && !flush(oConnection)) return false;
+        }
+      }
+
+      /** dispatches the complete requests in [pBegin, pEnd), returns the first unconsumed byte or nullptr if malformed
+      A request that fails to execute is answered with an empty reply so the client isn't left waiting for it
+      */
+      template <typename _server_t> const uint8_t * dispatch(_server_t& oServer, const typename connection::pointer& pConnection, const uint8_t * pBegin, const uint8_t * pEnd) {
+        auto complete = [pConnection](payload& oReply) {
+          std::lock_guard<std::mutex> oLock(pConnection->_lock);
+          oReply.embed_length();
+          pConnection->_out.insert(pConnection->_out.end(), oReply.begin(), oReply.end());
+          if (std::this_thread::get_id() != pConnection->_io_thread) flush(*pConnection);
+        };
+        while (static_cast<size_t>(pEnd - pBegin) >= sizeof(size_t)) {
+          size_t iLen;
+          memcpy(&iLen, pBegin, sizeof(size_t));
+          if (iLen < payload::header_size || iLen > _max_request) return nullptr;
+          if (static_cast<size_t>(pEnd - pBegin) < iLen) break;
+          auto oRequest = _requests.acquire();
+          oRequest->assign(pBegin, pBegin + iLen);
+          auto iRequest = oRequest->request_id();
+          try {
+            oServer.execute(std::move(oRequest), complete);
+          } catch (...) {
+            payload oError;
+            oError.request_id(iRequest);
+            complete(oError);
+          }
+          pBegin += iLen;
+        }
+        return pBegin;
+      }
+
+      /// sends queued replies until the socket would block, returns false when the connection should be closed. Called with the connection locked
+      static bool flush(connection& oConnection) {
+        while (oConnection._sent < oConnection._out.size()) {
+          auto iSent = ::send(oConnection._fd, oConnection._out.data() + oConnection._sent, oConnection._out.size() - oConnection._sent, MSG_NOSIGNAL);
+          if (iSent < 0) {
+            if (EINTR == errno) continue;
+            return EAGAIN == errno || EWOULDBLOCK == errno;
+          }
+          oConnection._sent += static_cast<size_t>(iSent);
         }
-        _socket.write<typename payload::_super_t>(oPayload);
-        _socket.read<typename payload::_super_t>(oPayload);
+        oConnection._out.clear();
+        oConnection._sent = 0;
+        return true;
+      }
+
+      void connect() {
+        _client_fd = xtd::socket::exception::throw_if(::socket(address_type::address_family, SOCK_STREAM | SOCK_CLOEXEC, 0), [](int i) { return -1 == i; });
+        if (::connect(_client_fd, reinterpret_cast<const sockaddr*>(&_address), sizeof(address_type))) disconnect("Failed to connect");
+        if (AF_UNIX != address_type::address_family) {
+          int iOn = 1;
+          setsockopt(_client_fd, IPPROTO_TCP, TCP_NODELAY, &iOn, sizeof(iOn));
+        }
+      }
 
+      /// closes the client connection so the next transact reconnects and throws
+      [[noreturn]] void disconnect(const char * sWhat) {
+        xtd::socket::exception oEx(here(), sWhat);
+        close(_client_fd);
+        _client_fd = -1;
+        throw oEx;
+      }
+
+      bool send_all(const uint8_t * pData, size_t iLen) {
+        while (iLen) {
+          auto iSent = ::send(_client_fd, pData, iLen, MSG_NOSIGNAL);
+          if (iSent < 0 && EINTR == errno) continue;
+          if (iSent <= 0) return false;
+          pData += iSent;
+          iLen -= static_cast<size_t>(iSent);
+        }
+        return true;
       }
 
+      bool recv_all(uint8_t * pData, size_t iLen) {
+        while (iLen) {
+          auto iRead = ::recv(_client_fd, pData, iLen, 0);
+          if (iRead < 0 && EINTR == errno) continue;
+          if (iRead <= 0) return false;
+          pData += iRead;
+          iLen -= static_cast<size_t>(iRead);
+        }
+        return true;
+      }
+
+      address_type _address;
+      size_t _io_threads;
+      size_t _max_request;
+      std::vector<std::unique_ptr<std::thread>> _threads;
+      int _listen_fd;
+      int _stop_fd;
+      payload_pool _requests;
+      int _client_fd;
+      std::mutex _send_lock;
+      std::mutex _transact_lock;
     };
+
+    /// TCP/IPv4 transport
+    using tcp_transport = stream_transport<xtd::socket::ipv4address>;
+    /// Unix domain socket transport
+    using unix_transport = stream_transport<xtd::socket::unix_address>;
 #endif
+#if (XTD_OS_WINDOWS & XTD_OS)
     /*
      * anonymous_pipe_transport
      */
@@ -222,16 +1023,30 @@ namespace xtd{
         _server_thread->join();
       }
 
-      void transact(payload& oPayload) {
+      void send(payload& oPayload) {
         oPayload.embed_length();
+        std::lock_guard<std::mutex> oLock(_send_lock);
         _server_pipe->write<uint8_t>(oPayload);
+      }
+
+      void receive(payload& oPayload) {
         size_t iPayloadSize;
-        while (!_client_pipe->peek(iPayloadSize)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        while (!_client_pipe->peek(iPayloadSize)) {
+          if (_shutdown) throw xtd::exception(here(), "Pipe transport shut down");
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
         oPayload.resize(iPayloadSize);
         _client_pipe->read(oPayload);
-        marshaler<false, size_t>::unmarshal(oPayload, iPayloadSize);
       }
 
+      void transact(payload& oPayload) {
+        send(oPayload);
+        receive(oPayload);
+      }
+
+      /// fails a receive waiting for a reply
+      void shutdown() { _shutdown = true; }
+
       template <typename _server_t> void start_server(_server_t& oServer) {
         if (_running) throw xtd::exception(here(), "Pipe server already running");
         _running = true;
@@ -240,15 +1055,17 @@ namespace xtd{
           auto oFuture = _stop_server_thread->get_future();
 
           size_t iPayloadSize;
-          payload oPayload;
           for (; std::future_status::timeout == oFuture.wait_for(std::chrono::milliseconds(1));) {
-            if ((iPayloadSize = _server_pipe->bytes_available()) < sizeof(size_t)) continue;
-            oPayload.resize(iPayloadSize);
-            _server_pipe->read(oPayload);
-            marshaler<false, size_t>::unmarshal(oPayload, iPayloadSize);
-            oServer.invoke(oPayload);
-            oPayload.embed_length();
-            _client_pipe->write<uint8_t>(oPayload);
+            //read a single request, pipelined clients may have queued several
+            if (_server_pipe->bytes_available() < sizeof(size_t) || !_server_pipe->peek(iPayloadSize)) continue;
+            auto oRequest = _requests.acquire();
+            oRequest->resize(iPayloadSize);
+            _server_pipe->read(*oRequest);
+            oServer.execute(std::move(oRequest), [this](payload& oReply) {
+              std::lock_guard<std::mutex> oLock(_reply_lock);
+              oReply.embed_length();
+              _client_pipe->write<uint8_t>(oReply);
+            });
           }
 
         });
@@ -258,16 +1075,580 @@ namespace xtd{
       xtd::windows::pipe::shared_ptr _client_pipe;
       std::unique_ptr<std::thread> _server_thread;
       std::unique_ptr<std::promise<void>> _stop_server_thread;
+      payload_pool _requests;
+      std::mutex _send_lock;
+      std::mutex _reply_lock;
       bool _running = false;
+      std::atomic<bool> _shutdown{ false };
+    };
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+    namespace _ {
+      /** single producer single consumer byte ring living in shared memory
+      head and tail are free running byte counters. Each side spins briefly for the other and then sleeps on a futex
+      doorbell which is only rung when the other side has announced that it is waiting.
+      */
+      struct shm_ring {
+        alignas(64) std::atomic<uint64_t> head;
+        std::atomic<uint32_t> data_seq;
+        std::atomic<uint32_t> readers_waiting;
+        alignas(64) std::atomic<uint64_t> tail;
+        std::atomic<uint32_t> space_seq;
+        std::atomic<uint32_t> writers_waiting;
+
+        uint8_t * data() { return reinterpret_cast<uint8_t*>(this + 1); }
+
+        static void futex_wait(std::atomic<uint32_t>& oWord, uint32_t iExpected, int iTimeoutMS) {
+          timespec oTimeout{ iTimeoutMS / 1000, (iTimeoutMS % 1000) * 1000000L };
+          syscall(SYS_futex, reinterpret_cast<uint32_t*>(&oWord), FUTEX_WAIT, iExpected, &oTimeout, nullptr, 0);
+        }
+
+        static void futex_wake(std::atomic<uint32_t>& oWord) {
+          syscall(SYS_futex, reinterpret_cast<uint32_t*>(&oWord), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        static void ring(std::atomic<uint32_t>& oSeq, std::atomic<uint32_t>& oWaiting) {
+          oSeq.fetch_add(1);
+          if (oWaiting.load()) futex_wake(oSeq);
+        }
+
+        /// waits until ready() or stopped() returns true, returns false when stopped
+        template <typename _ready_t, typename _stopped_t>
+        static bool wait(std::atomic<uint32_t>& oSeq, std::atomic<uint32_t>& oWaiting, size_t iSpin, _ready_t ready, _stopped_t stopped) {
+          for (size_t i = 0; i < iSpin; ++i) {
+            if (ready()) return true;
+#if ((XTD_COMPILER_GCC | XTD_COMPILER_CLANG) & XTD_COMPILER) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_ia32_pause();
+#endif
+          }
+          forever {
+            auto iSeq = oSeq.load();
+            ++oWaiting;
+            if (ready() || stopped()) {
+              --oWaiting;
+              return !stopped() || ready();
+            }
+            futex_wait(oSeq, iSeq, 100);
+            --oWaiting;
+          }
+        }
+
+        template <typename _stopped_t>
+        bool write(size_t iCapacity, size_t iSpin, const uint8_t * pSrc, size_t iLen, _stopped_t stopped) {
+          while (iLen) {
+            auto iHead = head.load(std::memory_order_relaxed);
+            if (!wait(space_seq, writers_waiting, iSpin, [&] { return iHead - tail.load(std::memory_order_acquire) < iCapacity; }, stopped)) return false;
+            auto iChunk = std::min<size_t>(iLen, iCapacity - static_cast<size_t>(iHead - tail.load(std::memory_order_acquire)));
+            auto iOffset = static_cast<size_t>(iHead & (iCapacity - 1));
+            auto iFirst = std::min(iChunk, iCapacity - iOffset);
+            memcpy(data() + iOffset, pSrc, iFirst);
+            memcpy(data(), pSrc + iFirst, iChunk - iFirst);
+            head.store(iHead + iChunk, std::memory_order_release);
+            ring(data_seq, readers_waiting);
+            pSrc += iChunk;
+            iLen -= iChunk;
+          }
+          return true;
+        }
+
+        template <typename _stopped_t>
+        bool read(size_t iCapacity, size_t iSpin, uint8_t * pDest, size_t iLen, _stopped_t stopped) {
+          while (iLen) {
+            auto iTail = tail.load(std::memory_order_relaxed);
+            if (!wait(data_seq, readers_waiting, iSpin, [&] { return head.load(std::memory_order_acquire) != iTail; }, stopped)) return false;
+            auto iChunk = std::min<size_t>(iLen, static_cast<size_t>(head.load(std::memory_order_acquire) - iTail));
+            auto iOffset = static_cast<size_t>(iTail & (iCapacity - 1));
+            auto iFirst = std::min(iChunk, iCapacity - iOffset);
+            memcpy(pDest, data() + iOffset, iFirst);
+            memcpy(pDest + iFirst, data(), iChunk - iFirst);
+            tail.store(iTail + iChunk, std::memory_order_release);
+            ring(space_seq, writers_waiting);
+            pDest += iChunk;
+            iLen -= iChunk;
+          }
+          return true;
+        }
+      };
+
+      /** control block at the start of the shared region followed by the request and reply rings
+      client holds the pid of the attached client, 0 while the region is free or released_client once the client has
+      detached. Only the server returns it to 0, after it has emptied the rings of whatever the last client left behind.
+      reset is set by the server when the client broke the framing of its requests, the client's calls fail until it detaches.
+      */
+      struct shm_header {
+        static constexpr uint64_t magic_value = 0x78746472706373ULL;
+        static constexpr uint32_t released_client = UINT32_MAX;
+        uint64_t magic;
+        uint64_t ring_size;
+        std::atomic<uint32_t> stopped;
+        std::atomic<uint32_t> client;
+        std::atomic<uint32_t> reset;
+        uint32_t server;
+      };
+
+      /// true while the process exists, a pid recorded in shared memory by a process that crashed fails this check
+      inline bool process_alive(uint32_t iPid) {
+        return 0 == kill(static_cast<pid_t>(iPid), 0) || EPERM == errno;
+      }
+    }
+
+    /** same-host transport over a pair of SPSC rings in a POSIX shared memory region
+    The server creates the named region in start_server, a client attaches to it on its first transact. Each region
+    serves one client connection, concurrent transact calls on that connection are serialized. The server answers
+    requests in order, so a client pipelining calls must collect replies before they outgrow the reply ring.
+    start_server fails while another live server owns the name, a region left behind by a server that died is reclaimed.
+    When a client detaches or its process dies the server drops anything still in the rings and frees the region for
+    the next client. A request whose length can't be valid leaves the server unable to find the next one, so the server
+    resets the connection, failing the client's calls the way a closed socket fails them on the stream transports.
+    */
+    class shared_memory_transport {
+    public:
+      using pointer_type = std::shared_ptr<shared_memory_transport>;
+
+      /**
+      @param name name of the shared memory region
+      @param ring_size capacity in bytes of each ring, rounded up to a power of two. Payloads larger than the ring are streamed through it
+      @param spin iterations to busy wait for the other side before sleeping on the futex. Defaults to none on single core hosts where the peer can't make progress while we spin
+      */
+      explicit shared_memory_transport(const std::string& name, size_t ring_size = 1024 * 1024, size_t spin = default_spin())
+        : _name('/' == name[0] ? name : '/' + name), _ring_size(64), _spin(spin), _fd(-1), _region(nullptr), _region_size(0),
+          _server(false), _attached(false), _shutdown(false), _server_thread(), _requests(64), _reply_lock(), _session(0), _send_lock(), _transact_lock() {
+        while (_ring_size < ring_size) _ring_size <<= 1;
+      }
+
+      ~shared_memory_transport() {
+        if (_server_thread) stop_server();
+        detach();
+      }
+
+      shared_memory_transport(const shared_memory_transport&) = delete;
+      shared_memory_transport& operator=(const shared_memory_transport&) = delete;
+
+      template <typename _server_t> void start_server(_server_t& oServer) {
+        if (_server_thread) throw xtd::exception(here(), "Shared memory server already running");
+        create();
+        _server_thread = std::unique_ptr<std::thread>(new std::thread([this, &oServer]() {
+          auto interrupted = [this] { return 0 != header().stopped.load() || client_lost(); };
+          size_t iLen;
+          forever {
+            if (!request().read(_ring_size, _spin, reinterpret_cast<uint8_t*>(&iLen), sizeof(size_t), interrupted) ||
+                iLen < payload::header_size) {
+              if (header().stopped.load() || !disconnect()) return;
+              reclaim();
+              continue;
+            }
+            auto oRequest = _requests.acquire();
+            oRequest->resize(iLen);
+            memcpy(oRequest->data(), &iLen, sizeof(size_t));
+            if (!request().read(_ring_size, _spin, oRequest->data() + sizeof(size_t), iLen - sizeof(size_t), interrupted)) {
+              if (header().stopped.load() || !disconnect()) return;
+              reclaim();
+              continue;
+            }
+            auto iSession = _session;
+            auto iRequest = oRequest->request_id();
+            try {
+              oServer.execute(std::move(oRequest), [this, iSession](payload& oReply) { send_reply(iSession, oReply); });
+            } catch (...) {
+              //the client is waiting on this id so it gets an empty reply rather than nothing
+              payload oError;
+              oError.request_id(iRequest);
+              send_reply(iSession, oError);
+            }
+          }
+        }));
+      }
+
+      void stop_server() {
+        if (!_server_thread) throw xtd::exception(here(), "Shared memory server not running");
+        header().stopped.store(1);
+        _::shm_ring::futex_wake(request().data_seq);
+        _::shm_ring::futex_wake(request().space_seq);
+        _::shm_ring::futex_wake(reply().data_seq);
+        _::shm_ring::futex_wake(reply().space_seq);
+        _server_thread->join();
+        _server_thread.reset();
+        detach();
+      }
+
+      /// writes a request to the ring, concurrent senders are serialized
+      void send(payload& oPayload) {
+        std::lock_guard<std::mutex> oLock(_send_lock);
+        if (!_region) attach();
+        oPayload.embed_length();
+        if (closed() || !request().write(_ring_size, _spin, oPayload.data(), oPayload.size(), [this] { return closed(); })) {
+          throw_closed();
+        }
+      }
+
+      /// reads the next reply, only one thread may receive at a time
+      void receive(payload& oPayload) {
+        if (!_region) throw xtd::exception(here(), "Shared memory transport not connected");
+        auto stopped = [this] { return closed(); };
+        size_t iLen;
+        if (!reply().read(_ring_size, _spin, reinterpret_cast<uint8_t*>(&iLen), sizeof(size_t), stopped)) throw_closed();
+        if (iLen < payload::header_size) throw xtd::exception(here(), "Malformed payload");
+        oPayload.resize(iLen);
+        memcpy(oPayload.data(), &iLen, sizeof(size_t));
+        if (!reply().read(_ring_size, _spin, oPayload.data() + sizeof(size_t), iLen - sizeof(size_t), stopped)) throw_closed();
+      }
+
+      void transact(payload& oPayload) {
+        std::lock_guard<std::mutex> oLock(_transact_lock);
+        send(oPayload);
+        receive(oPayload);
+      }
+
+      /// fails a receive waiting for a reply and every later call
+      void shutdown() {
+        _shutdown = true;
+        if (_region) _::shm_ring::futex_wake(reply().data_seq);
+      }
+
+      static size_t default_spin() { return std::thread::hardware_concurrency() > 1 ? 4096 : 0; }
+
+    private:
+      /// the server stopped or reset the connection or the client shut it down
+      bool closed() { return _shutdown || header().stopped.load() || header().reset.load(); }
+
+      [[noreturn]] void throw_closed() {
+        if (_shutdown) throw xtd::exception(here(), "Shared memory transport shut down");
+        if (header().reset.load()) throw xtd::exception(here(), "Shared memory connection reset by server");
+        throw xtd::exception(here(), "Shared memory server stopped");
+      }
+
+      /// writes a reply unless it belongs to a client that has since gone away
+      void send_reply(uint32_t iSession, payload& oReply) {
+        std::lock_guard<std::mutex> oLock(_reply_lock);
+        if (iSession != _session) return;
+        oReply.embed_length();
+        reply().write(_ring_size, _spin, oReply.data(), oReply.size(), [this] { return closed() || client_lost(); });
+      }
+
+      /// the attached client detached or its process died
+      bool client_lost() {
+        auto iClient = header().client.load();
+        return _::shm_header::released_client == iClient || (iClient && !_::process_alive(iClient));
+      }
+
+      /** resets the connection of a live client whose request framing is broken and waits for the client to go away
+      The client still owns the head of the request ring, so the rings are left alone until it has detached or died.
+      @returns false if the server is stopped first
+      */
+      bool disconnect() {
+        if (!client_lost()) {
+          header().reset.store(1);
+          _::shm_ring::futex_wake(reply().data_seq);
+          _::shm_ring::futex_wake(request().space_seq);
+        }
+        while (!client_lost()) {
+          auto iSeq = request().data_seq.load();
+          if (header().stopped.load()) return false;
+          _::shm_ring::futex_wait(request().data_seq, iSeq, 100);
+        }
+        return true;
+      }
+
+      /** empties the rings and frees the region for the next client, called from the server thread once the client is lost
+      Replies still being written for the lost client are dropped
+      */
+      void reclaim() {
+        std::lock_guard<std::mutex> oLock(_reply_lock);
+        for (auto pRing : { &request(), &reply() }) {
+          pRing->head.store(0);
+          pRing->tail.store(0);
+          pRing->readers_waiting.store(0);
+          pRing->writers_waiting.store(0);
+        }
+        ++_session;
+        header().reset.store(0);
+        header().client.store(0);
+      }
+
+      _::shm_header& header() { return *reinterpret_cast<_::shm_header*>(_region); }
+      _::shm_ring& request() { return *reinterpret_cast<_::shm_ring*>(_region + ring_offset()); }
+      _::shm_ring& reply() { return *reinterpret_cast<_::shm_ring*>(_region + ring_offset() + sizeof(_::shm_ring) + _ring_size); }
+
+      static size_t ring_offset() { return (sizeof(_::shm_header) + alignof(_::shm_ring) - 1) & ~(alignof(_::shm_ring) - 1); }
+      size_t region_size() const { return ring_offset() + (2 * (sizeof(_::shm_ring) + _ring_size)); }
+
+      void map(size_t iSize) {
+        auto pRegion = mmap(nullptr, iSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (MAP_FAILED == pRegion) {
+          close(_fd);
+          _fd = -1;
+          throw xtd::crt_exception(here(), "mmap failed");
+        }
+        _region = static_cast<uint8_t*>(pRegion);
+        _region_size = iSize;
+      }
+
+      void create() {
+        _fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (-1 == _fd && EEXIST == errno && stale()) {
+          shm_unlink(_name.c_str());
+          _fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        }
+        if (-1 == _fd && EEXIST == errno) throw xtd::exception(here(), "Shared memory region in use by another server");
+        xtd::crt_exception::throw_if(_fd, [](int i) { return -1 == i; });
+        if (ftruncate(_fd, static_cast<off_t>(region_size()))) {
+          close(_fd);
+          _fd = -1;
+          throw xtd::crt_exception(here(), "ftruncate failed");
+        }
+        map(region_size());
+        auto pHeader = new (_region) _::shm_header;
+        pHeader->ring_size = _ring_size;
+        pHeader->stopped.store(0);
+        pHeader->client.store(0);
+        pHeader->reset.store(0);
+        pHeader->server = static_cast<uint32_t>(getpid());
+        for (auto pRing : { &request(), &reply() }) {
+          new (pRing) _::shm_ring;
+          pRing->head.store(0);
+          pRing->tail.store(0);
+          pRing->data_seq.store(0);
+          pRing->space_seq.store(0);
+          pRing->readers_waiting.store(0);
+          pRing->writers_waiting.store(0);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        pHeader->magic = _::shm_header::magic_value;
+        _server = true;
+        _session = 0;
+      }
+
+      /// an existing region was completely set up by a server process that no longer exists
+      bool stale() const {
+        auto iFD = shm_open(_name.c_str(), O_RDONLY | O_CLOEXEC, 0600);
+        if (-1 == iFD) return ENOENT == errno;
+        bool bRet = false;
+        struct stat oStat;
+        if (!fstat(iFD, &oStat) && static_cast<size_t>(oStat.st_size) >= sizeof(_::shm_header)) {
+          auto pRegion = mmap(nullptr, sizeof(_::shm_header), PROT_READ, MAP_SHARED, iFD, 0);
+          if (MAP_FAILED != pRegion) {
+            auto pHeader = static_cast<const _::shm_header*>(pRegion);
+            bRet = _::shm_header::magic_value == pHeader->magic && !_::process_alive(pHeader->server);
+            munmap(pRegion, sizeof(_::shm_header));
+          }
+        }
+        close(iFD);
+        return bRet;
+      }
+
+      void attach() {
+        _fd = xtd::crt_exception::throw_if(shm_open(_name.c_str(), O_RDWR | O_CLOEXEC, 0600), [](int i) { return -1 == i; });
+        struct stat oStat;
+        if (fstat(_fd, &oStat) || static_cast<size_t>(oStat.st_size) < sizeof(_::shm_header)) {
+          close(_fd);
+          _fd = -1;
+          throw xtd::exception(here(), "Invalid shared memory region");
+        }
+        map(static_cast<size_t>(oStat.st_size));
+        _ring_size = static_cast<size_t>(header().ring_size);
+        if (_::shm_header::magic_value != header().magic || region_size() > _region_size) {
+          detach();
+          throw xtd::exception(here(), "Shared memory server unavailable");
+        }
+        //a previous client that detached or died is reclaimed by the server within one futex timeout
+        auto iPid = static_cast<uint32_t>(getpid());
+        for (int i = 0; ; ++i) {
+          uint32_t iExpected = 0;
+          if (header().client.compare_exchange_strong(iExpected, iPid)) {
+            _attached = true;
+            break;
+          }
+          if (i >= 500 || (_::shm_header::released_client != iExpected && _::process_alive(iExpected))) {
+            detach();
+            throw xtd::exception(here(), "Shared memory server already connected");
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+      }
+
+      void detach() {
+        if (_region) {
+          if (_attached) {
+            _attached = false;
+            header().client.store(_::shm_header::released_client);
+            _::shm_ring::futex_wake(request().data_seq);
+            _::shm_ring::futex_wake(reply().space_seq);
+          }
+          munmap(_region, _region_size);
+          _region = nullptr;
+        }
+        if (-1 != _fd) {
+          close(_fd);
+          _fd = -1;
+        }
+        if (_server) {
+          shm_unlink(_name.c_str());
+          _server = false;
+        }
+      }
+
+      std::string _name;
+      size_t _ring_size;
+      size_t _spin;
+      int _fd;
+      uint8_t * _region;
+      size_t _region_size;
+      bool _server;
+      bool _attached;
+      std::atomic<bool> _shutdown;
+      std::unique_ptr<std::thread> _server_thread;
+      payload_pool _requests;
+      std::mutex _reply_lock;
+      uint32_t _session; //bumped by reclaim so replies for a lost client are dropped
+      std::mutex _send_lock;
+      std::mutex _transact_lock;
     };
+#endif
 
 
     /*
      * rpc_client
      */
     template <typename _transport_t> struct rpc_client < _transport_t> : _transport_t {
-      template <typename ... _arg_ts> rpc_client(_arg_ts&&...oArgs) : _transport_t(std::forward<_arg_ts>(oArgs)...) {}
+      template <typename ... _arg_ts> rpc_client(_arg_ts&&...oArgs)
+        : _transport_t(std::forward<_arg_ts>(oArgs)...), _payloads(), _next_request(0), _replies_lock(), _replies_ready(), _replies(), _pending(), _receiving(false), _receiver(), _receiver_running(false) {}
+      /// fails outstanding asynchronous calls rather than wait for replies that may never arrive
+      ~rpc_client() {
+        std::unique_lock<std::mutex> oLock(_replies_lock);
+        auto bReceiving = _receiver_running;
+        oLock.unlock();
+        if (bReceiving) _transport_t::shutdown();
+        if (_receiver.joinable()) _receiver.join();
+      }
       template <typename _impl_t> using client_from_impl = rpc_client < _transport_t>;
+    protected:
+      template <typename, typename...> friend class rpc_batch;
+
+      /// consumes the reply to an asynchronous call, or the error that prevented it from arriving
+      using completion_type = std::function<void(const payload*, std::exception_ptr)>;
+
+      /// tags the request with a fresh id and sends it, returning the id to wait on
+      uint64_t _send_request(payload& oPayload) {
+        auto iRequest = ++_next_request;
+        oPayload.request_id(iRequest);
+        _transport_t::send(oPayload);
+        return iRequest;
+      }
+
+      /** sends a request whose reply is handed to complete on arrival instead of being held for a waiter
+      A receiver thread runs while such calls are outstanding so their replies arrive without anyone waiting on them
+      */
+      void _send_async(payload& oPayload, completion_type&& complete) {
+        auto iRequest = ++_next_request;
+        oPayload.request_id(iRequest);
+        std::unique_lock<std::mutex> oLock(_replies_lock);
+        _pending.emplace(iRequest, std::move(complete));
+        oLock.unlock();
+        try {
+          _transport_t::send(oPayload);
+        } catch (...) {
+          oLock.lock();
+          _pending.erase(iRequest);
+          throw;
+        }
+        oLock.lock();
+        if (_receiver_running || _pending.empty()) return;
+        if (_receiver.joinable()) _receiver.join();
+        _receiver_running = true;
+        _receiver = std::thread([this]() { _receive_async(); });
+      }
+
+      /** waits for the reply to a request
+      Whichever waiter finds the transport idle receives replies on behalf of everyone, completing asynchronous calls and
+      parking the replies of other waiters until their owners collect them, so replies may arrive in any order.
+      */
+      payload_pool::handle _wait_reply(uint64_t iRequest) {
+        std::unique_lock<std::mutex> oLock(_replies_lock);
+        forever {
+          auto oReply = _replies.find(iRequest);
+          if (_replies.end() != oReply) {
+            auto oRet = std::move(oReply->second);
+            _replies.erase(oReply);
+            return oRet;
+          }
+          if (_receiving) {
+            _replies_ready.wait(oLock);
+            continue;
+          }
+          auto oBuffer = _receive(oLock);
+          if (oBuffer->request_id() == iRequest) return oBuffer;
+          _deliver(oLock, std::move(oBuffer));
+        }
+      }
+
+      /// receives one reply with the lock released, a receive error fails every outstanding asynchronous call
+      payload_pool::handle _receive(std::unique_lock<std::mutex>& oLock) {
+        _receiving = true;
+        oLock.unlock();
+        auto oBuffer = _payloads.acquire();
+        try {
+          _transport_t::receive(*oBuffer);
+        } catch (...) {
+          auto pError = std::current_exception();
+          oLock.lock();
+          _receiving = false;
+          _replies_ready.notify_all();
+          std::unordered_map<uint64_t, completion_type> oPending;
+          oPending.swap(_pending);
+          oLock.unlock();
+          for (auto & oCall : oPending) oCall.second(nullptr, pError);
+          oLock.lock();
+          throw;
+        }
+        oLock.lock();
+        _receiving = false;
+        _replies_ready.notify_all();
+        return oBuffer;
+      }
+
+      /// completes the asynchronous call a reply belongs to or parks it for its waiter
+      void _deliver(std::unique_lock<std::mutex>& oLock, payload_pool::handle&& oBuffer) {
+        auto oCall = _pending.find(oBuffer->request_id());
+        if (_pending.end() == oCall) {
+          _replies.emplace(oBuffer->request_id(), std::move(oBuffer));
+          return;
+        }
+        auto complete = std::move(oCall->second);
+        _pending.erase(oCall);
+        oLock.unlock();
+        complete(&*oBuffer, nullptr);
+        oLock.lock();
+      }
+
+      /// receiver thread body, exits once no asynchronous call is outstanding
+      void _receive_async() {
+        std::unique_lock<std::mutex> oLock(_replies_lock);
+        while (!_pending.empty()) {
+          if (_receiving) {
+            _replies_ready.wait(oLock);
+            continue;
+          }
+          try {
+            auto oBuffer = _receive(oLock);
+            _deliver(oLock, std::move(oBuffer));
+          } catch (...) {
+            break;
+          }
+        }
+        _receiver_running = false;
+      }
+
+      /// request/reply buffers reused across calls on this connection
+      payload_pool _payloads;
+      std::atomic<uint64_t> _next_request;
+      std::mutex _replies_lock;
+      std::condition_variable _replies_ready;
+      std::unordered_map<uint64_t, payload_pool::handle> _replies;
+      std::unordered_map<uint64_t, completion_type> _pending;
+      bool _receiving;
+      std::thread _receiver;
+      bool _receiver_running;
     };
 
     template <typename _transport_t, typename _head_t, typename ... _tail_ts> struct rpc_client<_transport_t, _head_t, _tail_ts...> : rpc_client<_transport_t, _tail_ts...> {
@@ -279,26 +1660,73 @@ namespace xtd{
       template <typename _impl_t> using client_from_impl = typename std::conditional< std::is_same<_impl_t, _head_t>::value, _this_t, typename _super_t::template client_from_impl<_impl_t>>::type;
 
       template <typename _ty, typename ... _arg_ts> typename _ty::return_type call(_arg_ts&&...oArgs) {
-        return static_cast<client_from_impl<_ty>&>(*this)._call<typename _ty::return_type>(std::forward<_arg_ts>(oArgs)...);
+        return static_cast<client_from_impl<_ty>&>(*this).template _call<typename _ty::return_type>(_::call_index<_ty, _head_t, _tail_ts...>::value, std::forward<_arg_ts>(oArgs)...);
+      }
+
+      /// starts a batch of calls that are sent together in one request
+      rpc_batch<_transport_t, _head_t, _tail_ts...> batch() { return rpc_batch<_transport_t, _head_t, _tail_ts...>(*this); }
+
+      /** sends a call without waiting for its reply
+      Any number of calls may be outstanding on the connection. The request is marshaled before returning so the
+      arguments need not outlive the call, but in-out arguments are not updated. The future becomes ready as soon as the
+      reply arrives and may be polled with wait_for. A reply whose future was discarded is dropped on arrival. Destroying
+      the client fails the futures of calls that are still outstanding.
+      */
+      template <typename _ty, typename ... _arg_ts> std::future<typename _ty::return_type> call_async(_arg_ts&&...oArgs) {
+        return static_cast<client_from_impl<_ty>&>(*this).template _call_async<typename _ty::return_type>(_::call_index<_ty, _head_t, _tail_ts...>::value, std::forward<_arg_ts>(oArgs)...);
       }
 
     protected:
       template <typename, typename...> friend struct rpc_client;
+      using _base_t = rpc_client<_transport_t>;
 
-      template <typename _return_t, typename ... _arg_ts> _return_t _call(_arg_ts&&...oArgs) {
-        payload oPayload;
-        marshaler<false, size_t>::marshal(oPayload, typeid(_head_t).hash_code());
-        marshaler<false, _arg_ts...>::marshal(oPayload, std::forward<_arg_ts>(oArgs)...);
-        transport_type::transact(oPayload);
+      /// requests carry the stable wire id of the call and its index in the client's call list as a dispatch hint for the server
+      template <typename ... _arg_ts> payload_pool::handle _marshal(uint32_t iIndex, _arg_ts&&...oArgs) {
+        auto oBuffer = _base_t::_payloads.acquire();
+        payload& oPayload = *oBuffer;
+        marshaler<false, uint64_t>::marshal(oPayload, _head_t::wire_id());
+        marshaler<false, uint32_t>::marshal(oPayload, iIndex);
+        _head_t::marshal_args(oPayload, std::forward<_arg_ts>(oArgs)...);
+        return oBuffer;
+      }
+
+      template <typename ... _arg_ts> uint64_t _send(uint32_t iIndex, _arg_ts&&...oArgs) {
+        auto oBuffer = _marshal(iIndex, std::forward<_arg_ts>(oArgs)...);
+        return _base_t::_send_request(*oBuffer);
+      }
+
+      static payload_reader _reply_reader(const payload& oPayload) {
+        auto oReply = oPayload.reader();
+        if (_head_t::wire_id() != oReply.peek<uint64_t>()) throw xtd::exception(here(), "Mismatched reply");
+        oReply.skip(sizeof(uint64_t));
+        return oReply;
+      }
+
+      template <typename _return_t, typename ... _arg_ts> _return_t _call(uint32_t iIndex, _arg_ts&&...oArgs) {
+        auto iRequest = _send(iIndex, std::forward<_arg_ts>(oArgs)...);
+        auto oBuffer = _base_t::_wait_reply(iRequest);
+        auto oReply = _reply_reader(*oBuffer);
         _return_t oRet;
-        if (typeid(_head_t).hash_code() != oPayload.peek<size_t>()) {
-          assert(false);
-          //TODO: unmarshal exception and throw
-        }
-        size_t icalltypeid;
-        marshaler<false, size_t>::unmarshal(oPayload, icalltypeid);
-        marshaler<false, _return_t&>::unmarshal(oPayload, oRet);
-        marshaler<true, _arg_ts...>::unmarshal(oPayload, std::forward<_arg_ts>(oArgs)...);
+        _head_t::codec_type::unmarshal(oReply, oRet);
+        marshaler<true, _arg_ts...>::unmarshal(oReply, std::forward<_arg_ts>(oArgs)...);
+        return oRet;
+      }
+
+      template <typename _return_t, typename ... _arg_ts> std::future<_return_t> _call_async(uint32_t iIndex, _arg_ts&&...oArgs) {
+        std::shared_ptr<std::promise<_return_t>> oPromise(new std::promise<_return_t>);
+        auto oRet = oPromise->get_future();
+        auto oBuffer = _marshal(iIndex, std::forward<_arg_ts>(oArgs)...);
+        _base_t::_send_async(*oBuffer, [oPromise](const payload * pReply, std::exception_ptr pError) {
+          try {
+            if (pError) std::rethrow_exception(pError);
+            auto oReply = _reply_reader(*pReply);
+            _return_t oValue;
+            _head_t::codec_type::unmarshal(oReply, oValue);
+            oPromise->set_value(std::move(oValue));
+          } catch (...) {
+            oPromise->set_exception(std::current_exception());
+          }
+        });
         return oRet;
       }
 
@@ -314,12 +1742,14 @@ namespace xtd{
 
       template <typename _function_t, typename _return_t> struct invoker<_function_t, _return_t> {
 
+        //the request is not touched until the call returns so views unmarshaled from it remain valid for the duration of the call
+        //the reply then reuses the request buffer and its capacity
         template <typename ... _arg_ts>
-        static bool invoke(_function_t& oFN, payload& oPayload, _arg_ts&&...oArgs) {
+        static bool invoke(_function_t& oFN, payload_reader&, payload& oPayload, _arg_ts&&...oArgs) {
           _return_t oRet = oFN(std::forward<_arg_ts>(oArgs)...);
-          oPayload = payload();
-          marshaler<false, size_t>::marshal(oPayload, typeid(typename _function_t::impl_type).hash_code());
-          marshaler<false, _return_t>::marshal(oPayload, oRet);
+          oPayload.reset();
+          marshaler<false, uint64_t>::marshal(oPayload, _function_t::wire_id());
+          _function_t::codec_type::marshal(oPayload, oRet);
           return true;
         }
       };
@@ -327,10 +1757,11 @@ namespace xtd{
       template <typename _function_t, typename _return_t, typename _head_t, typename ... _tail_ts> struct invoker<_function_t, _return_t, _head_t, _tail_ts...> {
 
         template <typename ... _arg_ts>
-        static bool invoke(_function_t& oFN, payload& oPayload, _arg_ts&&...oArgs) {
-          typename std::remove_reference<_head_t>::type oHead;
-          marshaler<false, _head_t>::unmarshal(oPayload, oHead);
-          return invoker<_function_t, _return_t, _tail_ts...>::template invoke(oFN, oPayload, std::forward<_arg_ts>(oArgs)..., oHead);
+        static bool invoke(_function_t& oFN, payload_reader& oRequest, payload& oPayload, _arg_ts&&...oArgs) {
+          using value_type = typename std::decay<_head_t>::type;
+          value_type oHead;
+          _function_t::codec_type::unmarshal(oRequest, oHead);
+          return invoker<_function_t, _return_t, _tail_ts...>::invoke(oFN, oRequest, oPayload, std::forward<_arg_ts>(oArgs)..., oHead);
         }
       };
     }
@@ -339,14 +1770,140 @@ namespace xtd{
      * rpc_server
      */
 
+    namespace _ {
+      /** fixed pool of threads running server requests
+      Requests are grouped into slots, one per call type, each of which may cap how many of its requests run at once.
+      Requests over the cap wait in their slot without occupying a worker. Replies are completed from the worker as soon
+      as the handler returns so they leave in completion order, the request id lets the client correlate them.
+      */
+      class executor {
+      public:
+        using complete_type = std::function<void(payload&)>;
+        using invoke_type = std::function<bool(payload&)>;
+
+        executor(size_t workers, const std::vector<size_t>& limits, invoke_type&& invoke)
+          : _lock(), _work_ready(), _ready(), _slots(limits.size()), _queued(0), _stopping(false), _invoke(std::move(invoke)), _workers() {
+          for (size_t i = 0; i < limits.size(); ++i) _slots[i]._limit = limits[i];
+          for (size_t i = 0; i < workers; ++i) _workers.emplace_back([this]() { run(); });
+        }
+
+        ~executor() { stop(); }
+
+        executor(const executor&) = delete;
+        executor& operator=(const executor&) = delete;
+
+        /// queues a request, returns false without taking it once the executor is stopping
+        template <typename _complete_t> bool submit(size_t iSlot, payload_pool::handle& oRequest, const _complete_t& complete) {
+          complete_type oComplete(complete);
+          std::unique_lock<std::mutex> oLock(_lock);
+          if (_stopping) return false;
+          job oJob(iSlot, std::move(oRequest), std::move(oComplete));
+          ++_queued;
+          auto & oSlot = _slots[iSlot];
+          if (oSlot._limit && oSlot._running >= oSlot._limit) {
+            oSlot._waiting.push_back(std::move(oJob));
+            return true;
+          }
+          ++oSlot._running;
+          _ready.push_back(std::move(oJob));
+          oLock.unlock();
+          _work_ready.notify_one();
+          return true;
+        }
+
+        /// runs everything already queued then joins the workers
+        void stop() {
+          {
+            std::lock_guard<std::mutex> oLock(_lock);
+            _stopping = true;
+          }
+          _work_ready.notify_all();
+          for (auto & oWorker : _workers) oWorker.join();
+          _workers.clear();
+        }
+
+      private:
+        struct job {
+          job(size_t iSlot, payload_pool::handle&& oRequest, complete_type&& complete) : _slot(iSlot), _request(std::move(oRequest)), _complete(std::move(complete)) {}
+          job(job&& src) : _slot(src._slot), _request(std::move(src._request)), _complete(std::move(src._complete)) {}
+          size_t _slot;
+          payload_pool::handle _request;
+          complete_type _complete;
+        };
+
+        struct slot {
+          slot() : _limit(0), _running(0), _waiting() {}
+          size_t _limit;
+          size_t _running;
+          std::deque<job> _waiting;
+        };
+
+        void run() {
+          std::unique_lock<std::mutex> oLock(_lock);
+          forever {
+            _work_ready.wait(oLock, [this] { return !_ready.empty() || (_stopping && !_queued); });
+            if (_ready.empty()) return;
+            job oJob(std::move(_ready.front()));
+            _ready.pop_front();
+            oLock.unlock();
+            payload& oPayload = *oJob._request;
+            try {
+              if (!_invoke(oPayload)) oPayload.reset();
+            } catch (...) {
+              oPayload.reset();
+            }
+            try {
+              oJob._complete(oPayload);
+            } catch (...) {}
+            oLock.lock();
+            --_queued;
+            auto & oSlot = _slots[oJob._slot];
+            --oSlot._running;
+            if (!oSlot._waiting.empty()) {
+              ++oSlot._running;
+              _ready.push_back(std::move(oSlot._waiting.front()));
+              oSlot._waiting.pop_front();
+              _work_ready.notify_one();
+            }
+            if (_stopping && !_queued) _work_ready.notify_all();
+          }
+        }
+
+        std::mutex _lock;
+        std::condition_variable _work_ready;
+        std::deque<job> _ready;
+        std::vector<slot> _slots;
+        size_t _queued;
+        bool _stopping;
+        invoke_type _invoke;
+        std::vector<std::thread> _workers;
+      };
+    }
+
     template <typename _transport_t> struct rpc_server < _transport_t> : _transport_t {
       template <typename _impl_t> using server_from_impl = rpc_server < _transport_t>;
 
-      template <typename ... _arg_ts> rpc_server(_arg_ts&&...oArgs) : _transport_t(std::forward<_arg_ts>(oArgs)...) {}
+      template <typename ... _arg_ts> rpc_server(_arg_ts&&...oArgs) : _transport_t(std::forward<_arg_ts>(oArgs)...), _workers(0), _call_limits(), _limits(), _executor() {}
+
+      /** sets the number of worker threads that run handlers, takes effect on the next start_server
+      With no workers, the default, handlers run inline on the transport's own thread
+      */
+      void workers(size_t count) { _workers = count; }
+
     protected:
-      bool invoke(payload& oPayload) {
+      bool invoke(payload&) {
+        return false;
+      }
+      bool invoke(payload_reader&, payload&) {
         return false;
       }
+
+      size_t _workers;
+      /// concurrency limits by wire id, resolved to slots by start_server
+      std::unordered_map<uint64_t, size_t> _call_limits;
+      /// concurrency limit of each slot
+      std::vector<size_t> _limits;
+      std::unique_ptr<_::executor> _executor;
     };
 
     template <typename _transport_t, typename _head_t, typename ... _tail_ts> struct rpc_server<_transport_t, _head_t, _tail_ts...> : rpc_server<_transport_t, _tail_ts...> {
@@ -365,31 +1922,213 @@ namespace xtd{
 
       template <typename _impl_t> server_from_impl<_impl_t>& get() { return static_cast<server_from_impl<_impl_t>&>(*this); }
 
-      void start_server() { transport_type::template start_server<_this_t>(*this); }
-      void stop_server() { transport_type::stop_server(); }
+      /** caps how many requests for a call run at once on the worker pool, 0 removes the cap
+      Takes effect on the next start_server
+      */
+      template <typename _ty> void concurrency_limit(size_t limit) {
+        static_assert(_::call_index<_ty, _head_t, _tail_ts...>::value < call_count, "Call is not served");
+        //get<>() may have reached a level whose call list is only a tail of the server's, so the slot is found at start_server
+        _base_t::_call_limits[_ty::wire_id()] = limit;
+      }
+
+      void start_server() {
+        if (_base_t::_workers) {
+          _base_t::_limits.assign(call_count + 1, 0);
+          for (const auto & oLimit : _base_t::_call_limits) _base_t::_limits[_call_index(oLimit.first, static_cast<uint32_t>(call_count))] = oLimit.second;
+          _base_t::_executor.reset(new _::executor(_base_t::_workers, _base_t::_limits, [this](payload& oPayload) { return invoke(oPayload); }));
+        }
+        transport_type::template start_server<_this_t>(*this);
+      }
+
+      /// drains the worker pool while the transport can still deliver replies, then stops the transport
+      void stop_server() {
+        if (_base_t::_executor) _base_t::_executor->stop();
+        transport_type::stop_server();
+        _base_t::_executor.reset();
+      }
 
     protected:
-      friend struct pipe_transport;
-      friend struct pipe_transport;
+      friend _transport_t;
+      template <typename, typename...> friend struct rpc_server;
+      using _base_t = rpc_server<_transport_t>;
+      static constexpr size_t call_count = 1 + sizeof...(_tail_ts);
       call_type _call;
 
+      /** runs a request and hands the reply to complete
+      Transports call this for every request they receive. Without workers it runs inline, otherwise complete is called
+      from a worker thread and may run concurrently with other completions. Once the pool is stopping, requests run inline.
+      A request that can't be unmarshaled or whose handler throws is answered with an empty reply, as on the workers.
+      */
+      template <typename _complete_t> void execute(payload_pool::handle&& oRequest, _complete_t&& complete) {
+        if (_base_t::_executor && _base_t::_executor->submit(_slot(*oRequest), oRequest, complete)) return;
+        payload& oPayload = *oRequest;
+        try {
+          if (!invoke(oPayload)) oPayload.reset();
+        } catch (...) {
+          oPayload.reset();
+        }
+        complete(oPayload);
+      }
+
+      /// position of the requested call in the call list, batches and unknown calls share the slot past the end
+      static size_t _slot(const payload& oPayload) {
+        if (oPayload.size() < payload::header_size + sizeof(uint64_t) + sizeof(uint32_t)) return call_count;
+        uint64_t iWireId;
+        uint32_t iIndex;
+        memcpy(&iWireId, oPayload.data() + payload::header_size, sizeof(uint64_t));
+        memcpy(&iIndex, oPayload.data() + payload::header_size + sizeof(uint64_t), sizeof(uint32_t));
+        return _call_index(iWireId, iIndex);
+      }
+
+      /// resolves a wire id to its position, trusting the client's index when it matches
+      static size_t _call_index(uint64_t iWireId, uint32_t iIndex) {
+        static const uint64_t oWireIds[call_count] = { _head_t::wire_id(), _tail_ts::wire_id()... };
+        if (iIndex < call_count && oWireIds[iIndex] == iWireId) return iIndex;
+        return static_cast<size_t>(std::find(oWireIds, oWireIds + call_count, iWireId) - oWireIds);
+      }
+
+      /// dispatches a received payload, replacing it with the reply
       bool invoke(payload& oPayload) {
-        if (typeid(_head_t).hash_code() != oPayload.peek<size_t>()) return _super_t::invoke(oPayload);
-        size_t iCallID;
-        marshaler<false, size_t>::unmarshal(oPayload, iCallID);
-        return _call.invoke(oPayload);
+        auto oRequest = oPayload.reader();
+        return invoke(oRequest, oPayload);
+      }
+
+      /** dispatches through a jump table indexed by the call's position
+      The client's index is trusted when the wire id at that position matches, which is always the case for clients built
+      from the same call list. Clients with a different list fall back to a search of the wire ids.
+      */
+      bool invoke(payload_reader& oRequest, payload& oPayload) {
+        if (_::batch_wire_id == oRequest.peek<uint64_t>()) return _invoke_batch(oRequest, oPayload);
+        return _invoke_call(oRequest, oPayload);
       }
+
+      bool _invoke_call(payload_reader& oRequest, payload& oPayload) {
+        using dispatch_type = bool(*)(_this_t&, payload_reader&, payload&);
+        static constexpr dispatch_type oDispatch[call_count] = { &_this_t::template _dispatch<_head_t>, &_this_t::template _dispatch<_tail_ts>... };
+        uint64_t iWireId;
+        uint32_t iIndex;
+        marshaler<false, uint64_t&, uint32_t&>::unmarshal(oRequest, iWireId, iIndex);
+        auto iCall = _call_index(iWireId, iIndex);
+        if (call_count == iCall) return false;
+        return oDispatch[iCall](*this, oRequest, oPayload);
+      }
+
+      template <typename _impl_t> static bool _dispatch(_this_t& oServer, payload_reader& oRequest, payload& oPayload) {
+        return oServer.template get<_impl_t>()._call.invoke(oRequest, oPayload);
+      }
+
+      /** runs each call of a batch in order and packs their replies into one
+      Every reply is its length followed by the reply bytes, a zero length marks a call that could not be dispatched
+      */
+      bool _invoke_batch(payload_reader& oRequest, payload& oPayload) {
+        static thread_local payload oReply;
+        static thread_local payload oCallReply;
+        uint64_t iWireId;
+        uint32_t iIndex, iCount;
+        marshaler<false, uint64_t&, uint32_t&, uint32_t&>::unmarshal(oRequest, iWireId, iIndex, iCount);
+        oReply.reset();
+        oReply.request_id(oPayload.request_id());
+        marshaler<false, uint64_t>::marshal(oReply, _::batch_wire_id);
+        marshaler<false, uint32_t>::marshal(oReply, iCount);
+        for (uint32_t i = 0; i < iCount; ++i) {
+          size_t iLen;
+          marshaler<false, size_t&>::unmarshal(oRequest, iLen);
+          auto oCall = oRequest.sub(iLen);
+          oCallReply.reset();
+          size_t iReplyLen = _invoke_call(oCall, oCallReply) ? oCallReply.size() - payload::header_size : 0;
+          marshaler<false, size_t>::marshal(oReply, iReplyLen);
+          oReply.resize(oReply.size() + payload_reader::padding(oReply.size() - payload::header_size, _::batch_alignment), 0);
+          oReply.insert(oReply.end(), oCallReply.begin() + payload::header_size, oCallReply.begin() + payload::header_size + iReplyLen);
+        }
+        oPayload.swap(oReply);
+        return true;
+      }
+    };
+
+    /** builder that packs several calls into a single request
+    Calls are marshaled as they are added and sent with one round trip by send(), which then completes the futures
+    returned by add(). The server runs the calls in the order they were added.
+    */
+    template <typename _transport_t, typename ... _call_ts> class rpc_batch {
+    public:
+      using client_type = rpc_client<_transport_t, _call_ts...>;
+
+      explicit rpc_batch(client_type& oClient) : _client(oClient), _payload(_client._payloads.acquire()), _completions() {
+        marshaler<false, uint64_t>::marshal(*_payload, _::batch_wire_id);
+        marshaler<false, uint32_t>::marshal(*_payload, std::numeric_limits<uint32_t>::max());
+        marshaler<false, uint32_t>::marshal(*_payload, 0);
+      }
+      rpc_batch(rpc_batch&&) = default;
+
+      template <typename _ty, typename ... _arg_ts> std::future<typename _ty::return_type> add(_arg_ts&&...oArgs) {
+        using return_type = typename _ty::return_type;
+        payload& oPayload = *_payload;
+        marshaler<false, size_t>::marshal(oPayload, 0);
+        auto iStart = oPayload.size();
+        marshaler<false, uint64_t>::marshal(oPayload, _ty::wire_id());
+        marshaler<false, uint32_t>::marshal(oPayload, _::call_index<_ty, _call_ts...>::value);
+        _ty::marshal_args(oPayload, std::forward<_arg_ts>(oArgs)...);
+        size_t iLen = oPayload.size() - iStart;
+        memcpy(oPayload.data() + iStart - sizeof(size_t), &iLen, sizeof(size_t));
+        std::shared_ptr<std::promise<return_type>> oPromise(new std::promise<return_type>);
+        _completions.push_back([oPromise](payload_reader * pReply) {
+          try {
+            if (!pReply || _ty::wire_id() != pReply->peek<uint64_t>()) throw xtd::exception(here(), "Batched call failed");
+            pReply->skip(sizeof(uint64_t));
+            return_type oRet;
+            _ty::codec_type::unmarshal(*pReply, oRet);
+            oPromise->set_value(std::move(oRet));
+          } catch (...) {
+            oPromise->set_exception(std::current_exception());
+          }
+        });
+        return oPromise->get_future();
+      }
+
+      size_t size() const { return _completions.size(); }
+
+      /// sends the batch and waits for its reply
+      void send() {
+        payload& oPayload = *_payload;
+        uint32_t iCount = static_cast<uint32_t>(_completions.size());
+        memcpy(oPayload.data() + payload::header_size + sizeof(uint64_t) + sizeof(uint32_t), &iCount, sizeof(uint32_t));
+        auto oBuffer = _client._wait_reply(_client._send_request(oPayload));
+        auto oReply = oBuffer->reader();
+        uint64_t iWireId;
+        uint32_t iReplies;
+        marshaler<false, uint64_t&, uint32_t&>::unmarshal(oReply, iWireId, iReplies);
+        if (_::batch_wire_id != iWireId || iReplies != iCount) throw xtd::exception(here(), "Malformed batch reply");
+        for (auto & oCompletion : _completions) {
+          size_t iLen;
+          marshaler<false, size_t&>::unmarshal(oReply, iLen);
+          oReply.skip(payload_reader::padding(oReply.offset() - payload::header_size, _::batch_alignment));
+          auto oCall = oReply.sub(iLen);
+          oCompletion(iLen ? &oCall : nullptr);
+        }
+        _completions.clear();
+        oPayload.resize(payload::header_size + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint32_t));
+      }
+
+    private:
+      rpc_client<_transport_t>& _client;
+      payload_pool::handle _payload;
+      std::vector<std::function<void(payload_reader*)>> _completions;
     };
 
     /*
    * rpc_call
    */
 
-    template <typename _impl_t, typename _return_t, typename ... _fnarg_ts> struct rpc_call<_impl_t, _return_t(_fnarg_ts...)> : std::function<_return_t(_fnarg_ts...)> {
+    /** declares a remote call
+    @tparam _impl_t the call class deriving from rpc_call
+    @tparam _codec_t raw_codec or compact_codec, how parameters and the return value are encoded
+    */
+    template <typename _impl_t, typename _return_t, typename ... _fnarg_ts, typename _codec_t> struct rpc_call<_impl_t, _return_t(_fnarg_ts...), _codec_t> : std::function<_return_t(_fnarg_ts...)> {
       using _super_t = std::function<_return_t(_fnarg_ts...)>;
-      using _my_t = rpc_call<_impl_t, _return_t(_fnarg_ts...)>;
+      using _my_t = rpc_call<_impl_t, _return_t(_fnarg_ts...), _codec_t>;
       using return_type = _return_t;
       using impl_type = _impl_t;
+      using codec_type = _codec_t;
       template <typename ... _arg_ts> rpc_call(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...) {}
 
 
@@ -397,11 +2136,22 @@ namespace xtd{
         *this = _super_t(std::forward<_arg_ts>(oArgs)...);
       }
 
+      /** identifies the call on the wire
+      A call class declaring `static constexpr const char * wire_name` is identified by a hash of that name, which is stable
+      across builds and compilers. Otherwise the hash of the mangled type name is used, which only matches between builds
+      from compilers sharing an ABI.
+      */
+      static uint64_t wire_id() { return _::wire_id<_impl_t>(_::has_wire_name<_impl_t>()); }
+
+      template <typename ... _arg_ts> static void marshal_args(payload_t& oPayload, _arg_ts&&...oArgs) {
+        codec_type::template marshal_args<_fnarg_ts...>(oPayload, std::forward<_arg_ts>(oArgs)...);
+      }
+
     protected:
       template <typename, typename...> friend struct rpc_server;
 
-      bool invoke(payload& oPayload) {
-        return _::invoker<_my_t, _return_t, _fnarg_ts...>::invoke(*this, oPayload);
+      bool invoke(payload_reader& oRequest, payload& oPayload) {
+        return _::invoker<_my_t, _return_t, _fnarg_ts...>::invoke(*this, oRequest, oPayload);
       }
     };
 
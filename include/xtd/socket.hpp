@@ -1,634 +1,2026 @@
-/** @file
-general purpose socket communication
-@copyright David Mott (c) 2016. Distributed under the Boost Software License Version 1.0. See LICENSE.md or http://boost.org/LICENSE_1_0.txt for details.
-*/
-
-#pragma once
-#include <xtd/xtd.hpp>
-
-#if (XTD_OS_WINDOWS & XTD_OS)
-  #include <Ws2ipdef.h>
-  #include <ws2tcpip.h>
-  static_assert(_WIN32_WINNT >= 0x500, "unsupported target Windows version");
-  #define poll WSAPoll
-#endif
-
-#if (XTD_COMPILER_MINGW & XTD_COMPILER)
-  #include <mswsock.h>
-#endif
-
-#if (XTD_OS_UNIX & XTD_OS)
-  #include <sys/socket.h>
-  #include <sys/ioctl.h>
-  #include <netinet/in.h>
-  #include <netinet/udp.h>
-  #include <netinet/tcp.h>
-  #include <arpa/inet.h>
-  #include <poll.h>
-  #include <unistd.h>
-#endif
-
-#include <type_traits>
-#include <memory>
-
-#include <xtd/exception.hpp>
-#include <xtd/string.hpp>
-#include <xtd/meta.hpp>
-#include <xtd/callback.hpp>
-
-#if (XTD_COMPILER_MSVC & XTD_COMPILER)
-  #pragma comment(lib, "ws2_32")
-#endif
-
-namespace xtd{
-
-    namespace socket{
-    /// @addtogroup Sockets
-    /// @{
-#if (!DOXY_INVOKED)
-#if (XTD_COMPILER_MINGW & XTD_COMPILER)
-    using POLLFD=WSAPOLLFD;
-#elif (XTD_OS_UNIX & XTD_OS)
-  using SOCKET = int;
-  #define closesocket close
-  #define ioctlsocket ioctl
-#elif (XTD_OS_WINDOWS & XTD_OS)
-    using POLLFD = pollfd;
-#endif
-#endif
-    ///Represents an socket error
-    class exception : public xtd::crt_exception{
-    public:
-      /// constructors
-      /// @{
-      exception(const source_location& loc, const xtd::string& swhat) : crt_exception(loc, swhat){}
-      exception(const exception& ex) : crt_exception(ex){}
-      explicit exception(exception&& ex) : crt_exception(std::move(ex)){}
-      /// @}
-
-      template <typename _return_t, typename _expression_t>
-      inline static _return_t _throw_if(const xtd::source_location& source, _return_t ret, _expression_t exp, const char* expstr){
-        if (exp(ret)){
-          throw exception(source, expstr);
-        }
-        return ret;
-      }
-
-    };
-
-#if (!DOXY_INVOKED)
-    namespace _{
-      template <typename _ty, int level, int optname> class socket_option{
-      public:
-        using value_type = _ty;
-        static value_type get(SOCKET s){
-          value_type iRet;
-#if  (XTD_COMPILER_MSVC & XTD_COMPILER)
-          int iSize = sizeof(value_type);
-#else
-          std::remove_pointer<typename xtd::template get_parameter<4, decltype(getsockopt)>::type>::type iSize = sizeof(value_type);
-#endif
-          socket::exception::throw_if(getsockopt(s, level, optname, reinterpret_cast<char*>(&iRet), &iSize), [](int i){ return (i<0); });
-          return iRet;
-        }
-        static void set(SOCKET s, value_type newval){
-          socket::exception::throw_if(setsockopt(s, level, optname, reinterpret_cast<char*>(&newval), sizeof(newval)), [](int i){ return (i<0); });
-        }
-      };
-      template <int level, int optname> class socket_option<std::string, level, optname>{
-      public:
-        using value_type = std::string;
-        static value_type get(SOCKET s){
-          value_type iRet;
-          int iSize = 0;
-          socket::exception::throw_if(getsockopt(s, level, optname, reinterpret_cast<char*>(&iRet), &iSize), [](int i){ return (i<0); });
-          return iRet;
-        }
-        static void set(SOCKET s, value_type newval){
-          socket::exception::throw_if(setsockopt(s, level, optname, reinterpret_cast<char*>(&newval), sizeof(newval)), [](int i){ return (i<0); });
-        }
-      };
-
-
-    }
-#endif
-
-    ///IPv4 address wrapper around sockaddr_in
-    class ipv4address : public sockaddr_in{
-    public:
-      /// ipv4 address familt
-      static const int address_family = AF_INET;
-      /**
-       * constructor
-       * @param sIP IP address
-       * @param iPort port
-       */
-      ipv4address(const char * sIP, uint16_t iPort){
-        #if (NTDDI_VERSION >= NTDDI_VISTA)
-          sin_family = AF_INET;
-          inet_pton(AF_INET, sIP, &sin_addr.s_addr);
-          sin_port = htons(iPort);
-        #else
-          sin_family = AF_INET;
-          sin_addr.s_addr = inet_addr(sIP);
-          sin_port = htons(iPort);
-        #endif
-      }
-      ipv4address(const ipv4address& src){
-        memcpy(this, &src, sizeof(ipv4address));
-      }
-      ipv4address& operator=(const ipv4address& src){
-        if (&src != this) memcpy(this, &src, sizeof(ipv4address));
-        return *this;
-      }
-    };
-
-    ///IPv6 address wrapper around sockaddr_in6
-    class ipv6address : public sockaddr_in6{
-    public:
-      /// ipv6 address family
-      static const int address_family = AF_INET6;
-      TODO("Implement proper ipv6 address");
-    };
-
-    /// socket communication styles
-    enum class socket_type{
-      stream = SOCK_STREAM, ///< stream reliable FIFO stream on a remote socket
-      datagram = SOCK_DGRAM, ///< datagram unreliable connectionless broadcast
-      raw = SOCK_RAW, ///< raw interface level data
-    };
-
-    /// IP based protocols
-    enum class socket_protocol{      
-      ip = IPPROTO_IP, ///< ip Internet Protocol v4      
-      icmp = IPPROTO_ICMP,///< icmp Internet Control Message Protocol      
-      tcp = IPPROTO_TCP,///< tcp Transmission Control Protocol     
-      udp = IPPROTO_UDP, ///< udp User Datagram Protocol
-      ipv6 = IPPROTO_IPV6, ///< ipv6 Internet Protocol v6
-    };
-    NOTE("add more socket protocols as needed defined in netinet/in.h")
-
-
-    TODO("Refactor out socket::serializer into something more universal")
-    ///Serializes data on a socket
-    template <typename> class serializer;
-
-#if (XTD_OS_WINDOWS & XTD_OS)
-    /** Initializes WinSock
-    Winsock requires a call to WSAStartup before any other calls to the winsock library.
-    winsock_initializer is a global static that ensures winsock is initialized and cleaned up properly
-    */
-    class winsock_initializer sealed{
-    public:
-      //singleton getter method
-      static winsock_initializer &get(){
-        static winsock_initializer oInit;
-        return oInit;
-      }
-      winsock_initializer(const winsock_initializer&) = delete;
-      winsock_initializer& operator=(const winsock_initializer&) = delete;
-    private:
-      winsock_initializer(){
-        WSADATA oData;
-        crt_exception::throw_if(WSAStartup(0x202, &oData), [](int err){ return 0 != err; });
-        if (oData.wVersion != 0x202) throw crt_exception(here(), "Invalid winsock version");
-      }
-
-      ~winsock_initializer(){ WSACleanup(); }
-    };
-#endif
-
-
-#if (!DOXY_INVOKED)
-    template<typename _address_t, socket_type, socket_protocol, template<class> class ... _policy_ts> class socket_base;
-
-
-    template<typename _address_t, socket_type _socket_t, socket_protocol _socket_protocol, template<class> class _head_t, template<class> class ..._tail_ts>
-    class socket_base<_address_t, _socket_t, _socket_protocol, _head_t, _tail_ts...> : public _head_t<socket_base<_address_t, _socket_t, _socket_protocol, _tail_ts...> >{
-    public:
-      template<typename ... _arg_ts> explicit socket_base(_arg_ts &&...oArgs) : _head_t<socket_base<_address_t, _socket_t, _socket_protocol, _tail_ts...> >(std::forward<_arg_ts>(oArgs)...){}
-    };
-#endif
-
-    /** Base class of the various socket specializations
-    Hierarchy generation TMP pattern to create all the socket object types with the various behavioral policies.
-     */
-    template<typename _address_t, socket_type _socket_t, socket_protocol _socket_protocol>
-    class socket_base<_address_t, _socket_t, _socket_protocol>{
-    public:
-
-      /// typedefs
-      /// @{
-      using unique_ptr = std::unique_ptr<socket_base>;
-      using shared_ptr = std::shared_ptr<socket_base>;
-      using address_type = _address_t;
-      /// @}
-
-      /// constants
-      /// @{
-      static constexpr socket_type type = _socket_t;
-      static constexpr socket_protocol protocol = _socket_protocol;
-      /// @}
-
-      /// dtor
-      ~socket_base(){ close(); }
-
-      /// constructors
-      /// @{
-      socket_base() : _socket(0){
-#if (XTD_OS_WINDOWS & XTD_OS)
-        winsock_initializer::get();
-#endif
-        _socket = xtd::crt_exception::throw_if(::socket(address_type::address_family, (int)type, (int)protocol), [](SOCKET s){ return static_cast<SOCKET>(-1) == s; });
-      }
-
-      explicit socket_base(socket_base&& src) : _socket(src._socket){
-        src._socket = 0;
-      }
-
-
-      explicit socket_base(SOCKET newval) : _socket(newval){}
-
-      socket_base(const socket_base&) = delete;
-      /// @}
-
-      /// copy-assignment not permitted
-      socket_base& operator=(const socket_base&) = delete;
-
-      /**
-       * move assignment
-       * @param src source socket
-       * @return *this
-       */
-      socket_base& operator=(socket_base&& src){
-        std::swap(_socket, src._socket);
-        return *this;
-      }
-
-      /**
-       * cast to native socket
-       * @return native socket value
-       */
-      operator SOCKET() const{ return _socket; }
-
-
-      /**
-       * writes data to the connected socket
-       * @param data the data to write
-       */
-      template <typename _ty> void write(const _ty& data){
-        serializer<_ty>::write(*this, data);
-      }
-
-      /**
-       * reads data from the connected socket
-       * @param data returned data
-       */
-      template <typename _ty> void read(_ty& data){
-        serializer<_ty>::read(*this, data);
-      }
-
-      /**
-       * reads data from the connected socket
-       * @return the data of type _Ty from the socket
-       */
-      template <typename _ty> _ty read(){
-        _ty data;
-        serializer<_ty>::read(*this, data);
-        return data;
-      }
-
-      /**
-       * Closes the open socket
-       */
-      void close(){
-        if (!_socket){
-          return;
-        }
-        ::closesocket(_socket);
-        _socket = -1;
-      }
-
-      /** sets the blocking mode of the socket
-       * @param blocking true to set to blocking mode
-       */
-      void set_blocking(bool blocking){
-        u_long val = (blocking ? 0 : 1);
-        xtd::crt_exception::throw_if(ioctlsocket(_socket, FIONBIO, &val), [](int i){ return i < 0; });
-      }
-
-      /** gets the number of bytes waiting in the read buffer
-       */
-      u_long bytes_available(){
-        u_long iRet=0;
-        xtd::crt_exception::throw_if(ioctlsocket(_socket, FIONREAD, &iRet), [](int i){ return i < 0; });
-        return iRet;
-      }
-
-      /**
-       * test if the socket is valid
-       */
-      bool is_valid() const{ return -1 != _socket; }
-
-    protected:
-      /// OS/CRT inner SOCKET that is being managed by this wrapper
-      SOCKET _socket;
-
-    };
-
-
-    ///Polling behavior policy
-    template <typename _super_t>
-    class polling_socket : public _super_t{
-    public:
-      /// callback event fires when data is ready to read data
-      callback<void()> read_event;
-      /// callback event fires when socket is ready to write data
-      callback<void()> write_event;
-      /// callback event fires when socket becomes disconnected
-      callback<void()> disconnect_event;
-      /// callback event fires when an error occurs
-      callback<void()> error_event;
-      /// begins polling the socket for events for a period of Timeout
-      void poll(int Timeout){
-        struct pollfd oPoll;
-        oPoll.events = POLLIN | POLLOUT;
-        oPoll.fd = _super_t::_socket;
-        oPoll.revents = 0;
-        if (0 == xtd::crt_exception::throw_if(::poll(&oPoll, 1, Timeout), [](int i){ return i < 0; })){
-          return;
-        }
-        if (oPoll.revents & POLLERR){
-          error_event();
-        }
-        if (oPoll.revents & POLLHUP){
-          disconnect_event();
-        }
-        if (oPoll.revents & POLLIN){
-          read_event();
-        }
-        if (oPoll.revents & POLLOUT){
-          write_event();
-        }
-      }
-      ///ctor
-      template<typename ... _arg_ts>
-      explicit polling_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-#if (XTD_OS_WINDOWS & XTD_OS)
-      int poll(POLLFD *ufds, unsigned int nfds, int timeout){ return ::WSAPoll(ufds, nfds, timeout); }
-#endif
-    };
-
-
-    ///Server side binding behavior
-    template <typename _super_t>
-    class bindable_socket : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit bindable_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-      /// binds the socket to an address and port
-      void bind(const typename _super_t::address_type& addr){
-        exception::throw_if(::bind(_super_t::_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(typename _super_t::address_type)), [](int i){ return i < 0; });
-      }
-    };
-
-
-    ///Client side connecting behavior
-    template <typename _super_t>
-    class connectable_socket : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit connectable_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-      /// initiates connection to a socket
-      void connect(const typename _super_t::address_type& addr){
-        exception::throw_if(::connect(_super_t::_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(typename _super_t::address_type)), [](int i){ return i < 0; });
-      }
-    };
-
-
-    ///Server side listening behavior
-    template <typename _super_t>
-    class listening_socket : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit listening_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-      /// begins listening on the socket
-      void listen(int Backlog = SOMAXCONN){
-        exception::throw_if(::listen(_super_t::_socket, Backlog), [](int i){ return i < 0; });
-      }
-
-      /// accepts an incoming connection request
-      template <typename _return_t>
-      _return_t accept(){
-        return _return_t(exception::throw_if(::accept(_super_t::_socket, nullptr, nullptr), [](SOCKET s){ return (s <= 0); }));
-      }
-    };
-
-    /// Socket properties
-    template <typename _super_t>
-    class socket_options : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit socket_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-      /// gets the SO_KEEPALIVE property
-      bool keep_alive() const{ return (_::socket_option<int, SOL_SOCKET, SO_KEEPALIVE>::get(_super_t::_socket) ? true : false); }
-      /// sets the SO_KEEPALIVE property
-      void keep_alive(bool newval){ _::socket_option<int, SOL_SOCKET, SO_KEEPALIVE>::set(_super_t::_socket, newval); }
-      TODO("Add more SOL_SOCKET options");
-    };
-
-    /// IP based socket properties
-    template <typename _super_t>
-    class ip_options : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit ip_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-#if (XTD_OS_WINDOWS & XTD_OS)
-      /// gets the IP_DONTFRAGMENT property
-      bool dont_fragment() const{ return (_::socket_option<int, IPPROTO_IP, IP_DONTFRAGMENT>::get(_super_t::_socket) ? true : false); }
-      /// sets the IP_DONTFRAGMENT property
-      void dont_fragment(bool newval){ _::socket_option<int, IPPROTO_IP, IP_DONTFRAGMENT>::set(_super_t::_socket, newval); }
-#endif
-      TODO("Add more IPPROTO_IP options");
-    };
-
-    /// TCP based socket properties
-    template <typename _super_t>
-    class tcp_options : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit tcp_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-      /// gets the TCP_NODELAY property
-      bool no_delay() const{ return (_::socket_option<int, IPPROTO_TCP, TCP_NODELAY>::get(_super_t::_socket) ? true : false); }
-      /// sets the TCP_NODELAY property
-      void no_delay(bool newval){ _::socket_option<int, IPPROTO_TCP, TCP_NODELAY>::set(_super_t::_socket, newval); }
-      TODO("Add more IPPROTO_TCP options");
-    };
-
-    /// UDP socket properties
-    template <typename _super_t>
-    class udp_options : public _super_t{
-    public:
-
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit udp_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
-
-#if (XTD_OS_WINDOWS & XTD_OS)
-      /// gets the UDP_NOCHECKSUM property
-      bool no_checksum() const{ return (_::socket_option<int, IPPROTO_UDP, UDP_NOCHECKSUM>::get(_super_t::_socket) ? true : false); }
-      /// sets the UDP_NOCHECKSUM property
-      void no_checksum(bool newval){ _::socket_option<int, IPPROTO_UDP, UDP_NOCHECKSUM>::set(_super_t::_socket, newval); }
-#endif
-      TODO("Add more IPPROTO_UDP options");
-    };
-
-
-    ///Async IO select behavior
-    template <typename _super_t>
-    class selectable_socket : public _super_t{
-    public:
-      /// ctor
-      template<typename ... _arg_ts>
-      explicit selectable_socket(_arg_ts&&...oArgs)
-        : _super_t(std::forward<_arg_ts>(oArgs)...), onRead(), onWrite(), onError() {}
-
-      /// callback event fired when data is ready to be read
-      xtd::callback<void()> onRead;
-      /// callback event fired when socket is ready to write
-      xtd::callback<void()> onWrite;
-      /// callback event fired when a socket error occurs
-      xtd::callback<void()> onError;
-
-      /// begin the select to wait for an event or timeout
-      bool select(int WaitMS){
-        timeval tv;
-        fd_set fdRead;
-        fd_set fdWrite;
-        fd_set fdErr;
-        FD_ZERO(&fdRead);
-        FD_ZERO(&fdWrite);
-        FD_ZERO(&fdErr);
-        FD_SET((SOCKET)*this, &fdRead);
-        FD_SET((SOCKET)*this, &fdWrite);
-        FD_SET((SOCKET)*this, &fdErr);
-        tv.tv_sec = WaitMS / 1000;
-        WaitMS %= 1000;
-        tv.tv_usec = WaitMS / 1000;
-#if (XTD_COMPILER_MINGW & XTD_COMPILER)
-        auto iRet = xtd::crt_exception::throw_if(::select(1 + (SOCKET)*this, &fdRead, &fdWrite, &fdErr, reinterpret_cast<PTIMEVAL>(&tv)), [](int i){return i < 0; });
-#else
-        auto iRet = xtd::crt_exception::throw_if(::select(static_cast<int>(1 + (SOCKET)*this), &fdRead, &fdWrite, &fdErr, &tv), [](int i){return i < 0; });
-#endif
-        if (0 == iRet){
-          return false;
-        }
-        if (FD_ISSET((SOCKET)*this, &fdErr)){
-          onError();
-        }
-        if (FD_ISSET((SOCKET)*this, &fdRead)){
-          onRead();
-        }
-        if (FD_ISSET((SOCKET)*this, &fdWrite)){
-          onWrite();
-        }
-        return true;
-      }
-    };
-
-#if (!DOXY_INVOKED)
-    TODO("Get rid of these")
-    template <typename _ty>
-    class serializer{
-    public:
-
-      template <typename _socket_t>
-      static void write(_socket_t& oSocket, const _ty& src){
-        static_assert(std::is_pod<_ty>::value, "no acceptable specialization for type");
-        exception::throw_if(::send(oSocket, reinterpret_cast<const char*>(&src), sizeof(_ty), 0), [](int i){ return i <= 0; });
-      }
-
-      template <typename _socket_t>
-      static void read(_socket_t& oSocket, _ty& src){
-        static_assert(std::is_pod<_ty>::value, "no acceptable specialization for type");
-        exception::throw_if(::recv(oSocket, reinterpret_cast<char*>(&src), sizeof(_ty), 0), [](int i){ return i <= 0; });
-      }
-    };
-
-
-    template <typename _ty>
-    class NON_POD_Vector_Serializer{
-    public:
-
-      template <typename _socket_t>
-      static void write(_socket_t& oSocket, const std::vector<_ty>& src){
-        serializer<typename std::vector<_ty>::size_type>::write(oSocket, src.size());
-        for (const auto & oItem : src){
-          serializer<_ty>::write(oSocket, oItem);
-        }
-      }
-
-      template <typename _socket_t>
-      static void read(_socket_t& oSocket, std::vector<_ty>& src){
-        typename std::vector<_ty>::size_type count;
-        serializer<typename std::vector<_ty>::size_type>::read(oSocket, count);
-        for (; count; --count){
-          _ty newval;
-          serializer<_ty>::read(oSocket, newval);
-          src.push_back(newval);
-        }
-      }
-    };
-
-
-    template <typename _ty>
-    class POD_Vector_Serializer{
-    public:
-
-      template <typename _socket_t >
-      static void write(_socket_t& oSocket, const std::vector<_ty>& src){
-        serializer<typename std::vector<_ty>::size_type>::write(oSocket, src.size());
-        send(oSocket, reinterpret_cast<const char*>(&src[0]), (int)(sizeof(_ty) * src.size()), 0);
-      }
-
-      template <typename _socket_t>
-      static void read(_socket_t& oSocket, std::vector<_ty>& src){
-        typename std::vector<_ty>::size_type count;
-        serializer<typename std::vector<_ty>::size_type>::read(oSocket, count);
-        src.resize(count);
-        recv(oSocket, reinterpret_cast<char*>(&src[0]), (int)(sizeof(_ty) * count), 0);
-      }
-
-    };
-
-
-    template <typename _ty>
-    class serializer<std::vector<_ty>> : public std::conditional<std::is_pod<_ty>::value, POD_Vector_Serializer<_ty>, NON_POD_Vector_Serializer<_ty>>::type{};
-#endif
-    /// General purpose IPV4 client and server socket type
-    using ipv4_tcp_stream = socket_base<ipv4address, socket_type::stream, socket_protocol::tcp, socket_options, ip_options, tcp_options, connectable_socket, bindable_socket, listening_socket, selectable_socket>;
-    /// General purpose UDP socket type
-    using ipv4_udp_socket = socket_base<ipv4address, socket_type::datagram, socket_protocol::udp, socket_options, ip_options, udp_options>;
-    ///@}
-
-  }
-
-}
+/** @file
+general purpose socket communication
+@copyright David Mott (c) 2016. Distributed under the Boost Software License Version 1.0. See LICENSE.md or http://boost.org/LICENSE_1_0.txt for details.
+*/
+
+#pragma once
+#include <xtd/xtd.hpp>
+
+#if (XTD_OS_WINDOWS & XTD_OS)
+  #include <Ws2ipdef.h>
+  #include <ws2tcpip.h>
+  static_assert(_WIN32_WINNT >= 0x500, "unsupported target Windows version");
+  #define poll WSAPoll
+#endif
+
+#if (XTD_COMPILER_MINGW & XTD_COMPILER)
+  #include <mswsock.h>
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS)
+  #include <sys/socket.h>
+  #include <sys/ioctl.h>
+  #include <netinet/in.h>
+  #include <netinet/udp.h>
+  #include <netinet/tcp.h>
+  #include <arpa/inet.h>
+  #include <poll.h>
+  #include <unistd.h>
+  #include <sys/un.h>
+  #include <sys/uio.h>
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+  #include <sys/sendfile.h>
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <linux/filter.h>
+  #include <linux/errqueue.h>
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+#include <type_traits>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <xtd/exception.hpp>
+#include <xtd/string.hpp>
+#include <xtd/meta.hpp>
+#include <xtd/callback.hpp>
+
+#if (XTD_COMPILER_MSVC & XTD_COMPILER)
+  #pragma comment(lib, "ws2_32")
+#endif
+
+#if !defined(XTD_CPP_COROUTINES)
+  #if defined(__cpp_impl_coroutine) && (__cplusplus >= 202002L)
+    #define XTD_CPP_COROUTINES 1
+  #else
+    #define XTD_CPP_COROUTINES 0
+  #endif
+#endif
+
+#if (XTD_CPP_COROUTINES)
+  #include <coroutine>
+#endif
+
+namespace xtd{
+
+    namespace socket{
+    /// @addtogroup Sockets
+    /// @{
+#if (!DOXY_INVOKED)
+#if (XTD_COMPILER_MINGW & XTD_COMPILER)
+    using POLLFD=WSAPOLLFD;
+#elif (XTD_OS_UNIX & XTD_OS)
+  using SOCKET = int;
+  #define closesocket close
+  #define ioctlsocket ioctl
+#elif (XTD_OS_WINDOWS & XTD_OS)
+    using POLLFD = pollfd;
+#endif
+#endif
+    ///Represents an socket error
+    class exception : public xtd::crt_exception{
+    public:
+      /// constructors
+      /// @{
+      exception(const source_location& loc, const xtd::string& swhat) : crt_exception(loc, swhat){}
+      exception(const exception& ex) : crt_exception(ex){}
+      explicit exception(exception&& ex) : crt_exception(std::move(ex)){}
+      /// @}
+
+      template <typename _return_t, typename _expression_t>
+      inline static _return_t _throw_if(const xtd::source_location& source, _return_t ret, _expression_t exp, const char* expstr){
+        if (exp(ret)){
+          throw exception(source, expstr);
+        }
+        return ret;
+      }
+
+    };
+
+#if (!DOXY_INVOKED)
+    namespace _{
+      template <typename _ty, int level, int optname> class socket_option{
+      public:
+        using value_type = _ty;
+        static value_type get(SOCKET s){
+          value_type iRet;
+#if  (XTD_COMPILER_MSVC & XTD_COMPILER)
+          int iSize = sizeof(value_type);
+#else
+          std::remove_pointer<typename xtd::template get_parameter<4, decltype(getsockopt)>::type>::type iSize = sizeof(value_type);
+#endif
+          socket::exception::throw_if(getsockopt(s, level, optname, reinterpret_cast<char*>(&iRet), &iSize), [](int i){ return (i<0); });
+          return iRet;
+        }
+        static void set(SOCKET s, value_type newval){
+          socket::exception::throw_if(setsockopt(s, level, optname, reinterpret_cast<char*>(&newval), sizeof(newval)), [](int i){ return (i<0); });
+        }
+      };
+      template <int level, int optname> class socket_option<std::string, level, optname>{
+      public:
+        using value_type = std::string;
+        static value_type get(SOCKET s){
+          value_type iRet;
+          int iSize = 0;
+          socket::exception::throw_if(getsockopt(s, level, optname, reinterpret_cast<char*>(&iRet), &iSize), [](int i){ return (i<0); });
+          return iRet;
+        }
+        static void set(SOCKET s, value_type newval){
+          socket::exception::throw_if(setsockopt(s, level, optname, reinterpret_cast<char*>(&newval), sizeof(newval)), [](int i){ return (i<0); });
+        }
+      };
+
+      /// flags added to every send so a closed peer raises an exception instead of SIGPIPE
+#if defined(MSG_NOSIGNAL)
+      static constexpr int send_flags = MSG_NOSIGNAL;
+#else
+      static constexpr int send_flags = 0;
+#endif
+
+      /// flag that tells the stack more data follows so it can coalesce segments
+#if defined(MSG_MORE)
+      static constexpr int more_flag = MSG_MORE;
+#else
+      static constexpr int more_flag = 0;
+#endif
+
+      /// true if the last socket call failed with an interrupted system call
+      inline bool interrupted(){
+#if (XTD_OS_WINDOWS & XTD_OS)
+        return WSAEINTR == WSAGetLastError();
+#else
+        return EINTR == errno;
+#endif
+      }
+    }
+#endif
+
+#if (XTD_OS_WINDOWS & XTD_OS)
+    /// scatter/gather buffer descriptor matching the layout of the posix iovec
+    struct iovec{
+      void * iov_base;
+      size_t iov_len;
+    };
+#endif
+
+#if (!DOXY_INVOKED)
+    namespace _{
+      /** collects the pieces of a serialized value so they can be sent with a single gathering write
+      Small pieces are copied into a contiguous staging area while large blocks are referenced in place so vectors of POD are never copied.
+      */
+      class gather_buffer{
+      public:
+        /// blocks smaller than this are copied into the staging area
+        static constexpr size_t copy_threshold = 512;
+
+        /// appends a block of memory to the outgoing data
+        void append(const void * pData, size_t iLen){
+          if (!iLen){
+            return;
+          }
+          if (iLen < copy_threshold){
+            if (_segments.empty() || _segments.back().data){
+              _segments.push_back(segment{ nullptr, _staging.size(), 0 });
+            }
+            _staging.insert(_staging.end(), static_cast<const char*>(pData), static_cast<const char*>(pData) + iLen);
+            _segments.back().len += iLen;
+          } else{
+            _segments.push_back(segment{ static_cast<const char*>(pData), 0, iLen });
+          }
+        }
+
+        /// appends a POD value
+        template <typename _ty> void append(const _ty& value){
+          static_assert(std::is_pod<_ty>::value, "gather_buffer only appends POD values");
+          append(&value, sizeof(_ty));
+        }
+
+        /// copies the collected data into one contiguous block and empties the buffer
+        std::vector<char> flatten(){
+          std::vector<char> oRet;
+          oRet.reserve(size());
+          for (const auto & oSegment : _segments){
+            auto pBegin = oSegment.data ? oSegment.data : &_staging[oSegment.offset];
+            oRet.insert(oRet.end(), pBegin, pBegin + oSegment.len);
+          }
+          _segments.clear();
+          _staging.clear();
+          return oRet;
+        }
+
+        /// total number of bytes collected
+        size_t size() const{
+          size_t iRet = 0;
+          for (const auto & oSegment : _segments) iRet += oSegment.len;
+          return iRet;
+        }
+
+        /// sends the collected data on the socket and empties the buffer
+        template <typename _socket_t> void flush(_socket_t& oSocket, int flags = 0){
+          std::vector<iovec> oVectors;
+          oVectors.reserve(_segments.size());
+          for (const auto & oSegment : _segments){
+            iovec oVec;
+            oVec.iov_base = const_cast<char*>(oSegment.data ? oSegment.data : &_staging[oSegment.offset]);
+            oVec.iov_len = oSegment.len;
+            oVectors.push_back(oVec);
+          }
+          _segments.clear();
+          _staging.clear();
+          if (!oVectors.empty()){
+            oSocket.writev(&oVectors[0], oVectors.size(), flags);
+          }
+        }
+
+      private:
+        struct segment{
+          const char * data;
+          size_t offset;
+          size_t len;
+        };
+        std::vector<char> _staging;
+        std::vector<segment> _segments;
+      };
+    }
+#endif
+
+    ///IPv4 address wrapper around sockaddr_in
+    class ipv4address : public sockaddr_in{
+    public:
+      /// ipv4 address familt
+      static const int address_family = AF_INET;
+      /**
+       * constructor
+       * @param sIP IP address
+       * @param iPort port
+       */
+      ipv4address(const char * sIP, uint16_t iPort){
+        #if (NTDDI_VERSION >= NTDDI_VISTA)
+          sin_family = AF_INET;
+          inet_pton(AF_INET, sIP, &sin_addr.s_addr);
+          sin_port = htons(iPort);
+        #else
+          sin_family = AF_INET;
+          sin_addr.s_addr = inet_addr(sIP);
+          sin_port = htons(iPort);
+        #endif
+      }
+      ipv4address(const ipv4address& src){
+        memcpy(this, &src, sizeof(ipv4address));
+      }
+      ipv4address& operator=(const ipv4address& src){
+        if (&src != this) memcpy(this, &src, sizeof(ipv4address));
+        return *this;
+      }
+    };
+
+#if (XTD_OS_UNIX & XTD_OS)
+    ///Unix domain socket address wrapper around sockaddr_un
+    class unix_address : public sockaddr_un{
+    public:
+      /// unix domain address family
+      static const int address_family = AF_UNIX;
+      /**
+       * constructor
+       * @param sPath file system path of the socket, truncated to fit sun_path
+       */
+      explicit unix_address(const char * sPath){
+        memset(static_cast<sockaddr_un*>(this), 0, sizeof(sockaddr_un));
+        sun_family = AF_UNIX;
+        strncpy(sun_path, sPath, sizeof(sun_path) - 1);
+      }
+      unix_address(const unix_address& src){
+        memcpy(this, &src, sizeof(unix_address));
+      }
+      unix_address& operator=(const unix_address& src){
+        if (&src != this) memcpy(this, &src, sizeof(unix_address));
+        return *this;
+      }
+    };
+#endif
+
+    ///IPv6 address wrapper around sockaddr_in6
+    class ipv6address : public sockaddr_in6{
+    public:
+      /// ipv6 address family
+      static const int address_family = AF_INET6;
+      TODO("Implement proper ipv6 address");
+    };
+
+    /// socket communication styles
+    enum class socket_type{
+      stream = SOCK_STREAM, ///< stream reliable FIFO stream on a remote socket
+      datagram = SOCK_DGRAM, ///< datagram unreliable connectionless broadcast
+      raw = SOCK_RAW, ///< raw interface level data
+    };
+
+    /// IP based protocols
+    enum class socket_protocol{      
+      ip = IPPROTO_IP, ///< ip Internet Protocol v4      
+      icmp = IPPROTO_ICMP,///< icmp Internet Control Message Protocol      
+      tcp = IPPROTO_TCP,///< tcp Transmission Control Protocol     
+      udp = IPPROTO_UDP, ///< udp User Datagram Protocol
+      ipv6 = IPPROTO_IPV6, ///< ipv6 Internet Protocol v6
+    };
+    NOTE("add more socket protocols as needed defined in netinet/in.h")
+
+
+    TODO("Refactor out socket::serializer into something more universal")
+    ///Serializes data on a socket
+    template <typename> class serializer;
+
+#if (XTD_OS_WINDOWS & XTD_OS)
+    /** Initializes WinSock
+    Winsock requires a call to WSAStartup before any other calls to the winsock library.
+    winsock_initializer is a global static that ensures winsock is initialized and cleaned up properly
+    */
+    class winsock_initializer sealed{
+    public:
+      //singleton getter method
+      static winsock_initializer &get(){
+        static winsock_initializer oInit;
+        return oInit;
+      }
+      winsock_initializer(const winsock_initializer&) = delete;
+      winsock_initializer& operator=(const winsock_initializer&) = delete;
+    private:
+      winsock_initializer(){
+        WSADATA oData;
+        crt_exception::throw_if(WSAStartup(0x202, &oData), [](int err){ return 0 != err; });
+        if (oData.wVersion != 0x202) throw crt_exception(here(), "Invalid winsock version");
+      }
+
+      ~winsock_initializer(){ WSACleanup(); }
+    };
+#endif
+
+
+#if (!DOXY_INVOKED)
+    template<typename _address_t, socket_type, socket_protocol, template<class> class ... _policy_ts> class socket_base;
+
+
+    template<typename _address_t, socket_type _socket_t, socket_protocol _socket_protocol, template<class> class _head_t, template<class> class ..._tail_ts>
+    class socket_base<_address_t, _socket_t, _socket_protocol, _head_t, _tail_ts...> : public _head_t<socket_base<_address_t, _socket_t, _socket_protocol, _tail_ts...> >{
+    public:
+      template<typename ... _arg_ts> explicit socket_base(_arg_ts &&...oArgs) : _head_t<socket_base<_address_t, _socket_t, _socket_protocol, _tail_ts...> >(std::forward<_arg_ts>(oArgs)...){}
+    };
+#endif
+
+    /** Base class of the various socket specializations
+    Hierarchy generation TMP pattern to create all the socket object types with the various behavioral policies.
+     */
+    template<typename _address_t, socket_type _socket_t, socket_protocol _socket_protocol>
+    class socket_base<_address_t, _socket_t, _socket_protocol>{
+    public:
+
+      /// typedefs
+      /// @{
+      using unique_ptr = std::unique_ptr<socket_base>;
+      using shared_ptr = std::shared_ptr<socket_base>;
+      using address_type = _address_t;
+      /// @}
+
+      /// constants
+      /// @{
+      static constexpr socket_type type = _socket_t;
+      static constexpr socket_protocol protocol = _socket_protocol;
+      /// @}
+
+      /// dtor
+      ~socket_base(){ close(); }
+
+      /// constructors
+      /// @{
+      socket_base() : _socket(0){
+#if (XTD_OS_WINDOWS & XTD_OS)
+        winsock_initializer::get();
+#endif
+        _socket = xtd::crt_exception::throw_if(::socket(address_type::address_family, (int)type, (int)protocol), [](SOCKET s){ return static_cast<SOCKET>(-1) == s; });
+      }
+
+      explicit socket_base(socket_base&& src) : _socket(src._socket){
+        src._socket = 0;
+      }
+
+
+      explicit socket_base(SOCKET newval) : _socket(newval){}
+
+      socket_base(const socket_base&) = delete;
+      /// @}
+
+      /// copy-assignment not permitted
+      socket_base& operator=(const socket_base&) = delete;
+
+      /**
+       * move assignment
+       * @param src source socket
+       * @return *this
+       */
+      socket_base& operator=(socket_base&& src){
+        std::swap(_socket, src._socket);
+        return *this;
+      }
+
+      /**
+       * cast to native socket
+       * @return native socket value
+       */
+      operator SOCKET() const{ return _socket; }
+
+
+      /**
+       * writes data to the connected socket
+       * @param data the data to write
+       * @param more true if more data will follow immediately so the stack may coalesce it with the next write
+       */
+      template <typename _ty> void write(const _ty& data, bool more = false){
+        serializer<_ty>::write(*this, data, more ? _::more_flag : 0);
+      }
+
+      /**
+       * reads data from the connected socket
+       * @param data returned data
+       */
+      template <typename _ty> void read(_ty& data){
+        serializer<_ty>::read(*this, data);
+      }
+
+      /**
+       * reads data from the connected socket
+       * @return the data of type _Ty from the socket
+       */
+      template <typename _ty> _ty read(){
+        _ty data;
+        serializer<_ty>::read(*this, data);
+        return data;
+      }
+
+      /**
+       * sends an entire buffer, retrying partial writes and interrupted calls
+       * @param pData the data to send
+       * @param iLen number of bytes to send
+       * @param flags additional send flags such as MSG_MORE
+       */
+      void send_all(const void * pData, size_t iLen, int flags = 0){
+        auto pBegin = static_cast<const char*>(pData);
+        while (iLen){
+          auto iChunk = static_cast<int>(std::min<size_t>(iLen, INT_MAX));
+          auto iSent = ::send(_socket, pBegin, iChunk, flags | _::send_flags);
+          if (iSent < 0 && _::interrupted()){
+            continue;
+          }
+          exception::throw_if(iSent, [](decltype(iSent) i){ return i <= 0; });
+          pBegin += iSent;
+          iLen -= static_cast<size_t>(iSent);
+        }
+      }
+
+      /**
+       * receives exactly iLen bytes, retrying partial reads and interrupted calls
+       * @param pData destination buffer
+       * @param iLen number of bytes to receive
+       */
+      void recv_all(void * pData, size_t iLen){
+        auto pBegin = static_cast<char*>(pData);
+        while (iLen){
+          auto iChunk = static_cast<int>(std::min<size_t>(iLen, INT_MAX));
+          auto iRead = ::recv(_socket, pBegin, iChunk, MSG_WAITALL);
+          if (iRead < 0 && _::interrupted()){
+            continue;
+          }
+          exception::throw_if(iRead, [](decltype(iRead) i){ return i <= 0; });
+          pBegin += iRead;
+          iLen -= static_cast<size_t>(iRead);
+        }
+      }
+
+      /**
+       * gathering write of several buffers, retrying partial writes until everything is sent
+       * @param pVectors buffers to send in order. The array is modified to track progress.
+       * @param iCount number of buffers
+       * @param flags additional send flags such as MSG_MORE
+       */
+      void writev(iovec * pVectors, size_t iCount, int flags = 0){
+#if (XTD_OS_UNIX & XTD_OS)
+        while (iCount){
+          msghdr oMsg;
+          memset(&oMsg, 0, sizeof(oMsg));
+          oMsg.msg_iov = pVectors;
+          oMsg.msg_iovlen = std::min<size_t>(iCount, IOV_MAX);
+          auto iSent = ::sendmsg(_socket, &oMsg, flags | _::send_flags);
+          if (iSent < 0 && _::interrupted()){
+            continue;
+          }
+          exception::throw_if(iSent, [](ssize_t i){ return i < 0; });
+          _advance(pVectors, iCount, static_cast<size_t>(iSent));
+        }
+#else
+        for (; iCount; ++pVectors, --iCount){
+          send_all(pVectors->iov_base, pVectors->iov_len, flags);
+        }
+#endif
+      }
+
+      /**
+       * scattering read that fills every buffer completely, retrying partial reads
+       * @param pVectors buffers to fill in order. The array is modified to track progress.
+       * @param iCount number of buffers
+       */
+      void readv(iovec * pVectors, size_t iCount){
+#if (XTD_OS_UNIX & XTD_OS)
+        while (iCount){
+          msghdr oMsg;
+          memset(&oMsg, 0, sizeof(oMsg));
+          oMsg.msg_iov = pVectors;
+          oMsg.msg_iovlen = std::min<size_t>(iCount, IOV_MAX);
+          auto iRead = ::recvmsg(_socket, &oMsg, MSG_WAITALL);
+          if (iRead < 0 && _::interrupted()){
+            continue;
+          }
+          exception::throw_if(iRead, [](ssize_t i){ return i <= 0; });
+          _advance(pVectors, iCount, static_cast<size_t>(iRead));
+        }
+#else
+        for (; iCount; ++pVectors, --iCount){
+          recv_all(pVectors->iov_base, pVectors->iov_len);
+        }
+#endif
+      }
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+      /**
+       * sends a region of a file directly from the page cache without copying it through user space
+       * @param iFile open file descriptor, such as the one backing a mapped_file
+       * @param iOffset starting offset in the file
+       * @param iLen number of bytes to send
+       */
+      void send_file(int iFile, off_t iOffset, size_t iLen){
+        while (iLen){
+          auto iSent = ::sendfile(_socket, iFile, &iOffset, iLen);
+          if (iSent < 0 && _::interrupted()){
+            continue;
+          }
+          exception::throw_if(iSent, [](ssize_t i){ return i <= 0; });
+          iLen -= static_cast<size_t>(iSent);
+        }
+      }
+#endif
+
+      /**
+       * Closes the open socket
+       */
+      void close(){
+        if (!_socket){
+          return;
+        }
+        ::closesocket(_socket);
+        _socket = -1;
+      }
+
+      /** sets the blocking mode of the socket
+       * @param blocking true to set to blocking mode
+       */
+      void set_blocking(bool blocking){
+        u_long val = (blocking ? 0 : 1);
+        xtd::crt_exception::throw_if(ioctlsocket(_socket, FIONBIO, &val), [](int i){ return i < 0; });
+      }
+
+      /** gets the number of bytes waiting in the read buffer
+       */
+      u_long bytes_available(){
+        u_long iRet=0;
+        xtd::crt_exception::throw_if(ioctlsocket(_socket, FIONREAD, &iRet), [](int i){ return i < 0; });
+        return iRet;
+      }
+
+      /**
+       * test if the socket is valid
+       */
+      bool is_valid() const{ return -1 != _socket; }
+
+    protected:
+      /// OS/CRT inner SOCKET that is being managed by this wrapper
+      SOCKET _socket;
+
+    private:
+      /// consumes iLen completed bytes from the front of an iovec array
+      static void _advance(iovec *& pVectors, size_t& iCount, size_t iLen){
+        while (iCount && iLen >= pVectors->iov_len){
+          iLen -= pVectors->iov_len;
+          ++pVectors;
+          --iCount;
+        }
+        if (iCount){
+          pVectors->iov_base = static_cast<char*>(pVectors->iov_base) + iLen;
+          pVectors->iov_len -= iLen;
+        }
+      }
+
+    };
+
+
+    ///Polling behavior policy
+    template <typename _super_t>
+    class polling_socket : public _super_t{
+    public:
+      /// callback event fires when data is ready to read data
+      callback<void()> read_event;
+      /// callback event fires when socket is ready to write data
+      callback<void()> write_event;
+      /// callback event fires when socket becomes disconnected
+      callback<void()> disconnect_event;
+      /// callback event fires when an error occurs
+      callback<void()> error_event;
+      /// begins polling the socket for events for a period of Timeout
+      void poll(int Timeout){
+        struct pollfd oPoll;
+        oPoll.events = POLLIN | POLLOUT;
+        oPoll.fd = _super_t::_socket;
+        oPoll.revents = 0;
+        if (0 == xtd::crt_exception::throw_if(::poll(&oPoll, 1, Timeout), [](int i){ return i < 0; })){
+          return;
+        }
+        if (oPoll.revents & POLLERR){
+          error_event();
+        }
+        if (oPoll.revents & POLLHUP){
+          disconnect_event();
+        }
+        if (oPoll.revents & POLLIN){
+          read_event();
+        }
+        if (oPoll.revents & POLLOUT){
+          write_event();
+        }
+      }
+      ///ctor
+      template<typename ... _arg_ts>
+      explicit polling_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+#if (XTD_OS_WINDOWS & XTD_OS)
+      int poll(POLLFD *ufds, unsigned int nfds, int timeout){ return ::WSAPoll(ufds, nfds, timeout); }
+#endif
+    };
+
+
+    ///Server side binding behavior
+    template <typename _super_t>
+    class bindable_socket : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit bindable_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+      /// binds the socket to an address and port
+      void bind(const typename _super_t::address_type& addr){
+        exception::throw_if(::bind(_super_t::_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(typename _super_t::address_type)), [](int i){ return i < 0; });
+      }
+    };
+
+
+    ///Client side connecting behavior
+    template <typename _super_t>
+    class connectable_socket : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit connectable_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+      /// initiates connection to a socket
+      void connect(const typename _super_t::address_type& addr){
+        exception::throw_if(::connect(_super_t::_socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(typename _super_t::address_type)), [](int i){ return i < 0; });
+      }
+    };
+
+
+    ///Server side listening behavior
+    template <typename _super_t>
+    class listening_socket : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit listening_socket(_arg_ts &&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+      /// begins listening on the socket
+      void listen(int Backlog = SOMAXCONN){
+        exception::throw_if(::listen(_super_t::_socket, Backlog), [](int i){ return i < 0; });
+      }
+
+      /// accepts an incoming connection request
+      template <typename _return_t>
+      _return_t accept(){
+        return _return_t(exception::throw_if(_accept(0), [](SOCKET s){ return (s <= 0); }));
+      }
+
+      /** accepts an incoming connection request on a non-blocking listener
+      @return the new connection or nullptr if no connection is pending
+      */
+      template <typename _return_t>
+      std::unique_ptr<_return_t> try_accept(){
+        forever{
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+          auto hSocket = _accept(SOCK_NONBLOCK);
+#else
+          auto hSocket = _accept(0);
+#endif
+          if (static_cast<SOCKET>(-1) != hSocket){
+            return std::unique_ptr<_return_t>(new _return_t(hSocket));
+          }
+          if (_::interrupted()){
+            continue;
+          }
+#if (XTD_OS_WINDOWS & XTD_OS)
+          if (WSAEWOULDBLOCK == WSAGetLastError()){
+#else
+          if (EAGAIN == errno || EWOULDBLOCK == errno){
+#endif
+            return nullptr;
+          }
+          throw exception(here(), "accept failed");
+        }
+      }
+
+    protected:
+      /// accepts with accept4 on linux so the new descriptor is close-on-exec and optionally non-blocking without extra fcntl calls
+      SOCKET _accept(int flags){
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+        return ::accept4(_super_t::_socket, nullptr, nullptr, flags | SOCK_CLOEXEC);
+#else
+        (void)flags;
+        return ::accept(_super_t::_socket, nullptr, nullptr);
+#endif
+      }
+    };
+
+    /// Socket properties
+    template <typename _super_t>
+    class socket_options : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit socket_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+      /// gets the SO_KEEPALIVE property
+      bool keep_alive() const{ return (_::socket_option<int, SOL_SOCKET, SO_KEEPALIVE>::get(_super_t::_socket) ? true : false); }
+      /// sets the SO_KEEPALIVE property
+      void keep_alive(bool newval){ _::socket_option<int, SOL_SOCKET, SO_KEEPALIVE>::set(_super_t::_socket, newval); }
+      /// gets the SO_REUSEADDR property
+      bool reuse_address() const{ return (_::socket_option<int, SOL_SOCKET, SO_REUSEADDR>::get(_super_t::_socket) ? true : false); }
+      /// sets the SO_REUSEADDR property
+      void reuse_address(bool newval){ _::socket_option<int, SOL_SOCKET, SO_REUSEADDR>::set(_super_t::_socket, newval); }
+#if (XTD_OS_UNIX & XTD_OS) && defined(SO_REUSEPORT)
+      /// gets the SO_REUSEPORT property
+      bool reuse_port() const{ return (_::socket_option<int, SOL_SOCKET, SO_REUSEPORT>::get(_super_t::_socket) ? true : false); }
+      /// sets the SO_REUSEPORT property so several sockets can bind the same address and share its incoming connections
+      void reuse_port(bool newval){ _::socket_option<int, SOL_SOCKET, SO_REUSEPORT>::set(_super_t::_socket, newval); }
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_INCOMING_CPU)
+      /// gets the SO_INCOMING_CPU property
+      int incoming_cpu() const{ return _::socket_option<int, SOL_SOCKET, SO_INCOMING_CPU>::get(_super_t::_socket); }
+      /// sets the SO_INCOMING_CPU property, preferring this socket of a SO_REUSEPORT group for packets processed on the CPU
+      void incoming_cpu(int newval){ _::socket_option<int, SOL_SOCKET, SO_INCOMING_CPU>::set(_super_t::_socket, newval); }
+#endif
+      /// gets the SO_SNDBUF property
+      int send_buffer_size() const{ return _::socket_option<int, SOL_SOCKET, SO_SNDBUF>::get(_super_t::_socket); }
+      /// sets the SO_SNDBUF property
+      void send_buffer_size(int newval){ _::socket_option<int, SOL_SOCKET, SO_SNDBUF>::set(_super_t::_socket, newval); }
+      /// gets the SO_RCVBUF property
+      int receive_buffer_size() const{ return _::socket_option<int, SOL_SOCKET, SO_RCVBUF>::get(_super_t::_socket); }
+      /// sets the SO_RCVBUF property
+      void receive_buffer_size(int newval){ _::socket_option<int, SOL_SOCKET, SO_RCVBUF>::set(_super_t::_socket, newval); }
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_BUSY_POLL)
+      /// gets the SO_BUSY_POLL property
+      int busy_poll() const{ return _::socket_option<int, SOL_SOCKET, SO_BUSY_POLL>::get(_super_t::_socket); }
+      /// sets the SO_BUSY_POLL property, microseconds to busy poll the device queue on blocking receives
+      void busy_poll(int newval){ _::socket_option<int, SOL_SOCKET, SO_BUSY_POLL>::set(_super_t::_socket, newval); }
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+      /// gets the SO_ZEROCOPY property
+      bool zero_copy() const{ return (_::socket_option<int, SOL_SOCKET, SO_ZEROCOPY>::get(_super_t::_socket) ? true : false); }
+      /// sets the SO_ZEROCOPY property which must be enabled before send_zero_copy
+      void zero_copy(bool newval){ _::socket_option<int, SOL_SOCKET, SO_ZEROCOPY>::set(_super_t::_socket, newval); }
+
+      /** sends a buffer with MSG_ZEROCOPY so the kernel transmits directly from user pages
+      Zero copy only pays off for large sends, typically above 10KB. When the socket's pinned page budget runs out the rest
+      of the buffer is copied, possibly all of it.
+      @param iLast receives the id of the last zero copy send used for the buffer when the return value is true
+      @return true if any part of the buffer went out zero copy, in which case it must not be modified or freed until
+      reap_zero_copy reports iLast as complete. false if the whole buffer was copied and may be reused at once.
+      */
+      bool send_zero_copy(const void * pData, size_t iLen, uint32_t& iLast){
+        auto pBegin = static_cast<const char*>(pData);
+        bool bRet = false;
+        while (iLen){
+          auto iSent = ::send(_super_t::_socket, pBegin, iLen, MSG_ZEROCOPY | _::send_flags);
+          if (iSent < 0 && _::interrupted()){
+            continue;
+          }
+          if (iSent < 0 && ENOBUFS == errno){
+            //the socket's pinned page budget is exhausted so copy the rest
+            _super_t::send_all(pBegin, iLen);
+            break;
+          }
+          exception::throw_if(iSent, [](ssize_t i){ return i <= 0; });
+          iLast = _zero_copy_sends++;
+          bRet = true;
+          pBegin += iSent;
+          iLen -= static_cast<size_t>(iSent);
+        }
+        return bRet;
+      }
+
+      /** collects zero copy completion notifications from the error queue without blocking
+      @param iCompleted receives the highest id known to be complete
+      @param bCopied set to true if the kernel fell back to copying, as it does on loopback, in which case zero copy isn't worth using on this route
+      @return true if any completions were collected
+      */
+      bool reap_zero_copy(uint32_t& iCompleted, bool& bCopied){
+        bool bRet = false;
+        forever{
+          char oControl[128];
+          msghdr oMsg;
+          memset(&oMsg, 0, sizeof(oMsg));
+          oMsg.msg_control = oControl;
+          oMsg.msg_controllen = sizeof(oControl);
+          if (::recvmsg(_super_t::_socket, &oMsg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0){
+            if (_::interrupted()){
+              continue;
+            }
+            return bRet;
+          }
+          for (auto pHeader = CMSG_FIRSTHDR(&oMsg); pHeader; pHeader = CMSG_NXTHDR(&oMsg, pHeader)){
+            if (!((SOL_IP == pHeader->cmsg_level && IP_RECVERR == pHeader->cmsg_type) || (SOL_IPV6 == pHeader->cmsg_level && IPV6_RECVERR == pHeader->cmsg_type))){
+              continue;
+            }
+            sock_extended_err oError;
+            memcpy(&oError, CMSG_DATA(pHeader), sizeof(oError));
+            if (SO_EE_ORIGIN_ZEROCOPY != oError.ee_origin || oError.ee_errno){
+              continue;
+            }
+            iCompleted = oError.ee_data;
+            bCopied |= (0 != (oError.ee_code & SO_EE_CODE_ZEROCOPY_COPIED));
+            bRet = true;
+          }
+        }
+      }
+#endif
+      /* SOL_SOCKET options intentionally left out:
+      SO_LINGER takes a struct linger and only matters when closing, which the socket destructor owns.
+      SO_RCVTIMEO and SO_SNDTIMEO are covered by poll and the reactor rather than blocking calls with timeouts.
+      SO_BROADCAST only applies to datagram sockets.
+      SO_MARK needs CAP_NET_ADMIN.
+      SO_ATTACH_FILTER and SO_ATTACH_REUSEPORT_CBPF take programs rather than values; listener_group::steer_by_cpu sets the latter itself.
+      */
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    private:
+      uint32_t _zero_copy_sends = 0;
+#endif
+    };
+
+    /// IP based socket properties
+    template <typename _super_t>
+    class ip_options : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit ip_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+#if (XTD_OS_WINDOWS & XTD_OS)
+      /// gets the IP_DONTFRAGMENT property
+      bool dont_fragment() const{ return (_::socket_option<int, IPPROTO_IP, IP_DONTFRAGMENT>::get(_super_t::_socket) ? true : false); }
+      /// sets the IP_DONTFRAGMENT property
+      void dont_fragment(bool newval){ _::socket_option<int, IPPROTO_IP, IP_DONTFRAGMENT>::set(_super_t::_socket, newval); }
+#endif
+      TODO("Add more IPPROTO_IP options");
+    };
+
+    /// TCP based socket properties
+    template <typename _super_t>
+    class tcp_options : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit tcp_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+      /// gets the TCP_NODELAY property
+      bool no_delay() const{ return (_::socket_option<int, IPPROTO_TCP, TCP_NODELAY>::get(_super_t::_socket) ? true : false); }
+      /// sets the TCP_NODELAY property
+      void no_delay(bool newval){ _::socket_option<int, IPPROTO_TCP, TCP_NODELAY>::set(_super_t::_socket, newval); }
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+      /// gets the TCP_CORK property
+      bool cork() const{ return (_::socket_option<int, IPPROTO_TCP, TCP_CORK>::get(_super_t::_socket) ? true : false); }
+      /// sets the TCP_CORK property. While corked partial frames are held back until the cork is removed.
+      void cork(bool newval){ _::socket_option<int, IPPROTO_TCP, TCP_CORK>::set(_super_t::_socket, newval); }
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+      /// gets the TCP_QUICKACK property
+      bool quick_ack() const{ return (_::socket_option<int, IPPROTO_TCP, TCP_QUICKACK>::get(_super_t::_socket) ? true : false); }
+      /// sets the TCP_QUICKACK property. The kernel clears it again on its own so request/response loops set it after each receive.
+      void quick_ack(bool newval){ _::socket_option<int, IPPROTO_TCP, TCP_QUICKACK>::set(_super_t::_socket, newval); }
+      /// gets the TCP_DEFER_ACCEPT property
+      int defer_accept() const{ return _::socket_option<int, IPPROTO_TCP, TCP_DEFER_ACCEPT>::get(_super_t::_socket); }
+      /// sets the TCP_DEFER_ACCEPT property, seconds a listener waits for data before waking accept
+      void defer_accept(int newval){ _::socket_option<int, IPPROTO_TCP, TCP_DEFER_ACCEPT>::set(_super_t::_socket, newval); }
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(TCP_NOTSENT_LOWAT)
+      /// gets the TCP_NOTSENT_LOWAT property
+      int not_sent_lowat() const{ return _::socket_option<int, IPPROTO_TCP, TCP_NOTSENT_LOWAT>::get(_super_t::_socket); }
+      /// sets the TCP_NOTSENT_LOWAT property, the unsent bytes below which the socket reports writable
+      void not_sent_lowat(int newval){ _::socket_option<int, IPPROTO_TCP, TCP_NOTSENT_LOWAT>::set(_super_t::_socket, newval); }
+#endif
+#if defined(TCP_FASTOPEN)
+      /// gets the TCP_FASTOPEN property
+      int fast_open() const{ return _::socket_option<int, IPPROTO_TCP, TCP_FASTOPEN>::get(_super_t::_socket); }
+      /// sets the TCP_FASTOPEN property, the queue length of pending fast open requests on a listener
+      void fast_open(int newval){ _::socket_option<int, IPPROTO_TCP, TCP_FASTOPEN>::set(_super_t::_socket, newval); }
+#endif
+      TODO("Add more IPPROTO_TCP options");
+    };
+
+    /** A named set of tuning options applied together
+    Fields left at unchanged are not touched. Options the platform lacks are ignored.
+    */
+    struct socket_profile{
+      /// marks a field that apply leaves alone
+      static constexpr int unchanged = -1;
+
+      int send_buffer_size = unchanged; ///< SO_SNDBUF bytes
+      int receive_buffer_size = unchanged; ///< SO_RCVBUF bytes
+      int busy_poll = unchanged; ///< SO_BUSY_POLL microseconds
+      int zero_copy = unchanged; ///< SO_ZEROCOPY 0 or 1
+      int no_delay = unchanged; ///< TCP_NODELAY 0 or 1
+      int quick_ack = unchanged; ///< TCP_QUICKACK 0 or 1
+      int not_sent_lowat = unchanged; ///< TCP_NOTSENT_LOWAT bytes
+      int fast_open = unchanged; ///< TCP_FASTOPEN queue length, listeners only
+      int defer_accept = unchanged; ///< TCP_DEFER_ACCEPT seconds, listeners only
+
+      /// large buffers and zero copy sends for bulk transfer
+      static socket_profile throughput(){
+        socket_profile oRet;
+        oRet.send_buffer_size = 4 * 1024 * 1024;
+        oRet.receive_buffer_size = 4 * 1024 * 1024;
+        oRet.zero_copy = 1;
+        return oRet;
+      }
+
+      /// no batching delays and a shallow send queue for request/response traffic. busy_poll is left alone because raising it requires CAP_NET_ADMIN.
+      static socket_profile low_latency(){
+        socket_profile oRet;
+        oRet.no_delay = 1;
+        oRet.quick_ack = 1;
+        oRet.not_sent_lowat = 16 * 1024;
+        return oRet;
+      }
+
+      /// applies the profile to a socket. TCP options are only applied to TCP sockets.
+      template <typename _socket_t> void apply(_socket_t& oSocket) const{
+        SOCKET hSocket = oSocket;
+        _set<SOL_SOCKET, SO_SNDBUF>(hSocket, send_buffer_size);
+        _set<SOL_SOCKET, SO_RCVBUF>(hSocket, receive_buffer_size);
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_BUSY_POLL)
+        _set<SOL_SOCKET, SO_BUSY_POLL>(hSocket, busy_poll);
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_ZEROCOPY)
+        _set<SOL_SOCKET, SO_ZEROCOPY>(hSocket, zero_copy);
+#endif
+        if (socket_protocol::tcp != _socket_t::protocol){
+          return;
+        }
+        _set<IPPROTO_TCP, TCP_NODELAY>(hSocket, no_delay);
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+        _set<IPPROTO_TCP, TCP_QUICKACK>(hSocket, quick_ack);
+        _set<IPPROTO_TCP, TCP_DEFER_ACCEPT>(hSocket, defer_accept);
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(TCP_NOTSENT_LOWAT)
+        _set<IPPROTO_TCP, TCP_NOTSENT_LOWAT>(hSocket, not_sent_lowat);
+#endif
+#if defined(TCP_FASTOPEN)
+        _set<IPPROTO_TCP, TCP_FASTOPEN>(hSocket, fast_open);
+#endif
+      }
+
+    private:
+      template <int level, int optname> static void _set(SOCKET hSocket, int iValue){
+        if (unchanged != iValue){
+          _::socket_option<int, level, optname>::set(hSocket, iValue);
+        }
+      }
+    };
+
+    /// UDP socket properties
+    template <typename _super_t>
+    class udp_options : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit udp_options(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+#if (XTD_OS_WINDOWS & XTD_OS)
+      /// gets the UDP_NOCHECKSUM property
+      bool no_checksum() const{ return (_::socket_option<int, IPPROTO_UDP, UDP_NOCHECKSUM>::get(_super_t::_socket) ? true : false); }
+      /// sets the UDP_NOCHECKSUM property
+      void no_checksum(bool newval){ _::socket_option<int, IPPROTO_UDP, UDP_NOCHECKSUM>::set(_super_t::_socket, newval); }
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(UDP_SEGMENT)
+      /// gets the UDP_SEGMENT property, the segment size used for generic segmentation offload of large sends
+      int segment_size() const{ return _::socket_option<int, IPPROTO_UDP, UDP_SEGMENT>::get(_super_t::_socket); }
+      /// sets the UDP_SEGMENT property. Sends larger than the segment size are split into datagrams of this size by the stack or NIC.
+      void segment_size(int newval){ _::socket_option<int, IPPROTO_UDP, UDP_SEGMENT>::set(_super_t::_socket, newval); }
+#endif
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(UDP_GRO)
+      /// gets the UDP_GRO property
+      bool gro() const{ return (_::socket_option<int, IPPROTO_UDP, UDP_GRO>::get(_super_t::_socket) ? true : false); }
+      /// sets the UDP_GRO property. Coalesced receives report their segment size through datagram_batch::segment_size.
+      void gro(bool newval){ _::socket_option<int, IPPROTO_UDP, UDP_GRO>::set(_super_t::_socket, newval); }
+#endif
+      TODO("Add more IPPROTO_UDP options");
+    };
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+    /** Preallocated array of datagrams for batched sends and receives
+    All message headers, buffers and addresses are allocated once so recv_batch and send_batch do no allocation.
+    @tparam _address_t address type of the datagrams
+    */
+    template <typename _address_t> class datagram_batch{
+      static_assert(sizeof(_address_t) <= sizeof(sockaddr_storage), "address type is too large for a datagram_batch");
+    public:
+      using address_type = _address_t;
+
+      /**
+      @param iCapacity number of datagrams per batch
+      @param iMaxSize largest datagram payload. Use 64K when receiving with UDP_GRO enabled.
+      */
+      explicit datagram_batch(size_t iCapacity = 64, size_t iMaxSize = 2048)
+        : _max_size(iMaxSize), _count(0), _headers(iCapacity), _vectors(iCapacity), _addresses(iCapacity),
+          _control(iCapacity * control_size), _segments(iCapacity, 0), _buffers(iCapacity * iMaxSize)
+      {}
+
+      /// space reserved per message for ancillary data
+      static constexpr size_t control_size = 64;
+
+      /// maximum number of datagrams
+      size_t capacity() const{ return _headers.size(); }
+      /// number of datagrams currently held
+      size_t size() const{ return _count; }
+      /// largest payload of a single datagram
+      size_t max_size() const{ return _max_size; }
+      /// removes all datagrams
+      void clear(){ _count = 0; }
+
+      /// payload of datagram i
+      char * data(size_t i){ return &_buffers[i * _max_size]; }
+      const char * data(size_t i) const{ return &_buffers[i * _max_size]; }
+      /// payload length of datagram i
+      size_t length(size_t i) const{ return _headers[i].msg_len; }
+      /// source or destination address of datagram i
+      const address_type& address(size_t i) const{ return *reinterpret_cast<const address_type*>(&_addresses[i]); }
+      /// GRO segment size of a received datagram or 0 if it wasn't coalesced
+      size_t segment_size(size_t i) const{ return _segments[i]; }
+
+      /** appends a datagram to send
+      @return false if the batch is full
+      */
+      bool push_back(const void * pData, size_t iLen, const address_type& oAddress){
+        if (_count == capacity()){
+          return false;
+        }
+        if (iLen > _max_size){
+          throw xtd::exception(here(), "datagram exceeds the batch max_size");
+        }
+        memcpy(data(_count), pData, iLen);
+        memcpy(&_addresses[_count], &oAddress, sizeof(address_type));
+        _headers[_count].msg_len = static_cast<unsigned int>(iLen);
+        ++_count;
+        return true;
+      }
+
+#if (!DOXY_INVOKED)
+      /// prepares headers for sending the held datagrams starting at iFirst
+      mmsghdr * prepare_send(size_t iFirst){
+        for (size_t i = iFirst; i < _count; ++i){
+          _prepare(i, _headers[i].msg_len, true);
+        }
+        return &_headers[iFirst];
+      }
+
+      /// prepares every slot to receive a datagram
+      mmsghdr * prepare_receive(){
+        for (size_t i = 0; i < capacity(); ++i){
+          _prepare(i, _max_size, false);
+        }
+        return &_headers[0];
+      }
+
+      /// records the number of datagrams received and decodes their ancillary data
+      void received(size_t iCount){
+        _count = iCount;
+        for (size_t i = 0; i < iCount; ++i){
+          _segments[i] = 0;
+#if defined(UDP_GRO)
+          for (auto pHeader = CMSG_FIRSTHDR(&_headers[i].msg_hdr); pHeader; pHeader = CMSG_NXTHDR(&_headers[i].msg_hdr, pHeader)){
+            if (IPPROTO_UDP == pHeader->cmsg_level && UDP_GRO == pHeader->cmsg_type){
+              int iSegment;
+              memcpy(&iSegment, CMSG_DATA(pHeader), sizeof(iSegment));
+              _segments[i] = static_cast<size_t>(iSegment);
+            }
+          }
+#endif
+        }
+      }
+#endif
+
+    private:
+      void _prepare(size_t i, size_t iLen, bool bSend){
+        auto & oHeader = _headers[i].msg_hdr;
+        _vectors[i].iov_base = data(i);
+        _vectors[i].iov_len = iLen;
+        oHeader.msg_name = &_addresses[i];
+        oHeader.msg_namelen = sizeof(address_type);
+        oHeader.msg_iov = &_vectors[i];
+        oHeader.msg_iovlen = 1;
+        oHeader.msg_control = bSend ? nullptr : &_control[i * control_size];
+        oHeader.msg_controllen = bSend ? 0 : control_size;
+        oHeader.msg_flags = 0;
+      }
+
+      size_t _max_size;
+      size_t _count;
+      std::vector<mmsghdr> _headers;
+      std::vector<iovec> _vectors;
+      std::vector<sockaddr_storage> _addresses;
+      std::vector<char> _control;
+      std::vector<size_t> _segments;
+      std::vector<char> _buffers;
+    };
+#endif
+
+    /// Connectionless datagram send and receive behavior
+    template <typename _super_t>
+    class datagram_socket : public _super_t{
+    public:
+
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit datagram_socket(_arg_ts&&...oArgs) : _super_t(std::forward<_arg_ts>(oArgs)...){}
+
+      /// sends a single datagram
+      void send_to(const void * pData, size_t iLen, const typename _super_t::address_type& oAddress){
+        auto iRet = ::sendto(_super_t::_socket, static_cast<const char*>(pData), static_cast<int>(iLen), _::send_flags, reinterpret_cast<const sockaddr*>(&oAddress), sizeof(oAddress));
+        exception::throw_if(iRet, [](decltype(iRet) i){ return i < 0; });
+      }
+
+      /** receives a single datagram
+      @return the payload length
+      */
+      size_t recv_from(void * pData, size_t iLen, typename _super_t::address_type& oAddress){
+        socklen_t iAddressLen = sizeof(oAddress);
+        auto iRet = ::recvfrom(_super_t::_socket, static_cast<char*>(pData), static_cast<int>(iLen), 0, reinterpret_cast<sockaddr*>(&oAddress), &iAddressLen);
+        exception::throw_if(iRet, [](decltype(iRet) i){ return i < 0; });
+        return static_cast<size_t>(iRet);
+      }
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+      /** receives up to a batch of datagrams with one recvmmsg call
+      @param oBatch preallocated batch that receives the datagrams
+      @param bWait true to block until at least one datagram arrives
+      @return number of datagrams received, 0 if none were waiting on a non-blocking socket
+      */
+      size_t recv_batch(datagram_batch<typename _super_t::address_type>& oBatch, bool bWait = true){
+        forever{
+          auto iRet = ::recvmmsg(_super_t::_socket, oBatch.prepare_receive(), static_cast<unsigned int>(oBatch.capacity()), bWait ? MSG_WAITFORONE : MSG_DONTWAIT, nullptr);
+          if (iRet >= 0){
+            oBatch.received(static_cast<size_t>(iRet));
+            return static_cast<size_t>(iRet);
+          }
+          if (_::interrupted()){
+            continue;
+          }
+          if (EAGAIN == errno || EWOULDBLOCK == errno){
+            oBatch.received(0);
+            return 0;
+          }
+          throw exception(here(), "recvmmsg failed");
+        }
+      }
+
+      /** sends every datagram in the batch, using as few sendmmsg calls as the kernel allows
+      The batch is cleared once everything is sent.
+      */
+      void send_batch(datagram_batch<typename _super_t::address_type>& oBatch){
+        size_t iSent = 0;
+        while (iSent < oBatch.size()){
+          auto iRet = ::sendmmsg(_super_t::_socket, oBatch.prepare_send(iSent), static_cast<unsigned int>(oBatch.size() - iSent), _::send_flags);
+          if (iRet < 0 && _::interrupted()){
+            continue;
+          }
+          exception::throw_if(iRet, [](int i){ return i <= 0; });
+          iSent += static_cast<size_t>(iRet);
+        }
+        oBatch.clear();
+      }
+#endif
+    };
+
+
+    ///Async IO select behavior
+    template <typename _super_t>
+    class selectable_socket : public _super_t{
+    public:
+      /// ctor
+      template<typename ... _arg_ts>
+      explicit selectable_socket(_arg_ts&&...oArgs)
+        : _super_t(std::forward<_arg_ts>(oArgs)...), onRead(), onWrite(), onError() {}
+
+      /// callback event fired when data is ready to be read
+      xtd::callback<void()> onRead;
+      /// callback event fired when socket is ready to write
+      xtd::callback<void()> onWrite;
+      /// callback event fired when a socket error occurs
+      xtd::callback<void()> onError;
+
+      /// begin the select to wait for an event or timeout
+      bool select(int WaitMS){
+        timeval tv;
+        fd_set fdRead;
+        fd_set fdWrite;
+        fd_set fdErr;
+        FD_ZERO(&fdRead);
+        FD_ZERO(&fdWrite);
+        FD_ZERO(&fdErr);
+        FD_SET((SOCKET)*this, &fdRead);
+        FD_SET((SOCKET)*this, &fdWrite);
+        FD_SET((SOCKET)*this, &fdErr);
+        tv.tv_sec = WaitMS / 1000;
+        WaitMS %= 1000;
+        tv.tv_usec = WaitMS / 1000;
+#if (XTD_COMPILER_MINGW & XTD_COMPILER)
+        auto iRet = xtd::crt_exception::throw_if(::select(1 + (SOCKET)*this, &fdRead, &fdWrite, &fdErr, reinterpret_cast<PTIMEVAL>(&tv)), [](int i){return i < 0; });
+#else
+        auto iRet = xtd::crt_exception::throw_if(::select(static_cast<int>(1 + (SOCKET)*this), &fdRead, &fdWrite, &fdErr, &tv), [](int i){return i < 0; });
+#endif
+        if (0 == iRet){
+          return false;
+        }
+        if (FD_ISSET((SOCKET)*this, &fdErr)){
+          onError();
+        }
+        if (FD_ISSET((SOCKET)*this, &fdRead)){
+          onRead();
+        }
+        if (FD_ISSET((SOCKET)*this, &fdWrite)){
+          onWrite();
+        }
+        return true;
+      }
+    };
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+#if (!DOXY_INVOKED)
+    namespace _{
+      /// routes epoll events to the polling_socket events
+      template <typename _socket_t>
+      auto dispatch_events(_socket_t& oSocket, uint32_t iEvents, int) -> decltype(oSocket.read_event(), void()){
+        if (iEvents & EPOLLERR) oSocket.error_event();
+        if (iEvents & EPOLLIN) oSocket.read_event();
+        if (iEvents & EPOLLOUT) oSocket.write_event();
+        if (iEvents & (EPOLLHUP | EPOLLRDHUP)) oSocket.disconnect_event();
+      }
+
+      /// routes epoll events to the selectable_socket events. A hang up is reported as readable so the reader sees the end of stream.
+      template <typename _socket_t>
+      auto dispatch_events(_socket_t& oSocket, uint32_t iEvents, long) -> decltype(oSocket.onRead(), void()){
+        if (iEvents & EPOLLERR) oSocket.onError();
+        if (iEvents & (EPOLLIN | EPOLLHUP | EPOLLRDHUP)) oSocket.onRead();
+        if (iEvents & EPOLLOUT) oSocket.onWrite();
+      }
+    }
+#endif
+
+    /** Edge triggered epoll event loop that drives many sockets from one thread
+    Registered sockets are switched to non-blocking mode and their polling_socket or selectable_socket events are fired from run_once.
+    Because notifications are edge triggered a handler must consume everything available (until the call would block) before it returns.
+    Sockets must be removed before they are destroyed. Registration and post may be called from any thread while run_once must only be called by the reactor thread.
+    */
+    class reactor{
+    public:
+      /// maximum events harvested by a single epoll_wait
+      static constexpr int max_events = 256;
+
+      /// receives the epoll event mask of a watched descriptor
+      using handler = std::function<void(uint32_t)>;
+
+      reactor()
+        : _epoll(xtd::crt_exception::throw_if(epoll_create1(EPOLL_CLOEXEC), [](int i){ return i < 0; })),
+          _wake(xtd::crt_exception::throw_if(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), [](int i){ return i < 0; })),
+          _stop(false), _lock(), _handlers(), _posted()
+      {
+        epoll_event oEvent;
+        oEvent.events = EPOLLIN;
+        oEvent.data.fd = _wake;
+        xtd::crt_exception::throw_if(epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &oEvent), [](int i){ return i < 0; });
+      }
+
+      ~reactor(){
+        ::close(_wake);
+        ::close(_epoll);
+      }
+
+      reactor(const reactor&) = delete;
+      reactor& operator=(const reactor&) = delete;
+
+      /** registers a socket
+      @param oSocket socket with polling_socket or selectable_socket events
+      @param bWrite true to also receive write readiness notifications
+      */
+      template <typename _socket_t> void add(_socket_t& oSocket, bool bWrite = false){
+        oSocket.set_blocking(false);
+        auto pSocket = &oSocket;
+        watch(oSocket, [pSocket](uint32_t iEvents){ _::dispatch_events(*pSocket, iEvents, 0); }, EPOLLIN | EPOLLRDHUP | (bWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u));
+      }
+
+      /// unregisters a socket
+      template <typename _socket_t> void remove(_socket_t& oSocket){
+        unwatch(oSocket);
+      }
+
+      /** registers a raw descriptor with an edge triggered handler
+      @param hSocket descriptor to watch
+      @param oHandler receives the event mask each time the descriptor becomes ready
+      @param iEvents epoll events of interest. EPOLLET is always added.
+      */
+      void watch(SOCKET hSocket, handler oHandler, uint32_t iEvents){
+        std::unique_lock<std::mutex> oLock(_lock);
+        _handlers[hSocket] = std::make_shared<handler>(std::move(oHandler));
+        epoll_event oEvent;
+        oEvent.events = iEvents | EPOLLET;
+        oEvent.data.fd = hSocket;
+        if (epoll_ctl(_epoll, EPOLL_CTL_ADD, hSocket, &oEvent) < 0){
+          _handlers.erase(hSocket);
+          throw exception(here(), "epoll_ctl failed");
+        }
+      }
+
+      /// unregisters a raw descriptor
+      void unwatch(SOCKET hSocket){
+        std::unique_lock<std::mutex> oLock(_lock);
+        if (!_handlers.erase(hSocket)){
+          return;
+        }
+        epoll_ctl(_epoll, EPOLL_CTL_DEL, hSocket, nullptr);
+      }
+
+      /// number of registered sockets
+      size_t size() const{
+        std::unique_lock<std::mutex> oLock(_lock);
+        return _handlers.size();
+      }
+
+      /// queues a function to run on the reactor thread during the next run_once. Safe to call from any thread.
+      void post(std::function<void()> oTask){
+        {
+          std::unique_lock<std::mutex> oLock(_lock);
+          _posted.push_back(std::move(oTask));
+        }
+        _signal();
+      }
+
+      /** waits for events and dispatches them
+      @param iTimeoutMS maximum wait in milliseconds, -1 waits indefinitely
+      @return number of socket events dispatched
+      */
+      size_t run_once(int iTimeoutMS){
+        epoll_event oEvents[max_events];
+        auto iCount = epoll_wait(_epoll, oEvents, max_events, iTimeoutMS);
+        if (iCount < 0){
+          if (EINTR == errno){
+            return 0;
+          }
+          throw xtd::crt_exception(here(), "epoll_wait failed");
+        }
+        size_t iRet = 0;
+        for (int i = 0; i < iCount; ++i){
+          if (oEvents[i].data.fd == _wake){
+            uint64_t iSignal;
+            while (::read(_wake, &iSignal, sizeof(iSignal)) > 0);
+            continue;
+          }
+          std::shared_ptr<handler> pHandler;
+          {
+            //a handler may remove its own socket so hold a reference while it runs
+            std::unique_lock<std::mutex> oLock(_lock);
+            auto oHandler = _handlers.find(oEvents[i].data.fd);
+            if (_handlers.end() == oHandler){
+              continue;
+            }
+            pHandler = oHandler->second;
+          }
+          (*pHandler)(oEvents[i].events);
+          ++iRet;
+        }
+        std::deque<std::function<void()>> oPosted;
+        {
+          std::unique_lock<std::mutex> oLock(_lock);
+          oPosted.swap(_posted);
+        }
+        for (auto & oTask : oPosted){
+          oTask();
+        }
+        return iRet;
+      }
+
+      /// dispatches events until stop is called
+      void run(){
+        while (!_stop.load()){
+          run_once(-1);
+        }
+        _stop = false;
+      }
+
+      /// makes run return. Safe to call from any thread.
+      void stop(){
+        _stop = true;
+        _signal();
+      }
+
+    private:
+      void _signal(){
+        uint64_t iSignal = 1;
+        while (::write(_wake, &iSignal, sizeof(iSignal)) < 0 && EINTR == errno);
+      }
+
+      int _epoll;
+      int _wake;
+      std::atomic<bool> _stop;
+      mutable std::mutex _lock;
+      std::unordered_map<SOCKET, std::shared_ptr<handler>> _handlers;
+      std::deque<std::function<void()>> _posted;
+    };
+
+#if (XTD_CPP_COROUTINES)
+    /** Awaitable result of an async_socket operation
+    The awaiting coroutine is resumed on the reactor thread once the operation completes.
+    */
+    template <typename _ty> class awaitable{
+    public:
+      using value_type = typename std::conditional<std::is_void<_ty>::value, bool, _ty>::type;
+      using completion = std::function<void(std::exception_ptr, value_type)>;
+
+      explicit awaitable(std::function<void(completion)> oStart) : _start(std::move(oStart)), _error(), _value(){}
+
+      bool await_ready() const noexcept{ return false; }
+
+      void await_suspend(std::coroutine_handle<> hCoroutine){
+        //the completion can resume the coroutine and destroy this awaitable before _start returns, so run a local copy
+        auto oStart = std::move(_start);
+        oStart([this, hCoroutine](std::exception_ptr oError, value_type oValue){
+          _error = oError;
+          _value = std::move(oValue);
+          hCoroutine.resume();
+        });
+      }
+
+      _ty await_resume(){
+        if (_error){
+          std::rethrow_exception(_error);
+        }
+        return static_cast<_ty>(std::move(_value));
+      }
+
+    private:
+      std::function<void(completion)> _start;
+      std::exception_ptr _error;
+      value_type _value;
+    };
+
+    /** coroutine return type for fire and forget socket handlers that start immediately and run on the reactor thread
+    There is nobody to report to so an exception escaping the handler, such as a peer closing the connection mid read,
+    ends that handler alone. Handlers that need to react to errors catch them.
+    */
+    struct detached_task{
+      struct promise_type{
+        detached_task get_return_object() noexcept{ return detached_task(); }
+        std::suspend_never initial_suspend() noexcept{ return {}; }
+        std::suspend_never final_suspend() noexcept{ return {}; }
+        void return_void() noexcept{}
+        void unhandled_exception() noexcept{}
+      };
+    };
+#endif
+
+#if (!DOXY_INVOKED)
+    namespace _{
+      template <typename _ty> void set_promise(std::promise<_ty>& oPromise, _ty&& oValue){ oPromise.set_value(std::move(oValue)); }
+      inline void set_promise(std::promise<void>& oPromise, bool&&){ oPromise.set_value(); }
+
+      /// true if the last call failed only because the non-blocking socket wasn't ready
+      inline bool would_block(){ return EAGAIN == errno || EWOULDBLOCK == errno; }
+    }
+#endif
+
+    /** Non-blocking operations on a socket driven by a reactor
+    Each operation is queued on the reactor thread and completes when the socket becomes ready.
+    Operations return a std::future and, when coroutines are available, co_ prefixed versions return an awaitable so a connection handler can be written sequentially while a single reactor thread per core drives every connection.
+    Reads and writes each complete in the order they were issued. Buffers passed by pointer must remain valid until the operation completes.
+    @tparam _socket_t socket type to wrap. The socket must outlive the async_socket.
+    */
+    template <typename _socket_t> class async_socket{
+    public:
+      template <typename _ty> using value_type = typename std::conditional<std::is_void<_ty>::value, bool, _ty>::type;
+      template <typename _ty> using completion = std::function<void(std::exception_ptr, value_type<_ty>)>;
+
+      async_socket(reactor& oReactor, _socket_t& oSocket) : _socket(oSocket), _state(std::make_shared<state>(oReactor, oSocket)){
+        oSocket.set_blocking(false);
+        auto pState = _state;
+        oReactor.watch(oSocket, [pState](uint32_t iEvents){ pState->dispatch(iEvents); }, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+      }
+
+      ~async_socket(){
+        _state->_reactor.unwatch(_socket);
+      }
+
+      async_socket(const async_socket&) = delete;
+      async_socket& operator=(const async_socket&) = delete;
+
+      /// reads whatever is available up to iLen bytes. Completes with 0 at end of stream.
+      void read_some(void * pData, size_t iLen, completion<size_t> oComplete){
+        auto hSocket = static_cast<SOCKET>(_socket);
+        _state->queue(false, [=]()->bool{
+          auto iRead = ::recv(hSocket, pData, iLen, 0);
+          if (iRead < 0 && (_::interrupted() || _::would_block())){
+            return false;
+          }
+          if (iRead < 0){
+            oComplete(std::make_exception_ptr(exception(here(), "recv failed")), 0);
+          } else{
+            oComplete(nullptr, static_cast<size_t>(iRead));
+          }
+          return true;
+        });
+      }
+
+      /// reads exactly iLen bytes
+      void read(void * pData, size_t iLen, completion<void> oComplete){
+        auto hSocket = static_cast<SOCKET>(_socket);
+        auto pDone = std::make_shared<size_t>(0);
+        _state->queue(false, [=]()->bool{
+          while (*pDone < iLen){
+            auto iRead = ::recv(hSocket, static_cast<char*>(pData) + *pDone, iLen - *pDone, 0);
+            if (iRead < 0 && _::interrupted()){
+              continue;
+            }
+            if (iRead < 0 && _::would_block()){
+              return false;
+            }
+            if (iRead <= 0){
+              oComplete(std::make_exception_ptr(exception(here(), "connection closed during read")), false);
+              return true;
+            }
+            *pDone += static_cast<size_t>(iRead);
+          }
+          oComplete(nullptr, true);
+          return true;
+        });
+      }
+
+      /// writes exactly iLen bytes
+      void write(const void * pData, size_t iLen, completion<void> oComplete){
+        auto hSocket = static_cast<SOCKET>(_socket);
+        auto pDone = std::make_shared<size_t>(0);
+        _state->queue(true, [=]()->bool{
+          while (*pDone < iLen){
+            auto iSent = ::send(hSocket, static_cast<const char*>(pData) + *pDone, iLen - *pDone, _::send_flags);
+            if (iSent < 0 && _::interrupted()){
+              continue;
+            }
+            if (iSent < 0 && _::would_block()){
+              return false;
+            }
+            if (iSent <= 0){
+              oComplete(std::make_exception_ptr(exception(here(), "send failed")), false);
+              return true;
+            }
+            *pDone += static_cast<size_t>(iSent);
+          }
+          oComplete(nullptr, true);
+          return true;
+        });
+      }
+
+      /// reads a value of a POD type
+      template <typename _ty> void read(completion<_ty> oComplete){
+        static_assert(std::is_pod<_ty>::value, "async reads are limited to POD values");
+        auto pValue = std::make_shared<_ty>();
+        read(pValue.get(), sizeof(_ty), [pValue, oComplete](std::exception_ptr oError, bool){
+          oComplete(oError, *pValue);
+        });
+      }
+
+      /// serializes and writes a value. The value is copied so it need not outlive the call.
+      template <typename _ty> void write(const _ty& oValue, completion<void> oComplete){
+        _::gather_buffer oBuffer;
+        serializer<_ty>::gather(oBuffer, oValue);
+        auto pData = std::make_shared<std::vector<char>>(oBuffer.flatten());
+        write(pData->data(), pData->size(), [pData, oComplete](std::exception_ptr oError, bool b){ oComplete(oError, b); });
+      }
+
+      /// accepts a connection on a listening socket
+      template <typename _return_t> void accept(completion<std::shared_ptr<_return_t>> oComplete){
+        auto pSocket = &_socket;
+        _state->queue(false, [=]()->bool{
+          try{
+            auto pRet = pSocket->template try_accept<_return_t>();
+            if (!pRet){
+              return false;
+            }
+            oComplete(nullptr, std::shared_ptr<_return_t>(std::move(pRet)));
+          }
+          catch (...){
+            oComplete(std::current_exception(), nullptr);
+          }
+          return true;
+        });
+      }
+
+      /// connects to a remote address
+      void connect(const typename _socket_t::address_type& oAddress, completion<void> oComplete){
+        auto hSocket = static_cast<SOCKET>(_socket);
+        auto pStarted = std::make_shared<bool>(false);
+        _state->queue(true, [=]()->bool{
+          if (!*pStarted){
+            *pStarted = true;
+            if (0 == ::connect(hSocket, reinterpret_cast<const sockaddr*>(&oAddress), sizeof(oAddress))){
+              oComplete(nullptr, true);
+              return true;
+            }
+            if (EINPROGRESS == errno || _::interrupted()){
+              return false;
+            }
+            oComplete(std::make_exception_ptr(exception(here(), "connect failed")), false);
+            return true;
+          }
+          int iError = 0;
+          socklen_t iSize = sizeof(iError);
+          getsockopt(hSocket, SOL_SOCKET, SO_ERROR, &iError, &iSize);
+          if (iError){
+            errno = iError;
+            oComplete(std::make_exception_ptr(exception(here(), "connect failed")), false);
+          } else{
+            oComplete(nullptr, true);
+          }
+          return true;
+        });
+      }
+
+      /// future returning versions
+      /// @{
+      std::future<size_t> read_some(void * pData, size_t iLen){ return _future<size_t>([this, pData, iLen](completion<size_t> c){ read_some(pData, iLen, c); }); }
+      std::future<void> read(void * pData, size_t iLen){ return _future<void>([this, pData, iLen](completion<void> c){ read(pData, iLen, c); }); }
+      std::future<void> write(const void * pData, size_t iLen){ return _future<void>([this, pData, iLen](completion<void> c){ write(pData, iLen, c); }); }
+      template <typename _ty> std::future<_ty> read(){ return _future<_ty>([this](completion<_ty> c){ read<_ty>(c); }); }
+      template <typename _ty> std::future<void> write(const _ty& oValue){ return _future<void>([&](completion<void> c){ write(oValue, c); }); }
+      template <typename _return_t> std::future<std::shared_ptr<_return_t>> accept(){ return _future<std::shared_ptr<_return_t>>([this](completion<std::shared_ptr<_return_t>> c){ accept<_return_t>(c); }); }
+      std::future<void> connect(const typename _socket_t::address_type& oAddress){ return _future<void>([&](completion<void> c){ connect(oAddress, c); }); }
+      /// @}
+
+#if (XTD_CPP_COROUTINES)
+      /// awaitable versions
+      /// @{
+      awaitable<size_t> co_read_some(void * pData, size_t iLen){ return awaitable<size_t>([this, pData, iLen](completion<size_t> c){ read_some(pData, iLen, c); }); }
+      awaitable<void> co_read(void * pData, size_t iLen){ return awaitable<void>([this, pData, iLen](completion<void> c){ read(pData, iLen, c); }); }
+      awaitable<void> co_write(const void * pData, size_t iLen){ return awaitable<void>([this, pData, iLen](completion<void> c){ write(pData, iLen, c); }); }
+      template <typename _ty> awaitable<_ty> co_read(){ return awaitable<_ty>([this](completion<_ty> c){ read<_ty>(c); }); }
+      template <typename _ty> awaitable<void> co_write(const _ty& oValue){
+        auto pValue = std::make_shared<_ty>(oValue);
+        return awaitable<void>([this, pValue](completion<void> c){ write(*pValue, c); });
+      }
+      template <typename _return_t> awaitable<std::shared_ptr<_return_t>> co_accept(){ return awaitable<std::shared_ptr<_return_t>>([this](completion<std::shared_ptr<_return_t>> c){ accept<_return_t>(c); }); }
+      awaitable<void> co_connect(const typename _socket_t::address_type& oAddress){ return awaitable<void>([this, oAddress](completion<void> c){ connect(oAddress, c); }); }
+      /// @}
+#endif
+
+    private:
+      /// reactor side state shared with the queued operations so it survives until they drain
+      struct state : std::enable_shared_from_this<state>{
+        state(reactor& oReactor, _socket_t& oSocket) : _reactor(oReactor), _socket(oSocket), _readers(), _writers(){}
+
+        /// queues an operation that returns true once it has completed
+        void queue(bool bWrite, std::function<bool()> oOperation){
+          auto pThis = this->shared_from_this();
+          _reactor.post([pThis, bWrite, oOperation](){
+            auto & oQueue = bWrite ? pThis->_writers : pThis->_readers;
+            oQueue.push_back(oOperation);
+            pThis->pump(oQueue);
+          });
+        }
+
+        void dispatch(uint32_t iEvents){
+          if (iEvents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) pump(_readers);
+          if (iEvents & (EPOLLOUT | EPOLLHUP | EPOLLERR)) pump(_writers);
+        }
+
+        void pump(std::deque<std::function<bool()>>& oQueue){
+          while (!oQueue.empty() && oQueue.front()()){
+            oQueue.pop_front();
+          }
+        }
+
+        reactor& _reactor;
+        _socket_t& _socket;
+        std::deque<std::function<bool()>> _readers;
+        std::deque<std::function<bool()>> _writers;
+      };
+
+      template <typename _ty, typename _start_t> static std::future<_ty> _future(_start_t oStart){
+        auto pPromise = std::make_shared<std::promise<_ty>>();
+        auto oRet = pPromise->get_future();
+        oStart([pPromise](std::exception_ptr oError, value_type<_ty> oValue){
+          if (oError){
+            pPromise->set_exception(oError);
+          } else{
+            _::set_promise(*pPromise, std::move(oValue));
+          }
+        });
+        return oRet;
+      }
+
+      _socket_t& _socket;
+      std::shared_ptr<state> _state;
+    };
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+    /** Group of SO_REUSEPORT listeners bound to one address with an accept loop per listener
+    The kernel spreads incoming connections across the listeners, so accept throughput scales with the number of loops instead of serialising on one queue.
+    Each accept loop runs on its own thread pinned to a CPU, and each listener is tagged with SO_INCOMING_CPU for that CPU.
+    @tparam _socket_t listener type with socket_options, bindable_socket and listening_socket policies
+    */
+    template <typename _socket_t> class listener_group{
+    public:
+      using address_type = typename _socket_t::address_type;
+
+      /**
+      @param oAddress address every listener binds
+      @param iCount number of listeners, defaults to one per core
+      @param iBacklog listen backlog of each listener
+      */
+      explicit listener_group(const address_type& oAddress, size_t iCount = std::max<size_t>(1, std::thread::hardware_concurrency()), int iBacklog = SOMAXCONN)
+        : _listeners(), _threads(), _wake(exception::throw_if(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK), [](int i){ return i < 0; }))
+      {
+        for (size_t i = 0; i < iCount; ++i){
+          _listeners.emplace_back(new _socket_t);
+          auto & oListener = *_listeners.back();
+          oListener.reuse_address(true);
+          oListener.reuse_port(true);
+          oListener.bind(oAddress);
+          oListener.listen(iBacklog);
+          oListener.set_blocking(false);
+        }
+      }
+
+      ~listener_group(){
+        stop();
+        ::close(_wake);
+      }
+
+      listener_group(const listener_group&) = delete;
+      listener_group& operator=(const listener_group&) = delete;
+
+      /// number of listeners
+      size_t size() const{ return _listeners.size(); }
+
+      /// listener i
+      _socket_t& operator[](size_t i){ return *_listeners[i]; }
+
+      /** steers each connection to the listener whose index matches the CPU that received it
+      Attaches a classic BPF SO_ATTACH_REUSEPORT_CBPF program to the group. Connections arriving on CPUs beyond the group size fall back to the kernel hash.
+      */
+      void steer_by_cpu(){
+        sock_filter oCode[] = {
+          { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+          { BPF_RET | BPF_A, 0, 0, 0 },
+        };
+        sock_fprog oProgram;
+        oProgram.len = sizeof(oCode) / sizeof(oCode[0]);
+        oProgram.filter = oCode;
+        exception::throw_if(setsockopt(*_listeners.front(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &oProgram, sizeof(oProgram)), [](int i){ return i < 0; });
+      }
+
+      /** starts one accept loop per listener
+      Loop i is pinned to the i-th CPU this process may run on, wrapping around when there are more listeners than CPUs.
+      @param oHandler called on the accepting thread as oHandler(listener_index, std::unique_ptr<_connection_t>). It should hand long running work to another thread and must not throw.
+      @param iFlags accept4 flags of the accepted connections, non-blocking by default so they can go straight to a reactor. Pass 0 for blocking connections. SOCK_CLOEXEC is always added.
+      */
+      template <typename _connection_t, typename _handler_t> void start(_handler_t oHandler, int iFlags = SOCK_NONBLOCK){
+        auto oCPUs = _allowed_cpus();
+        for (size_t i = 0; i < _listeners.size(); ++i){
+          auto iCPU = oCPUs[i % oCPUs.size()];
+#if defined(SO_INCOMING_CPU)
+          _listeners[i]->incoming_cpu(iCPU);
+#endif
+          _threads.emplace_back([this, i, iFlags, oHandler](){
+            _accept_loop<_connection_t>(i, iFlags, oHandler);
+          });
+          cpu_set_t oCPU;
+          CPU_ZERO(&oCPU);
+          CPU_SET(iCPU, &oCPU);
+          if (auto iErr = pthread_setaffinity_np(_threads.back().native_handle(), sizeof(oCPU), &oCPU)){
+            stop();
+            errno = iErr;
+            throw exception(here(), "pthread_setaffinity_np failed");
+          }
+        }
+      }
+
+      /** stops the accept loops and waits for them to finish
+      The loops are woken through an eventfd so the listeners keep listening, connections arriving while stopped wait in
+      the backlog and start may be called again.
+      */
+      void stop(){
+        uint64_t iOne = 1;
+        if (sizeof(iOne) != ::write(_wake, &iOne, sizeof(iOne))){
+          return;
+        }
+        for (auto & oThread : _threads){
+          oThread.join();
+        }
+        _threads.clear();
+        ::read(_wake, &iOne, sizeof(iOne));
+      }
+
+    private:
+      /// how long a loop stops accepting after running out of descriptors or memory, the pending connection would otherwise keep it spinning
+      static constexpr int accept_backoff_ms = 100;
+
+      /// CPUs in the affinity mask of the calling thread, in ascending order
+      static std::vector<int> _allowed_cpus(){
+        cpu_set_t oCPUs;
+        CPU_ZERO(&oCPUs);
+        exception::throw_if(sched_getaffinity(0, sizeof(oCPUs), &oCPUs), [](int i){ return i < 0; });
+        std::vector<int> oRet;
+        for (int i = 0; i < CPU_SETSIZE; ++i){
+          if (CPU_ISSET(i, &oCPUs)){
+            oRet.push_back(i);
+          }
+        }
+        return oRet;
+      }
+
+      template <typename _connection_t, typename _handler_t> void _accept_loop(size_t iListener, int iFlags, _handler_t& oHandler){
+        pollfd oFDs[2] = { { *_listeners[iListener], POLLIN, 0 }, { _wake, POLLIN, 0 } };
+        forever{
+          if (::poll(oFDs, 2, -1) < 0 && !_::interrupted()){
+            return;
+          }
+          if (oFDs[1].revents){
+            return;
+          }
+          auto hSocket = ::accept4(oFDs[0].fd, nullptr, nullptr, iFlags | SOCK_CLOEXEC);
+          if (hSocket < 0){
+            if (EMFILE == errno || ENFILE == errno || ENOBUFS == errno || ENOMEM == errno){
+              if (::poll(&oFDs[1], 1, accept_backoff_ms) > 0){
+                return;
+              }
+              continue;
+            }
+            //transient errors mean only this connection was lost
+            if (_::would_block() || _::interrupted() || ECONNABORTED == errno || EPROTO == errno){
+              continue;
+            }
+            return;
+          }
+          oHandler(iListener, std::unique_ptr<_connection_t>(new _connection_t(hSocket)));
+        }
+      }
+
+      std::vector<std::unique_ptr<_socket_t>> _listeners;
+      std::vector<std::thread> _threads;
+      int _wake;
+    };
+#endif
+
+#if (!DOXY_INVOKED)
+    TODO("Get rid of these")
+    /* serializers gather the pieces of a value into a _::gather_buffer so the whole value goes out in one vectored write.
+    Specializations provide gather and read. write is the entry point used by socket_base.
+    */
+    template <typename _ty>
+    class serializer{
+    public:
+
+      template <typename _socket_t>
+      static void write(_socket_t& oSocket, const _ty& src, int flags = 0){
+        _::gather_buffer oBuffer;
+        gather(oBuffer, src);
+        oBuffer.flush(oSocket, flags);
+      }
+
+      static void gather(_::gather_buffer& oBuffer, const _ty& src){
+        static_assert(std::is_pod<_ty>::value, "no acceptable specialization for type");
+        oBuffer.append(src);
+      }
+
+      template <typename _socket_t>
+      static void read(_socket_t& oSocket, _ty& src){
+        static_assert(std::is_pod<_ty>::value, "no acceptable specialization for type");
+        oSocket.recv_all(&src, sizeof(_ty));
+      }
+    };
+
+
+    template <typename _ty>
+    class NON_POD_Vector_Serializer{
+    public:
+
+      template <typename _socket_t>
+      static void write(_socket_t& oSocket, const std::vector<_ty>& src, int flags = 0){
+        _::gather_buffer oBuffer;
+        gather(oBuffer, src);
+        oBuffer.flush(oSocket, flags);
+      }
+
+      static void gather(_::gather_buffer& oBuffer, const std::vector<_ty>& src){
+        serializer<typename std::vector<_ty>::size_type>::gather(oBuffer, src.size());
+        for (const auto & oItem : src){
+          serializer<_ty>::gather(oBuffer, oItem);
+        }
+      }
+
+      template <typename _socket_t>
+      static void read(_socket_t& oSocket, std::vector<_ty>& src){
+        typename std::vector<_ty>::size_type count;
+        serializer<typename std::vector<_ty>::size_type>::read(oSocket, count);
+        src.reserve(src.size() + count);
+        for (; count; --count){
+          _ty newval;
+          serializer<_ty>::read(oSocket, newval);
+          src.push_back(std::move(newval));
+        }
+      }
+    };
+
+
+    template <typename _ty>
+    class POD_Vector_Serializer{
+    public:
+
+      template <typename _socket_t >
+      static void write(_socket_t& oSocket, const std::vector<_ty>& src, int flags = 0){
+        _::gather_buffer oBuffer;
+        gather(oBuffer, src);
+        oBuffer.flush(oSocket, flags);
+      }
+
+      static void gather(_::gather_buffer& oBuffer, const std::vector<_ty>& src){
+        serializer<typename std::vector<_ty>::size_type>::gather(oBuffer, src.size());
+        if (!src.empty()){
+          oBuffer.append(src.data(), sizeof(_ty) * src.size());
+        }
+      }
+
+      template <typename _socket_t>
+      static void read(_socket_t& oSocket, std::vector<_ty>& src){
+        typename std::vector<_ty>::size_type count;
+        serializer<typename std::vector<_ty>::size_type>::read(oSocket, count);
+        src.resize(count);
+        if (count){
+          oSocket.recv_all(src.data(), sizeof(_ty) * count);
+        }
+      }
+
+    };
+
+
+    template <typename _ty>
+    class serializer<std::vector<_ty>> : public std::conditional<std::is_pod<_ty>::value, POD_Vector_Serializer<_ty>, NON_POD_Vector_Serializer<_ty>>::type{};
+#endif
+    /// General purpose IPV4 client and server socket type
+    using ipv4_tcp_stream = socket_base<ipv4address, socket_type::stream, socket_protocol::tcp, socket_options, ip_options, tcp_options, connectable_socket, bindable_socket, listening_socket, selectable_socket>;
+    /// General purpose UDP socket type
+    using ipv4_udp_socket = socket_base<ipv4address, socket_type::datagram, socket_protocol::udp, socket_options, ip_options, udp_options, bindable_socket, datagram_socket>;
+    ///@}
+
+  }
+
+}
@@ -3,6 +3,10 @@ logging system and unit tests
 @copyright David Mott (c) 2016. Distributed under the Boost Software License Version 1.0. See LICENSE.md or http://boost.org/LICENSE_1_0.txt for details.
 */
 
+#include <atomic>
+#include <fstream>
+#include <future>
+
 #include <xtd/log.hpp>
 
 TEST(test_logging, message_types){
@@ -13,3 +17,124 @@ TEST(test_logging, message_types){
   DBG("debug message");
 }
 
+TEST(test_logging, batch_target){
+  class counting_target : public xtd::log::log_target {
+  public:
+    std::atomic<size_t> _messages{0};
+    std::atomic<size_t> _largest{0};
+    std::promise<void> _release;
+    std::shared_future<void> _released{_release.get_future().share()};
+    void operator()(const xtd::log::message::pointer_type&) override { ++_messages; }
+    void write(const xtd::log::message::vector_type& oBatch) override {
+      //holds up the logging thread so the remaining messages queue behind the first batch
+      _released.wait();
+      _messages += oBatch.size();
+      if (oBatch.size() > _largest) _largest = oBatch.size();
+    }
+  };
+  auto oTarget = std::make_shared<counting_target>();
+  xtd::log::get().AddTarget(oTarget);
+  for (int i = 0; i < 1000; ++i) {
+    DBG("batched message ", i);
+  }
+  oTarget->_release.set_value();
+  for (int i = 0; i < 500 && oTarget->_messages < 1000; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  xtd::log::get().RemoveTarget(oTarget);
+  EXPECT_GE(oTarget->_messages, 1000);
+  EXPECT_LT(1, oTarget->_largest);
+}
+
+#if (XTD_OS_UNIX & XTD_OS)
+TEST(test_logging, file_target){
+  xtd::filesystem::path oPath("test_logging_file_target.log");
+  xtd::filesystem::remove(oPath);
+  auto oTarget = std::make_shared<xtd::log::file_target>(oPath);
+  xtd::log::get().AddTarget(oTarget);
+  INFO("file target message");
+  std::string sContents;
+  for (int i = 0; i < 500 && std::string::npos == sContents.find("file target message\n"); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::ifstream oFile(oPath.string());
+    sContents.assign(std::istreambuf_iterator<char>(oFile), std::istreambuf_iterator<char>());
+  }
+  xtd::log::get().RemoveTarget(oTarget);
+  EXPECT_NE(std::string::npos, sContents.find("file target message\n"));
+  xtd::filesystem::remove(oPath);
+}
+#endif
+
+TEST(test_logging, thread_id){
+  auto iThis = xtd::log::thread_id();
+  EXPECT_EQ(iThis, xtd::log::thread_id());
+  xtd::log::thread_id_type iOther = iThis;
+  std::thread([&iOther]() { iOther = xtd::log::thread_id(); }).join();
+  EXPECT_NE(iThis, iOther);
+  xtd::log::thread_name("test thread");
+  EXPECT_EQ(xtd::string("test thread"), xtd::log::thread_name(iThis));
+  EXPECT_EQ(xtd::string::format(iOther), xtd::log::thread_name(iOther));
+}
+
+TEST(test_logging, clock){
+  auto oBefore = std::chrono::system_clock::now();
+  xtd::log::message oMessage(xtd::log::type::info, here(), "clock");
+  auto oAfter = std::chrono::system_clock::now();
+  EXPECT_LE(oBefore - std::chrono::milliseconds(50), oMessage.time());
+  EXPECT_GE(oAfter + std::chrono::milliseconds(50), oMessage.time());
+}
+
+TEST(test_logging, clock_resolution){
+  auto iBegin = xtd::log::clock::now();
+  std::this_thread::sleep_for(std::chrono::microseconds(200));
+  auto oElapsed = xtd::log::clock::elapsed(iBegin, xtd::log::clock::now());
+  EXPECT_LE(std::chrono::microseconds(150), oElapsed);
+  EXPECT_GT(std::chrono::milliseconds(1000), oElapsed);
+}
+
+TEST(test_logging, latency_histogram){
+  xtd::log::latency_histogram oHist;
+  EXPECT_EQ(0, oHist.percentile(50));
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    oHist.record(i * 1000);
+  }
+  EXPECT_EQ(1000, oHist.count());
+  EXPECT_EQ(1000, oHist.min());
+  EXPECT_EQ(1000000, oHist.max());
+  EXPECT_EQ(500500, oHist.mean());
+  EXPECT_NEAR(500000, oHist.percentile(50), 500000 / 16);
+  EXPECT_NEAR(990000, oHist.percentile(99), 990000 / 16);
+  EXPECT_EQ(1000000, oHist.percentile(100));
+  oHist.record(7);
+  EXPECT_EQ(7, oHist.percentile(0));
+}
+
+TEST(test_logging, span_target){
+  auto oTarget = std::make_shared<xtd::log::span_target>();
+  xtd::log::get().AddTarget(oTarget);
+  for (int i = 0; i < 10; ++i) {
+    TRACE_SCOPE("test_logging.span_target");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  xtd::log::span_target::histogram_map oHistograms;
+  for (int i = 0; i < 500 && (!oHistograms.count("test_logging.span_target") || oHistograms["test_logging.span_target"].count() < 10); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    oHistograms = oTarget->histograms();
+  }
+  xtd::log::get().RemoveTarget(oTarget);
+  ASSERT_EQ(10, oHistograms["test_logging.span_target"].count());
+  EXPECT_LE(1000000, oHistograms["test_logging.span_target"].min());
+  EXPECT_NE(std::string::npos, oTarget->report().find("test_logging.span_target count=10"));
+}
+
+TEST(test_logging, chrome_trace_escape){
+  xtd::filesystem::path oPath("test_logging_chrome_trace.json");
+  {
+    xtd::log::chrome_trace_target oTarget(oPath);
+    oTarget(std::make_shared<xtd::log::message>(xtd::log::type::enter, here(), "a\"b\\c\nd\te\x01"));
+  }
+  std::ifstream oFile(oPath.string());
+  std::string sContents((std::istreambuf_iterator<char>(oFile)), std::istreambuf_iterator<char>());
+  EXPECT_NE(std::string::npos, sContents.find("\"name\":\"a\\\"b\\\\c\\nd\\te\\u0001\""));
+  xtd::filesystem::remove(oPath);
+}
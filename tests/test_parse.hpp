@@ -212,6 +212,506 @@ TEST(test_parser, basic_input_statement) {
   EXPECT_FALSE(basic_grammar::parser::parse(s.begin(), s.end(), ast));
 }
 
+namespace packrat_grammar{
+  using namespace xtd::parse;
+  CHARACTER_(X, 'x');
+  CHARACTER_(A, 'a');
+  CHARACTER_(B, 'b');
+  CHARACTER_(C, 'c');
+  CHARACTER_(N, 'n');
+  CHARACTER_(PLUS, '+');
+
+  //every level tries the first alternative, parses the whole remainder and then fails so naive backtracking is exponential in the nesting depth
+  struct nested : rule<nested, or_<and_<X, nested, B>, and_<X, nested, C>, A> >{
+    template <typename ... _arg_ts> nested(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+
+  //left recursive
+  struct sum : rule<sum, or_<and_<sum, PLUS, N>, N> >{
+    template <typename ... _arg_ts> sum(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+
+  //every repetition ends on an N that matched before the PLUS after it failed
+  struct terms : rule<terms, and_<one_or_more_<and_<N, PLUS>>, N> >{
+    template <typename ... _arg_ts> terms(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+
+  //lookaheads as the first item and in the not_<not_<x>> idiom
+  struct guarded : rule<guarded, and_<not_<A>, B> >{
+    template <typename ... _arg_ts> guarded(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+  struct peek : rule<peek, and_<N, not_<not_<PLUS>>, PLUS, N> >{
+    template <typename ... _arg_ts> peek(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+
+  template <bool _packrat> using nested_parser = xtd::parser<nested, false, whitespace<>, _packrat>;
+
+  template <typename _ast_t> size_t reachable(const _ast_t& oAST){
+    size_t iRet = 0;
+    std::vector<typename _ast_t::index_type> oStack(1, oAST.root());
+    while (!oStack.empty()){
+      auto i = oStack.back();
+      oStack.pop_back();
+      ++iRet;
+      for (size_t n = 0; n < oAST.child_count(i); ++n) oStack.push_back(oAST.child(i, n));
+    }
+    return iRet;
+  }
+
+  inline std::string nested_input(size_t iDepth){
+    return std::string(iDepth, 'x') + "a" + std::string(iDepth, 'c');
+  }
+}
+
+TEST(test_parser, packrat_matches_backtracking){
+  using namespace packrat_grammar;
+  xtd::parse::rule_base::pointer_type ast;
+  for (size_t iDepth = 0; iDepth < 8; ++iDepth){
+    auto s = nested_input(iDepth);
+    EXPECT_TRUE(nested_parser<false>::parse(s.begin(), s.end(), ast));
+    EXPECT_TRUE(nested_parser<true>::parse(s.begin(), s.end(), ast));
+    s.back() = 'b';
+    EXPECT_EQ(nested_parser<false>::parse(s.begin(), s.end(), ast), nested_parser<true>::parse(s.begin(), s.end(), ast));
+  }
+}
+
+TEST(test_parser, packrat_linear_time){
+  using namespace packrat_grammar;
+  //2^200 attempts without memoization
+  auto s = nested_input(200);
+  xtd::parse::rule_base::pointer_type ast;
+  ASSERT_TRUE(nested_parser<true>::parse(s.begin(), s.end(), ast));
+  EXPECT_TRUE(ast->isa(typeid(nested)));
+  s.back() = 'x';
+  EXPECT_FALSE(nested_parser<true>::parse(s.begin(), s.end(), ast));
+}
+
+TEST(test_parser, packrat_left_recursion){
+  using namespace packrat_grammar;
+  using test_parse = xtd::parser<sum, false, whitespace<' '>, true>;
+  std::string s = "n + n + n";
+  xtd::parse::rule_base::pointer_type ast;
+  ASSERT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  EXPECT_TRUE(ast->isa(typeid(sum)));
+  s = "n + + n";
+  EXPECT_FALSE(test_parse::parse(s.begin(), s.end(), ast));
+}
+
+namespace dispatch_grammar{
+  using namespace xtd::parse;
+  STRING_(LET);
+  STRING_(PRINT);
+  STRING_(PRINTLN);
+  CHARACTERS_(DIGIT, '0', '9');
+  CHARACTERS_(LETTER, 'a', 'z');
+  CHARACTER_(EQUALS, '=');
+
+  struct value : rule<value, or_<one_or_more_<DIGIT>, LETTER> >{
+    template <typename ... _arg_ts> value(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+  //PRINTLN shares its first character with PRINT so both stay viable and the longer keyword must be tried first
+  struct statement : rule<statement, or_<and_<LET, LETTER, EQUALS, value>, and_<PRINTLN, value>, and_<PRINT, value>, zero_or_one_<EQUALS> > >{
+    template <typename ... _arg_ts> statement(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+}
+
+TEST(test_parser, first_set_dispatch){
+  using namespace dispatch_grammar;
+  using test_parse = xtd::parser<statement, false, whitespace<' ', '\t'>>;
+  using test_parse_no_case = xtd::parser<statement, true, whitespace<' ', '\t'>>;
+  xtd::parse::rule_base::pointer_type ast;
+  std::string s = "LET x = 42";
+  EXPECT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  s = " \tPRINT 7";
+  EXPECT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  s = "PRINTLN y";
+  EXPECT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  s = "print 7";
+  EXPECT_FALSE(test_parse::parse(s.begin(), s.end(), ast));
+  EXPECT_TRUE(test_parse_no_case::parse(s.begin(), s.end(), ast));
+  s = "Let q = 1";
+  EXPECT_TRUE(test_parse_no_case::parse(s.begin(), s.end(), ast));
+  //the nullable alternative is still reachable when no keyword matches
+  s = "=";
+  EXPECT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  s = "";
+  EXPECT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  //a literal cut short by the end of the input doesn't match
+  s = "PRIN";
+  EXPECT_FALSE(test_parse::parse(s.begin(), s.end(), ast));
+  s = "LET x = ";
+  EXPECT_FALSE(test_parse::parse(s.begin(), s.end(), ast));
+}
+
+namespace stream_grammar{
+  using namespace xtd::parse;
+  CHARACTERS_(LOWER, 'a', 'z');
+  CHARACTERS_(UPPER, 'A', 'Z');
+  CHARACTER_(SP, ' ');
+  CHARACTER_(CR, '\r');
+  CHARACTER_(LF, '\n');
+  using word = one_or_more_<or_<LOWER, UPPER>>;
+  struct command : rule<command, and_<word, zero_or_more_<and_<SP, word>>, CR, LF> >{
+    template <typename ... _arg_ts> command(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+  using parser = xtd::stream_parser<command>;
+
+  //named rules so packrat mode has entries to keep between chunks
+  struct token : rule<token, one_or_more_<or_<LOWER, UPPER>> >{
+    template <typename ... _arg_ts> token(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+  struct phrase : rule<phrase, and_<token, zero_or_more_<and_<SP, token>>, CR, LF> >{
+    template <typename ... _arg_ts> phrase(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+  using packrat_parser = xtd::stream_parser<phrase, false, whitespace<>, true>;
+
+  //the message ends in a string terminal that the word separation check doesn't look past
+  STRING_(QUIT);
+  STRING(CRLF, "\r\n");
+  using quit = and_<QUIT, CRLF>;
+}
+
+TEST(test_parser, stream_chunks){
+  std::vector<std::string> oCommands;
+  stream_grammar::parser oParser([&](stream_grammar::parser::pointer_type oAST, const char * pBegin, const char * pEnd){
+    EXPECT_TRUE(oAST->isa(typeid(stream_grammar::command)));
+    oCommands.emplace_back(pBegin, pEnd);
+  });
+  EXPECT_TRUE(oParser.push("DEF"));
+  EXPECT_TRUE(oParser.push("INE x\r"));
+  EXPECT_TRUE(oCommands.empty());
+  EXPECT_TRUE(oParser.push("\nSHOW db\r\nQU"));
+  ASSERT_EQ(2U, oCommands.size());
+  EXPECT_EQ("DEFINE x\r\n", oCommands[0]);
+  EXPECT_EQ("SHOW db\r\n", oCommands[1]);
+  EXPECT_EQ(2U, oParser.buffered());
+  EXPECT_TRUE(oParser.push("IT\r\nHELP\r\nSTATUS\r\n"));
+  ASSERT_EQ(5U, oCommands.size());
+  EXPECT_EQ("QUIT\r\n", oCommands[2]);
+  EXPECT_EQ("STATUS\r\n", oCommands[4]);
+  EXPECT_EQ(0U, oParser.buffered());
+  EXPECT_TRUE(oParser.finish());
+  //a byte at a time
+  oCommands.clear();
+  oParser.reset();
+  std::string s = "MATCH a b\r\nQUIT\r\n";
+  for (auto ch : s) EXPECT_TRUE(oParser.push(&ch, 1));
+  ASSERT_EQ(2U, oCommands.size());
+  EXPECT_EQ("MATCH a b\r\n", oCommands[0]);
+}
+
+TEST(test_parser, stream_string_terminal){
+  using namespace stream_grammar;
+  std::vector<std::string> oCommands;
+  xtd::stream_parser<quit> oParser([&](xtd::stream_parser<quit>::pointer_type, const char * pBegin, const char * pEnd){
+    oCommands.emplace_back(pBegin, pEnd);
+  });
+  EXPECT_TRUE(oParser.push("QUIT\r\n"));
+  ASSERT_EQ(1U, oCommands.size());
+  EXPECT_EQ("QUIT\r\n", oCommands[0]);
+  EXPECT_EQ(0U, oParser.buffered());
+  //an alphanumeric literal at the end of the buffer still waits for the next byte
+  EXPECT_TRUE(oParser.push("QUIT"));
+  EXPECT_EQ(4U, oParser.buffered());
+  EXPECT_TRUE(oParser.push("\r\n"));
+  EXPECT_EQ(2U, oCommands.size());
+}
+
+TEST(test_parser, stream_packrat){
+  using namespace stream_grammar;
+  std::vector<std::string> oCommands;
+  size_t iTokens = 0;
+  packrat_parser oParser([&](packrat_parser::pointer_type oAST, const char * pBegin, const char * pEnd){
+    EXPECT_TRUE(oAST->isa(typeid(phrase)));
+    oCommands.emplace_back(pBegin, pEnd);
+    iTokens += (*oAST)[1]->size() + 1;
+  });
+  //memo entries kept from earlier chunks must not change the result
+  std::string s = "MATCH a b\r\nQUIT\r\n";
+  for (auto ch : s) EXPECT_TRUE(oParser.push(&ch, 1));
+  ASSERT_EQ(2U, oCommands.size());
+  EXPECT_EQ("MATCH a b\r\n", oCommands[0]);
+  EXPECT_EQ("QUIT\r\n", oCommands[1]);
+  EXPECT_EQ(4U, iTokens);
+  //a long message through a buffer that moves as it grows
+  s.clear();
+  for (size_t i = 0; i < 2000; ++i) s += "word ";
+  s += "end\r\n";
+  for (size_t i = 0; i < s.size(); i += 7) EXPECT_TRUE(oParser.push(s.substr(i, 7)));
+  ASSERT_EQ(3U, oCommands.size());
+  EXPECT_EQ(s, oCommands[2]);
+  EXPECT_EQ(2005U, iTokens);
+  EXPECT_TRUE(oParser.push("BAD"));
+  EXPECT_FALSE(oParser.push(" 1"));
+  EXPECT_EQ(s.size() + 21, oParser.error_position());
+}
+
+TEST(test_parser, stream_errors){
+  size_t iCommands = 0;
+  stream_grammar::parser oParser([&](stream_grammar::parser::pointer_type, const char *, const char *){ ++iCommands; });
+  EXPECT_TRUE(oParser.push("HELP\r\nBAD"));
+  EXPECT_EQ(1U, iCommands);
+  //the digit can't continue the message no matter what follows so the error doesn't wait for more data
+  EXPECT_FALSE(oParser.push(" 1"));
+  EXPECT_TRUE(oParser.failed());
+  EXPECT_EQ(10U, oParser.error_position());
+  EXPECT_FALSE(oParser.push("QUIT\r\n"));
+  EXPECT_EQ(1U, iCommands);
+  //a message cut short by the end of the stream
+  oParser.reset();
+  EXPECT_TRUE(oParser.push("QUIT\r"));
+  EXPECT_FALSE(oParser.finish());
+  oParser.reset();
+  EXPECT_TRUE(oParser.push("QUIT\r\n"));
+  EXPECT_TRUE(oParser.finish());
+  EXPECT_EQ(2U, iCommands);
+}
+
+namespace regex_grammar{
+  using namespace xtd::parse;
+  REGEX(NUMBER, "\\d+(\\.\\d+)?");
+  REGEX(YEAR, "(19|20)\\d{2}");
+  REGEX(HEX, "0x[[:xdigit:]]{1,4}");
+  REGEX(NOT_EOL, "\\%[^\\r\\n]*");
+  REGEX(KEYWORD, "(?:if|else|elif)$");
+  REGEX(NOT_A, "[^a]");
+  //every prefix of a's can be split many ways so a backtracking matcher is exponential
+  REGEX(AMBIGUOUS, "(a|aa)*b");
+
+  template <typename _rule_t, bool _ignore_case = false> bool matches(std::string s){
+    xtd::parse::rule_base::pointer_type ast;
+    return xtd::parser<_rule_t, _ignore_case>::parse(s.begin(), s.end(), ast);
+  }
+}
+
+TEST(test_parser, regex_terminal){
+  using namespace regex_grammar;
+  EXPECT_TRUE(matches<test_grammar::Alphabet>("ABC123"));
+  EXPECT_FALSE(matches<test_grammar::Alphabet>("ABC"));
+  EXPECT_TRUE((matches<test_grammar::Alphabet, true>("abc9")));
+  EXPECT_TRUE(matches<NUMBER>("42"));
+  EXPECT_TRUE(matches<NUMBER>("3.14"));
+  EXPECT_FALSE(matches<NUMBER>("3."));
+  EXPECT_TRUE(matches<YEAR>("1999"));
+  EXPECT_TRUE(matches<YEAR>("2024"));
+  EXPECT_FALSE(matches<YEAR>("1899"));
+  EXPECT_FALSE(matches<YEAR>("20245"));
+  EXPECT_TRUE(matches<HEX>("0xBEEF"));
+  EXPECT_FALSE(matches<HEX>("0x"));
+  EXPECT_FALSE(matches<HEX>("0x12345"));
+  EXPECT_TRUE(matches<NOT_EOL>("% a comment"));
+  EXPECT_FALSE(matches<NOT_EOL>("% a\ncomment"));
+  EXPECT_TRUE(matches<KEYWORD>("elif"));
+  EXPECT_FALSE(matches<KEYWORD>("if "));
+  //negated classes exclude both cases of their members when ignoring case
+  EXPECT_FALSE((matches<NOT_A, true>("a")));
+  EXPECT_FALSE((matches<NOT_A, true>("A")));
+  EXPECT_TRUE((matches<NOT_A, true>("b")));
+  EXPECT_TRUE((matches<NOT_A, true>("B")));
+  EXPECT_FALSE((matches<NOT_A>("a")));
+  EXPECT_TRUE((matches<NOT_A>("A")));
+  EXPECT_TRUE(matches<AMBIGUOUS>(std::string(100000, 'a') + "b"));
+  EXPECT_FALSE(matches<AMBIGUOUS>(std::string(100000, 'a')));
+}
+
+TEST(test_parser, regex_value){
+  using namespace regex_grammar;
+  using test_parse = xtd::parser<and_<NUMBER, character<'+'>, NUMBER>, false, whitespace<' '>>;
+  std::string s = "1.5 + 22";
+  xtd::parse::rule_base::pointer_type ast;
+  ASSERT_TRUE(test_parse::parse(s.begin(), s.end(), ast));
+  ASSERT_EQ(3U, ast->size());
+  EXPECT_TRUE((*ast)[0]->isa(typeid(NUMBER)));
+  EXPECT_EQ("1.5", std::static_pointer_cast<NUMBER>((*ast)[0])->value());
+  EXPECT_EQ("22", std::static_pointer_cast<NUMBER>((*ast)[2])->value());
+}
+
+TEST(test_parser, regex_invalid){
+  using xtd::parse::_::regex_program;
+  EXPECT_THROW(regex_program("a(b", false), xtd::exception);
+  EXPECT_THROW(regex_program("a)b", false), xtd::exception);
+  EXPECT_THROW(regex_program("[abc", false), xtd::exception);
+  EXPECT_THROW(regex_program("*a", false), xtd::exception);
+  EXPECT_THROW(regex_program("(a)\\1", false), xtd::exception);
+  EXPECT_THROW(regex_program("a{3,2}", false), xtd::exception);
+  bool bExhausted;
+  std::string s = "a{b";
+  EXPECT_EQ(3U, regex_program("a{b", false).match(s.begin(), s.end(), bExhausted));
+}
+
+namespace parallel_grammar{
+  using namespace xtd::parse;
+  REGEX(ID, "\\d+");
+  REGEX(TEXT, "[a-z ]*");
+  CHARACTER_(TAB, '\t');
+  CHARACTER_(LF, '\n');
+  struct line : rule<line, and_<ID, TAB, TEXT, LF> >{
+    template <typename ... _arg_ts> line(_arg_ts&&...oArgs) : rule(oArgs...){}
+  };
+  using parser = xtd::parallel_parser<line, LF>;
+
+  inline std::string lines(size_t iCount){
+    std::string sRet;
+    for (size_t i = 0; i < iCount; ++i){
+      sRet += std::to_string(i) + "\t" + std::string(i % 37, 'x') + "\n";
+    }
+    return sRet;
+  }
+}
+
+TEST(test_parser, parallel_split){
+  using namespace parallel_grammar;
+  auto s = lines(5000);
+  auto oBounds = parser::split(s.begin(), s.end(), 8, 1024);
+  ASSERT_EQ(9U, oBounds.size());
+  EXPECT_EQ(s.begin(), oBounds.front());
+  EXPECT_EQ(s.end(), oBounds.back());
+  for (size_t i = 1; i < oBounds.size() - 1; ++i){
+    EXPECT_EQ('\n', *(oBounds[i] - 1));
+    EXPECT_TRUE(oBounds[i - 1] < oBounds[i]);
+  }
+  //small inputs aren't split
+  EXPECT_EQ(2U, parser::split(s.begin(), s.end(), 8, s.size()).size());
+}
+
+TEST(test_parser, parallel_records){
+  using namespace parallel_grammar;
+  auto s = lines(20000);
+  std::vector<parser::pointer_type> oRecords;
+  ASSERT_TRUE(parser::parse(s.begin(), s.end(), oRecords, 4, 4096));
+  ASSERT_EQ(20000U, oRecords.size());
+  for (size_t i = 0; i < oRecords.size(); ++i){
+    ASSERT_TRUE(oRecords[i]->isa(typeid(line)));
+    auto pID = std::static_pointer_cast<ID>((*oRecords[i])[0]);
+    ASSERT_EQ(std::to_string(i), pID->value());
+  }
+  //a single worker takes every chunk in turn
+  ASSERT_TRUE(parser::parse(s.begin(), s.end(), oRecords, 1, 4096));
+  ASSERT_EQ(20000U, oRecords.size());
+  EXPECT_EQ("19999", std::static_pointer_cast<ID>((*oRecords.back())[0])->value());
+  //an invalid record stops the parse at the first error in input order
+  auto iBad = s.find("\n12345\t") + 7;
+  s[iBad] = '#';
+  auto oError = s.begin();
+  EXPECT_FALSE(parser::parse(s.begin(), s.end(), oRecords, oError, 4, 4096));
+  EXPECT_EQ(12345U, oRecords.size());
+  EXPECT_EQ(iBad, static_cast<size_t>(oError - s.begin()));
+}
+
+TEST(test_parser, furthest_failure){
+  using namespace packrat_grammar;
+  using error_type = xtd::parse::parse_error<std::string::iterator>;
+  std::string s = "xxabd";
+  xtd::parse::rule_base::pointer_type ast;
+  error_type::vector oErrors;
+  ASSERT_FALSE(nested_parser<false>::parse(s.begin(), s.end(), ast, oErrors));
+  ASSERT_FALSE(oErrors.empty());
+  bool bB = false, bC = false;
+  for (const auto & oError : oErrors){
+    EXPECT_EQ(4, oError->position - s.begin());
+    bB |= (oError->failed_rule == typeid(B));
+    bC |= (oError->failed_rule == typeid(C));
+  }
+  EXPECT_TRUE(bB);
+  EXPECT_TRUE(bC);
+  s = nested_input(2);
+  EXPECT_TRUE(nested_parser<true>::parse(s.begin(), s.end(), ast, oErrors));
+  EXPECT_TRUE(oErrors.empty());
+}
+
+TEST(test_parser, arena_ast){
+  using namespace packrat_grammar;
+  using ast_type = xtd::parse::ast<std::string::iterator>;
+  auto s = nested_input(3);
+  ast_type oAST;
+  ASSERT_TRUE(nested_parser<false>::parse(s.begin(), s.end(), oAST));
+  auto iRoot = oAST.root();
+  EXPECT_TRUE(oAST.isa(iRoot, typeid(nested)));
+  EXPECT_EQ(ast_type::npos, oAST.parent(iRoot));
+  EXPECT_EQ(s.begin(), oAST.begin(iRoot));
+  EXPECT_EQ(s.end(), oAST.end(iRoot));
+  //nested -> and_<X, nested, C> -> X nested C
+  ASSERT_EQ(1U, oAST.child_count(iRoot));
+  auto iAnd = oAST.child(iRoot, 0);
+  ASSERT_EQ(3U, oAST.child_count(iAnd));
+  EXPECT_EQ(iRoot, oAST.parent(iAnd));
+  EXPECT_TRUE(oAST.isa(oAST.child(iAnd, 0), typeid(X)));
+  EXPECT_TRUE(oAST.isa(oAST.child(iAnd, 2), typeid(C)));
+  auto iInner = oAST.child(iAnd, 1);
+  EXPECT_TRUE(oAST.isa(iInner, typeid(nested)));
+  EXPECT_EQ(iAnd, oAST.parent(iInner));
+  EXPECT_EQ(1, oAST.begin(iInner) - s.begin());
+  EXPECT_EQ(6, oAST.end(iInner) - s.begin());
+  //nodes of the failed alternatives are rolled back so every node is reachable from the root
+  EXPECT_EQ(oAST.size(), reachable(oAST));
+  s.back() = 'x';
+  EXPECT_FALSE(nested_parser<false>::parse(s.begin(), s.end(), oAST));
+  EXPECT_EQ(ast_type::npos, oAST.root());
+  EXPECT_EQ(0U, oAST.size());
+}
+
+TEST(test_parser, arena_ast_repetition){
+  using namespace packrat_grammar;
+  std::string s = "n+n+n+n";
+  xtd::parse::ast<std::string::iterator> oAST;
+  ASSERT_TRUE((xtd::parser<terms>::parse(s.begin(), s.end(), oAST)));
+  //the partial and_ the repetition ends on leaves nothing behind
+  EXPECT_EQ(oAST.size(), reachable(oAST));
+  auto iList = oAST.child(oAST.root(), 0);
+  EXPECT_EQ(3U, oAST.child_count(iList));
+}
+
+TEST(test_parser, arena_ast_lookahead){
+  using namespace packrat_grammar;
+  using ast_type = xtd::parse::ast<std::string::iterator>;
+  std::string s = "b";
+  ast_type oAST;
+  ASSERT_TRUE((xtd::parser<guarded>::parse(s.begin(), s.end(), oAST)));
+  EXPECT_EQ(oAST.size(), reachable(oAST));
+  //a lookahead is a zero width leaf
+  auto iAnd = oAST.root();
+  ASSERT_EQ(2U, oAST.child_count(iAnd));
+  auto iNot = oAST.child(iAnd, 0);
+  EXPECT_TRUE(oAST.isa(iNot, typeid(not_<A>)));
+  EXPECT_EQ(0U, oAST.child_count(iNot));
+  EXPECT_EQ(oAST.begin(iNot), oAST.end(iNot));
+  EXPECT_EQ(s.begin(), oAST.begin(oAST.root()));
+  s = "a";
+  EXPECT_FALSE((xtd::parser<guarded>::parse(s.begin(), s.end(), oAST)));
+  s = "n+n";
+  ASSERT_TRUE((xtd::parser<peek>::parse(s.begin(), s.end(), oAST)));
+  EXPECT_EQ(oAST.size(), reachable(oAST));
+  iAnd = oAST.root();
+  ASSERT_EQ(4U, oAST.child_count(iAnd));
+  EXPECT_EQ(1, oAST.begin(oAST.child(iAnd, 1)) - s.begin());
+  EXPECT_EQ(1, oAST.end(oAST.child(iAnd, 1)) - s.begin());
+  ASSERT_TRUE((xtd::parser<peek, false, whitespace<>, true>::parse(s.begin(), s.end(), oAST)));
+  EXPECT_EQ(4U, oAST.child_count(oAST.root()));
+  s = "nn";
+  EXPECT_FALSE((xtd::parser<peek>::parse(s.begin(), s.end(), oAST)));
+}
+
+TEST(test_parser, arena_ast_packrat){
+  using namespace packrat_grammar;
+  using test_parse = xtd::parser<sum, false, whitespace<' '>, true>;
+  std::string s = "n + n + n";
+  xtd::parse::ast<std::string::iterator> oAST;
+  ASSERT_TRUE(test_parse::parse(s.begin(), s.end(), oAST));
+  auto iRoot = oAST.root();
+  EXPECT_TRUE(oAST.isa(iRoot, typeid(sum)));
+  EXPECT_EQ(s.begin(), oAST.begin(iRoot));
+  EXPECT_EQ(s.end(), oAST.end(iRoot));
+  //sum -> and_<sum, PLUS, N> with the left operand covering "n + n"
+  auto iAnd = oAST.child(iRoot, 0);
+  ASSERT_EQ(3U, oAST.child_count(iAnd));
+  auto iLeft = oAST.child(iAnd, 0);
+  EXPECT_TRUE(oAST.isa(iLeft, typeid(sum)));
+  EXPECT_EQ("n + n", std::string(oAST.begin(iLeft), oAST.end(iLeft)));
+  auto iRight = oAST.child(iAnd, 2);
+  EXPECT_TRUE(oAST.isa(iRight, typeid(N)));
+  EXPECT_EQ(8, oAST.begin(iRight) - s.begin());
+}
+
 #if 0
 TEST(test_parser, character_no_case){
   std::string s = "p";
@@ -5,31 +5,58 @@ xtd::rpc system and unit tests
 
 #include <xtd/rpc.hpp>
 
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+#include <sys/wait.h>
+
 class test_rpc : public ::testing::Test{
 public:
-  class Add : public xtd::rpc::rpc_call<Add, int(int, int)> {};
+  class Add : public xtd::rpc::rpc_call<Add, int(int, int)> {
+  public:
+    static constexpr const char * wire_name = "test_rpc.Add";
+  };
   class Echo : public xtd::rpc::rpc_call<Echo, std::string(std::string)> {};
   class Average : public xtd::rpc::rpc_call<Average, double(std::vector<double>)> {};
 
-  using server_type = xtd::rpc::server<xtd::rpc::null_transport , Add, Echo, Average>;
+  struct record {
+    std::string name;
+    std::vector<int64_t> values;
+    std::map<std::string, uint32_t> tags;
+    template <typename _visitor_t> void rpc_fields(_visitor_t& oVisitor) { oVisitor(name, values, tags); }
+  };
+  class Tally : public xtd::rpc::rpc_call<Tally, record(record, int), xtd::rpc::compact_codec> {};
+  class Fail : public xtd::rpc::rpc_call<Fail, int(int)> {};
+
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::shared_memory_transport, Add, Echo, Average, Tally, Fail>;
   using client_type = typename server_type::client_type;
 
   using server_pointer_type = std::shared_ptr<server_type>;
 
+  static const std::string& region_name() {
+    static const std::string sName = "xtd_test_rpc_" + std::to_string(getpid());
+    return sName;
+  }
+
   static server_pointer_type& get_server(){
-    static server_pointer_type oServer(new server_type);
+    static server_pointer_type oServer(new server_type(region_name(), 4096));
     return oServer;
   }
 
   static void SetUpTestCase(){
-    get_server()->attach<Add>([](int a, int b) { return a+b; });
-    get_server()->attach<Echo>([](const std::string& sval) -> std::string { return std::string(sval); });
-    get_server()->attach<Average>([](const std::vector<double>& oVals) -> double {
+    get_server()->get<Add>().attach([](int a, int b) { return a+b; });
+    get_server()->get<Echo>().attach([](const std::string& sval) -> std::string { return std::string(sval); });
+    get_server()->get<Average>().attach([](const std::vector<double>& oVals) -> double {
       double dRet = 0;
       for (auto & oVal : oVals) { dRet += oVal; }
       dRet /= oVals.size();
       return dRet;
     });
+    get_server()->get<Tally>().attach([](const record& oRecord, int iScale) {
+      record oRet(oRecord);
+      for (auto & iVal : oRet.values) iVal *= iScale;
+      oRet.tags["count"] = static_cast<uint32_t>(oRet.values.size());
+      return oRet;
+    });
+    get_server()->get<Fail>().attach([](int) -> int { throw std::runtime_error("handler failed"); });
     get_server()->start_server();
   }
 
@@ -47,7 +74,481 @@ TEST_F(test_rpc, DISABLED_payload){
 //  EXPECT_EQ(oPayload.peek<uint8_t>(), 123);
 }
 
-TEST_F(test_rpc, DISABLED_echo_test){
-  test_rpc::client_type oClient;
-  oClient.call<test_rpc::Echo>("Hello?");
+TEST_F(test_rpc, shared_memory_round_trip){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  EXPECT_EQ(5, oClient.call<test_rpc::Add>(2, 3));
+  EXPECT_EQ("Hello?", oClient.call<test_rpc::Echo>(std::string("Hello?")));
+  EXPECT_EQ(2.0, oClient.call<test_rpc::Average>(std::vector<double>{1.0, 2.0, 3.0}));
+  //larger than the 4K rings so both directions stream through them
+  std::string sLarge(50000, 'x');
+  EXPECT_EQ(sLarge, oClient.call<test_rpc::Echo>(sLarge));
+}
+
+TEST_F(test_rpc, shared_memory_call_async){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  std::vector<std::future<int>> oSums;
+  for (int i = 0; i < 100; ++i) oSums.push_back(oClient.call_async<test_rpc::Add>(i, i));
+  auto oEcho = oClient.call_async<test_rpc::Echo>(std::string("pipelined"));
+  //a synchronous call with replies still outstanding
+  EXPECT_EQ(7, oClient.call<test_rpc::Add>(3, 4));
+  EXPECT_EQ("pipelined", oEcho.get());
+  //collected in reverse to exercise out of order completion
+  for (int i = 99; i >= 0; --i) EXPECT_EQ(2 * i, oSums[i].get());
+}
+
+TEST_F(test_rpc, shared_memory_call_async_poll){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  auto oSum = oClient.call_async<test_rpc::Add>(20, 22);
+  //nothing waits on the reply yet it still arrives
+  EXPECT_EQ(std::future_status::ready, oSum.wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(42, oSum.get());
+  //abandoned calls don't hold up or leak into later ones
+  for (int i = 0; i < 10; ++i) oClient.call_async<test_rpc::Add>(i, i);
+  EXPECT_EQ(3, oClient.call<test_rpc::Add>(1, 2));
+  auto oFail = oClient.call_async<test_rpc::Fail>(1);
+  EXPECT_THROW(oFail.get(), xtd::exception);
+}
+
+TEST_F(test_rpc, wire_id){
+  EXPECT_EQ(xtd::rpc::_::fnv1a("test_rpc.Add"), test_rpc::Add::wire_id());
+  EXPECT_NE(test_rpc::Echo::wire_id(), test_rpc::Average::wire_id());
+}
+
+TEST_F(test_rpc, different_call_order){
+  //built from a different call list so the server can't use the client's index
+  xtd::rpc::rpc_client<xtd::rpc::shared_memory_transport, test_rpc::Echo, test_rpc::Add> oClient(test_rpc::region_name());
+  EXPECT_EQ(9, oClient.call<test_rpc::Add>(4, 5));
+  EXPECT_EQ("reordered", oClient.call<test_rpc::Echo>(std::string("reordered")));
+}
+
+TEST_F(test_rpc, batch){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  auto oBatch = oClient.batch();
+  std::vector<std::future<int>> oSums;
+  for (int i = 0; i < 20; ++i) oSums.push_back(oBatch.add<test_rpc::Add>(i, 1));
+  auto oEcho = oBatch.add<test_rpc::Echo>(std::string("batched"));
+  auto oAverage = oBatch.add<test_rpc::Average>(std::vector<double>{2.0, 4.0});
+  EXPECT_EQ(22, oBatch.size());
+  oBatch.send();
+  for (int i = 0; i < 20; ++i) EXPECT_EQ(i + 1, oSums[i].get());
+  EXPECT_EQ("batched", oEcho.get());
+  EXPECT_EQ(3.0, oAverage.get());
+  //the builder is reusable after send
+  auto oSum = oBatch.add<test_rpc::Add>(40, 2);
+  oBatch.send();
+  EXPECT_EQ(42, oSum.get());
+}
+
+TEST_F(test_rpc, compact_call){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  test_rpc::record oRecord;
+  oRecord.name = "sensor";
+  oRecord.values = { 1, -2, 300 };
+  oRecord.tags["unit"] = 7;
+  auto oRet = oClient.call<test_rpc::Tally>(oRecord, -3);
+  EXPECT_EQ("sensor", oRet.name);
+  ASSERT_EQ(3, oRet.values.size());
+  EXPECT_EQ(-900, oRet.values[2]);
+  EXPECT_EQ(7, oRet.tags["unit"]);
+  EXPECT_EQ(3, oRet.tags["count"]);
+}
+
+TEST_F(test_rpc, shared_memory_single_client){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  EXPECT_EQ(3, oClient.call<test_rpc::Add>(1, 2));
+  test_rpc::client_type oSecond(test_rpc::region_name());
+  EXPECT_THROW(oSecond.call<test_rpc::Add>(1, 2), xtd::exception);
+}
+
+TEST_F(test_rpc, shared_memory_server_in_use){
+  test_rpc::server_type oOther(test_rpc::region_name(), 4096);
+  EXPECT_THROW(oOther.start_server(), xtd::exception);
+  test_rpc::client_type oClient(test_rpc::region_name());
+  EXPECT_EQ(3, oClient.call<test_rpc::Add>(1, 2));
+}
+
+TEST_F(test_rpc, shared_memory_stale_region){
+  auto sName = test_rpc::region_name() + "_stale";
+  auto iChild = fork();
+  ASSERT_NE(-1, iChild);
+  if (!iChild) {
+    //creates the region and dies without removing it
+    test_rpc::server_type oServer(sName, 4096);
+    oServer.start_server();
+    _exit(0);
+  }
+  int iStatus;
+  ASSERT_EQ(iChild, waitpid(iChild, &iStatus, 0));
+  test_rpc::server_type oServer(sName, 4096);
+  oServer.get<test_rpc::Add>().attach([](int a, int b) { return a + b; });
+  oServer.start_server();
+  test_rpc::client_type oClient(sName);
+  EXPECT_EQ(3, oClient.call<test_rpc::Add>(1, 2));
+  oServer.stop_server();
+}
+
+TEST_F(test_rpc, shared_memory_crashed_client){
+  auto iChild = fork();
+  ASSERT_NE(-1, iChild);
+  if (!iChild) {
+    //attaches and leaves a request in flight without detaching
+    test_rpc::client_type oClient(test_rpc::region_name());
+    oClient.call<test_rpc::Add>(1, 2);
+    oClient.call_async<test_rpc::Echo>(std::string(10000, 'z'));
+    _exit(0);
+  }
+  int iStatus;
+  ASSERT_EQ(iChild, waitpid(iChild, &iStatus, 0));
+  test_rpc::client_type oClient(test_rpc::region_name());
+  EXPECT_EQ(7, oClient.call<test_rpc::Add>(3, 4));
+  EXPECT_EQ("after", oClient.call<test_rpc::Echo>(std::string("after")));
+}
+
+TEST_F(test_rpc, shared_memory_malformed_request){
+  {
+    //a length shorter than the header resets the connection instead of leaving the client waiting
+    xtd::rpc::shared_memory_transport oRaw(test_rpc::region_name());
+    xtd::rpc::payload oPayload;
+    oPayload.resize(sizeof(size_t));
+    oRaw.send(oPayload);
+    EXPECT_THROW(oRaw.receive(oPayload), xtd::exception);
+    EXPECT_THROW(oRaw.send(oPayload), xtd::exception);
+  }
+  //the region is freed once the client detaches
+  test_rpc::client_type oClient(test_rpc::region_name());
+  EXPECT_EQ(3, oClient.call<test_rpc::Add>(1, 2));
+}
+
+TEST_F(test_rpc, shared_memory_destroy_client){
+  auto sName = test_rpc::region_name() + "_gate";
+  test_rpc::server_type oServer(sName, 4096);
+  std::promise<void> oRelease;
+  auto oReleased = oRelease.get_future().share();
+  oServer.get<test_rpc::Add>().attach([](int a, int b) { return a + b; });
+  oServer.get<test_rpc::Echo>().attach([oReleased](const std::string& sVal) {
+    oReleased.wait();
+    return sVal;
+  });
+  oServer.start_server();
+  std::future<std::string> oStuck;
+  {
+    test_rpc::client_type oClient(sName);
+    oStuck = oClient.call_async<test_rpc::Echo>(std::string("unread"));
+  }
+  //the client went away without waiting for the reply so the call fails
+  EXPECT_THROW(oStuck.get(), xtd::exception);
+  oRelease.set_value();
+  test_rpc::client_type oClient(sName);
+  EXPECT_EQ(3, oClient.call<test_rpc::Add>(1, 2));
+  oServer.stop_server();
+}
+
+TEST_F(test_rpc, shared_memory_handler_throws){
+  test_rpc::client_type oClient(test_rpc::region_name());
+  EXPECT_THROW(oClient.call<test_rpc::Fail>(1), xtd::exception);
+  EXPECT_EQ(5, oClient.call<test_rpc::Add>(2, 3));
+}
+#endif
+
+TEST(test_rpc_marshaler, payload_reader){
+  using namespace xtd::rpc;
+  payload oPayload;
+  marshaler<false, int, std::string, std::vector<uint16_t>>::marshal(oPayload, 42, std::string("abc"), std::vector<uint16_t>{7, 8});
+  auto oReader = oPayload.reader();
+  int iVal;
+  std::string sVal;
+  std::vector<uint16_t> oVals;
+  marshaler<false, int&, std::string&, std::vector<uint16_t>&>::unmarshal(oReader, iVal, sVal, oVals);
+  EXPECT_EQ(42, iVal);
+  EXPECT_EQ("abc", sVal);
+  ASSERT_EQ(2, oVals.size());
+  EXPECT_EQ(8, oVals[1]);
+  EXPECT_EQ(0, oReader.remaining());
+}
+
+TEST(test_rpc_marshaler, array_view){
+  using namespace xtd::rpc;
+  payload oPayload;
+  std::vector<double> oSrc{1.5, 2.5, 3.5};
+  marshaler<false, std::vector<double>&>::marshal(oPayload, oSrc);
+  auto oReader = oPayload.reader();
+  array_view<double> oView;
+  marshaler<false, array_view<double>&>::unmarshal(oReader, oView);
+  ASSERT_EQ(3, oView.size());
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(oView.data()) % alignof(double));
+  EXPECT_EQ(3.5, oView[2]);
+}
+
+TEST(test_rpc_marshaler, malformed_payload){
+  using namespace xtd::rpc;
+  payload oPayload;
+  marshaler<false, std::string>::marshal(oPayload, std::string("abc"));
+  oPayload.pop_back();
+  auto oReader = oPayload.reader();
+  std::string sVal;
+  EXPECT_THROW((marshaler<false, std::string&>::unmarshal(oReader, sVal)), xtd::exception);
+}
+
+TEST(test_rpc_marshaler, compact_integers){
+  using namespace xtd::rpc;
+  payload_t oPayload;
+  compact_codec::marshal(oPayload, static_cast<size_t>(5));
+  EXPECT_EQ(1, oPayload.size());
+  compact_codec::marshal(oPayload, static_cast<uint32_t>(300));
+  EXPECT_EQ(3, oPayload.size());
+  compact_codec::marshal(oPayload, static_cast<int64_t>(-1));
+  EXPECT_EQ(4, oPayload.size());
+  compact_codec::marshal(oPayload, std::numeric_limits<int64_t>::min());
+  payload_reader oReader(oPayload);
+  size_t iSize;
+  uint32_t iUnsigned;
+  int64_t iSmall, iMin;
+  compact_codec::unmarshal(oReader, iSize);
+  compact_codec::unmarshal(oReader, iUnsigned);
+  compact_codec::unmarshal(oReader, iSmall);
+  compact_codec::unmarshal(oReader, iMin);
+  EXPECT_EQ(5, iSize);
+  EXPECT_EQ(300, iUnsigned);
+  EXPECT_EQ(-1, iSmall);
+  EXPECT_EQ(std::numeric_limits<int64_t>::min(), iMin);
+  EXPECT_EQ(0, oReader.remaining());
+}
+
+TEST(test_rpc_marshaler, compact_overflow){
+  using namespace xtd::rpc;
+  payload_t oPayload;
+  compact_codec::marshal(oPayload, static_cast<uint32_t>(70000));
+  payload_reader oReader(oPayload);
+  uint16_t iVal;
+  EXPECT_THROW(compact_codec::unmarshal(oReader, iVal), xtd::exception);
+}
+
+TEST(test_rpc_marshaler, payload_pool){
+  using namespace xtd::rpc;
+  payload_pool oPool;
+  const uint8_t * pData;
+  size_t iCapacity;
+  {
+    auto oPayload = oPool.acquire();
+    marshaler<false, std::string>::marshal(*oPayload, std::string(1000, 'x'));
+    pData = oPayload->data();
+    iCapacity = oPayload->capacity();
+  }
+  auto oPayload = oPool.acquire();
+  const size_t iHeaderSize = payload::header_size;
+  EXPECT_EQ(iHeaderSize, oPayload->size());
+  EXPECT_EQ(iCapacity, oPayload->capacity());
+  EXPECT_EQ(pData, oPayload->data());
+}
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+namespace {
+  class RemoteAdd : public xtd::rpc::rpc_call<RemoteAdd, int(int, int)> {};
+  class RemoteEcho : public xtd::rpc::rpc_call<RemoteEcho, std::string(std::string)> {};
+  class RemoteSleep : public xtd::rpc::rpc_call<RemoteSleep, int(int)> {};
+
+  template <typename _server_t> void attach_stream_calls(_server_t& oServer) {
+    oServer.template get<RemoteAdd>().attach([](int a, int b) { return a + b; });
+    oServer.template get<RemoteEcho>().attach([](const std::string& sval) { return sval; });
+  }
+}
+
+TEST(test_rpc_transport, tcp_round_trip){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::tcp_transport, RemoteAdd, RemoteEcho>;
+  server_type oServer(xtd::socket::ipv4address("127.0.0.1", 0), 2);
+  attach_stream_calls(oServer);
+  oServer.start_server();
+  server_type::client_type oClient(oServer.address());
+  EXPECT_EQ(5, oClient.call<RemoteAdd>(2, 3));
+  std::string sLarge(200000, 'y');
+  EXPECT_EQ(sLarge, oClient.call<RemoteEcho>(sLarge));
+  oServer.stop_server();
+}
+
+TEST(test_rpc_transport, tcp_bad_requests){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::tcp_transport, RemoteAdd, RemoteEcho, RemoteSleep>;
+  server_type oServer(xtd::socket::ipv4address("127.0.0.1", 0), 1, 4096);
+  attach_stream_calls(oServer);
+  oServer.get<RemoteSleep>().attach([](int) -> int { throw std::runtime_error("handler failed"); });
+  oServer.start_server();
+  auto connect_raw = [&oServer]() {
+    auto iFD = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    EXPECT_EQ(0, ::connect(iFD, reinterpret_cast<const sockaddr*>(&oServer.address()), sizeof(server_type::address_type)));
+    return iFD;
+  };
+  //a header with no call is answered with an empty reply
+  auto iFD = connect_raw();
+  xtd::rpc::payload oRequest;
+  oRequest.request_id(7);
+  oRequest.embed_length();
+  ASSERT_EQ(static_cast<ssize_t>(oRequest.size()), ::send(iFD, oRequest.data(), oRequest.size(), MSG_NOSIGNAL));
+  xtd::rpc::payload oReply;
+  ASSERT_EQ(static_cast<ssize_t>(oReply.size()), ::recv(iFD, oReply.data(), oReply.size(), MSG_WAITALL));
+  EXPECT_EQ(oReply.size(), oReply.peek<size_t>());
+  EXPECT_EQ(7, oReply.request_id());
+  close(iFD);
+  //an oversized request closes the connection
+  iFD = connect_raw();
+  size_t iLen = 1 << 20;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(iLen)), ::send(iFD, &iLen, sizeof(iLen), MSG_NOSIGNAL));
+  EXPECT_EQ(0, ::recv(iFD, &iLen, sizeof(iLen), 0));
+  close(iFD);
+  //a throwing handler fails only its own call
+  server_type::client_type oClient(oServer.address());
+  EXPECT_THROW(oClient.call<RemoteSleep>(1), xtd::exception);
+  EXPECT_EQ(5, oClient.call<RemoteAdd>(2, 3));
+  oServer.stop_server();
+}
+
+TEST(test_rpc_transport, mismatched_reply){
+  using client_type = xtd::rpc::rpc_client<xtd::rpc::tcp_transport, RemoteAdd>;
+  //a peer that answers every request with the wire id of another call
+  xtd::socket::ipv4address oAddress("127.0.0.1", 0);
+  auto iListen = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  socklen_t iLen = sizeof(oAddress);
+  ASSERT_EQ(0, bind(iListen, reinterpret_cast<const sockaddr*>(&oAddress), sizeof(oAddress)));
+  ASSERT_EQ(0, listen(iListen, 1));
+  ASSERT_EQ(0, getsockname(iListen, reinterpret_cast<sockaddr*>(&oAddress), &iLen));
+  std::thread oPeer([iListen]() {
+    auto iFD = accept4(iListen, nullptr, nullptr, SOCK_CLOEXEC);
+    xtd::rpc::payload oRequest;
+    if (static_cast<ssize_t>(oRequest.size()) != ::recv(iFD, oRequest.data(), oRequest.size(), MSG_WAITALL)) return;
+    std::vector<uint8_t> oRest(oRequest.peek<size_t>() - oRequest.size());
+    ::recv(iFD, oRest.data(), oRest.size(), MSG_WAITALL);
+    xtd::rpc::payload oReply;
+    oReply.request_id(oRequest.request_id());
+    xtd::rpc::marshaler<false, uint64_t>::marshal(oReply, RemoteEcho::wire_id());
+    oReply.embed_length();
+    ::send(iFD, oReply.data(), oReply.size(), MSG_NOSIGNAL);
+    ::recv(iFD, oRest.data(), 1, 0);
+    close(iFD);
+  });
+  {
+    client_type oClient(oAddress);
+    EXPECT_THROW(oClient.call<RemoteAdd>(1, 2), xtd::exception);
+  }
+  oPeer.join();
+  close(iListen);
+}
+
+TEST(test_rpc_transport, unix_many_clients){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::unix_transport, RemoteAdd, RemoteEcho>;
+  std::string sPath = "/tmp/xtd_test_rpc_" + std::to_string(getpid());
+  server_type oServer(xtd::socket::unix_address(sPath.c_str()), 2);
+  attach_stream_calls(oServer);
+  oServer.start_server();
+  std::vector<std::unique_ptr<server_type::client_type>> oClients;
+  for (int i = 0; i < 64; ++i) oClients.emplace_back(new server_type::client_type(oServer.address()));
+  std::vector<std::thread> oThreads;
+  std::atomic<int> iFailures(0);
+  for (int t = 0; t < 4; ++t) {
+    oThreads.emplace_back([&, t]() {
+      for (int round = 0; round < 10; ++round) {
+        for (int i = t; i < 64; i += 4) {
+          if (i + round != oClients[i]->call<RemoteAdd>(i, round)) ++iFailures;
+        }
+      }
+    });
+  }
+  for (auto & oThread : oThreads) oThread.join();
+  EXPECT_EQ(0, iFailures.load());
+  oClients.clear();
+  oServer.stop_server();
+}
+
+TEST(test_rpc_transport, tcp_call_async_from_threads){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::tcp_transport, RemoteAdd, RemoteEcho>;
+  server_type oServer(xtd::socket::ipv4address("127.0.0.1", 0));
+  attach_stream_calls(oServer);
+  oServer.start_server();
+  server_type::client_type oClient(oServer.address());
+  std::atomic<int> iFailures(0);
+  std::vector<std::thread> oThreads;
+  for (int t = 0; t < 4; ++t) {
+    oThreads.emplace_back([&, t]() {
+      std::vector<std::future<int>> oSums;
+      for (int i = 0; i < 50; ++i) oSums.push_back(oClient.call_async<RemoteAdd>(t, i));
+      for (int i = 0; i < 50; ++i) {
+        if (t + i != oSums[i].get()) ++iFailures;
+      }
+    });
+  }
+  for (auto & oThread : oThreads) oThread.join();
+  EXPECT_EQ(0, iFailures.load());
+  oServer.stop_server();
+}
+TEST(test_rpc_transport, worker_pool){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::tcp_transport, RemoteAdd, RemoteSleep>;
+  server_type oServer(xtd::socket::ipv4address("127.0.0.1", 0));
+  std::atomic<int> iRunning(0), iMaxRunning(0);
+  std::promise<void> oStarted, oRelease;
+  std::once_flag oStartedOnce;
+  auto oReleased = oRelease.get_future().share();
+  oServer.get<RemoteAdd>().attach([](int a, int b) { return a + b; });
+  oServer.get<RemoteSleep>().attach([&, oReleased](int iMS) {
+    auto iNow = ++iRunning;
+    for (auto iMax = iMaxRunning.load(); iNow > iMax && !iMaxRunning.compare_exchange_weak(iMax, iNow);) {}
+    std::call_once(oStartedOnce, [&] { oStarted.set_value(); });
+    oReleased.wait();
+    --iRunning;
+    return iMS;
+  });
+  oServer.workers(4);
+  //limited through the nested level that get<>() returns
+  oServer.get<RemoteSleep>().concurrency_limit<RemoteSleep>(1);
+  oServer.start_server();
+  server_type::client_type oClient(oServer.address());
+  std::vector<std::future<int>> oSleeps;
+  for (int i = 0; i < 3; ++i) oSleeps.push_back(oClient.call_async<RemoteSleep>(50));
+  oStarted.get_future().wait();
+  //a fast call isn't held up behind the slow ones and its reply overtakes theirs
+  auto oAdd = oClient.call_async<RemoteAdd>(1, 2);
+  EXPECT_EQ(std::future_status::ready, oAdd.wait_for(std::chrono::seconds(30)));
+  for (auto & oSleep : oSleeps) EXPECT_NE(std::future_status::ready, oSleep.wait_for(std::chrono::seconds(0)));
+  oRelease.set_value();
+  EXPECT_EQ(3, oAdd.get());
+  for (auto & oSleep : oSleeps) EXPECT_EQ(50, oSleep.get());
+  EXPECT_EQ(1, iMaxRunning.load());
+  oServer.stop_server();
+}
+
+TEST(test_rpc_transport, destroy_client_with_calls_outstanding){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::tcp_transport, RemoteAdd, RemoteSleep>;
+  server_type oServer(xtd::socket::ipv4address("127.0.0.1", 0));
+  std::promise<void> oRelease;
+  auto oReleased = oRelease.get_future().share();
+  oServer.get<RemoteAdd>().attach([](int a, int b) { return a + b; });
+  oServer.get<RemoteSleep>().attach([oReleased](int iMS) {
+    oReleased.wait();
+    return iMS;
+  });
+  oServer.workers(2);
+  oServer.start_server();
+  std::future<int> oStuck;
+  {
+    server_type::client_type oClient(oServer.address());
+    oStuck = oClient.call_async<RemoteSleep>(1);
+  }
+  //the client went away without waiting for the reply so the call fails
+  EXPECT_THROW(oStuck.get(), std::exception);
+  oRelease.set_value();
+  server_type::client_type oClient(oServer.address());
+  EXPECT_EQ(3, oClient.call<RemoteAdd>(1, 2));
+  oServer.stop_server();
+}
+
+TEST(test_rpc_transport, handler_throws){
+  using server_type = xtd::rpc::rpc_server<xtd::rpc::tcp_transport, RemoteAdd, RemoteSleep>;
+  for (size_t iWorkers : { 0, 2 }) {
+    server_type oServer(xtd::socket::ipv4address("127.0.0.1", 0));
+    oServer.get<RemoteAdd>().attach([](int a, int b) { return a + b; });
+    oServer.get<RemoteSleep>().attach([](int) -> int { throw std::runtime_error("handler failed"); });
+    oServer.workers(iWorkers);
+    oServer.start_server();
+    server_type::client_type oClient(oServer.address());
+    EXPECT_THROW(oClient.call<RemoteSleep>(1), xtd::exception);
+    EXPECT_EQ(3, oClient.call<RemoteAdd>(1, 2));
+    oServer.stop_server();
+  }
 }
+#endif
@@ -8,6 +8,10 @@ xtd::socket system and unit tests
 
 #include <xtd/socket.hpp>
 
+#if (XTD_OS_UNIX & XTD_OS)
+  #include <fcntl.h>
+#endif
+
 TEST(test_socket, ipv4_initialization){
 
   ASSERT_NO_THROW(xtd::socket::ipv4_tcp_stream oSocket);
@@ -119,3 +123,358 @@ TEST(test_socket, ipv4_stream){
 }
 
 
+
+TEST(test_socket, large_pod_vector){
+  static constexpr uint16_t iPort = 8856;
+  std::vector<int> oSent(1000000);
+  for (size_t i = 0; i < oSent.size(); ++i) oSent[i] = static_cast<int>(i * 7);
+
+  xtd::socket::ipv4_tcp_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  auto oReceived = std::async(std::launch::async, [&oServer](){
+    auto oConnection = oServer.accept<xtd::socket::ipv4_tcp_stream>();
+    auto oRet = oConnection.read<std::vector<int>>();
+    auto iTail = oConnection.read<int>();
+    oConnection.write(iTail + 1);
+    return oRet;
+  });
+  xtd::socket::ipv4_tcp_stream oClient;
+  oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oClient.write(oSent, true);
+  oClient.write(41);
+  ASSERT_EQ(42, oClient.read<int>());
+  ASSERT_EQ(oSent, oReceived.get());
+}
+
+TEST(test_socket, nested_vector){
+  static constexpr uint16_t iPort = 8857;
+  std::vector<std::vector<uint16_t>> oSent;
+  for (uint16_t i = 0; i < 1000; ++i) oSent.push_back(std::vector<uint16_t>(i % 17, i));
+
+  xtd::socket::ipv4_tcp_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  auto oReceived = std::async(std::launch::async, [&oServer](){
+    auto oConnection = oServer.accept<xtd::socket::ipv4_tcp_stream>();
+    return oConnection.read<std::vector<std::vector<uint16_t>>>();
+  });
+  xtd::socket::ipv4_tcp_stream oClient;
+  oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oClient.write(oSent);
+  ASSERT_EQ(oSent, oReceived.get());
+}
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+TEST(test_socket, send_file){
+  static constexpr uint16_t iPort = 8858;
+  std::string sContents(100000, 'x');
+  for (size_t i = 0; i < sContents.size(); ++i) sContents[i] = static_cast<char>('a' + i % 26);
+  auto pFile = tmpfile();
+  ASSERT_NE(nullptr, pFile);
+  ASSERT_EQ(sContents.size(), fwrite(sContents.data(), 1, sContents.size(), pFile));
+  fflush(pFile);
+
+  xtd::socket::ipv4_tcp_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  auto oReceived = std::async(std::launch::async, [&oServer](){
+    auto oConnection = oServer.accept<xtd::socket::ipv4_tcp_stream>();
+    std::string sRet(99990, 0);
+    oConnection.recv_all(&sRet[0], sRet.size());
+    return sRet;
+  });
+  xtd::socket::ipv4_tcp_stream oClient;
+  oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oClient.cork(true);
+  oClient.send_file(fileno(pFile), 10, sContents.size() - 10);
+  oClient.cork(false);
+  ASSERT_EQ(sContents.substr(10), oReceived.get());
+  fclose(pFile);
+}
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+TEST(test_socket, reactor_many_connections){
+  using reactive_stream = xtd::socket::socket_base<xtd::socket::ipv4address, xtd::socket::socket_type::stream, xtd::socket::socket_protocol::tcp, xtd::socket::socket_options, xtd::socket::bindable_socket, xtd::socket::listening_socket, xtd::socket::polling_socket>;
+  static constexpr uint16_t iPort = 8859;
+  static constexpr int iClients = 500;
+
+  xtd::socket::reactor oReactor;
+  std::vector<std::unique_ptr<reactive_stream>> oConnections;
+  reactive_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  oServer.read_event += [&](){
+    while (auto pConnection = oServer.try_accept<reactive_stream>()){
+      auto pRaw = pConnection.get();
+      pRaw->read_event += [pRaw](){
+        while (pRaw->bytes_available() >= sizeof(int)){
+          int iValue;
+          pRaw->recv_all(&iValue, sizeof(iValue));
+          ++iValue;
+          pRaw->send_all(&iValue, sizeof(iValue));
+        }
+      };
+      oReactor.add(*pRaw);
+      oConnections.push_back(std::move(pConnection));
+    }
+  };
+  oReactor.add(oServer);
+  std::thread oLoop([&oReactor](){ oReactor.run(); });
+
+  std::vector<std::unique_ptr<xtd::socket::ipv4_tcp_stream>> oClients;
+  for (int i = 0; i < iClients; ++i){
+    oClients.emplace_back(new xtd::socket::ipv4_tcp_stream);
+    oClients.back()->connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+    oClients.back()->write(i);
+  }
+  for (int i = 0; i < iClients; ++i){
+    EXPECT_EQ(i + 1, oClients[i]->read<int>());
+  }
+  oReactor.stop();
+  oLoop.join();
+  EXPECT_EQ(static_cast<size_t>(iClients + 1), oReactor.size());
+}
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+TEST(test_socket, async_futures){
+  static constexpr uint16_t iPort = 8860;
+  xtd::socket::reactor oReactor;
+  std::thread oLoop([&oReactor](){ oReactor.run(); });
+
+  xtd::socket::ipv4_tcp_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  xtd::socket::async_socket<xtd::socket::ipv4_tcp_stream> oAsyncServer(oReactor, oServer);
+  auto oAccepted = oAsyncServer.accept<xtd::socket::ipv4_tcp_stream>();
+
+  xtd::socket::ipv4_tcp_stream oClient;
+  xtd::socket::async_socket<xtd::socket::ipv4_tcp_stream> oAsyncClient(oReactor, oClient);
+  ASSERT_NO_THROW(oAsyncClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort)).get());
+  auto pConnection = oAccepted.get();
+  ASSERT_TRUE(!!pConnection);
+  xtd::socket::async_socket<xtd::socket::ipv4_tcp_stream> oAsyncConnection(oReactor, *pConnection);
+
+  std::vector<int> oSent(100000, 3);
+  auto oRead = oAsyncConnection.read<size_t>();
+  auto oWritten = oAsyncClient.write(oSent);
+  EXPECT_EQ(oSent.size(), oRead.get());
+  std::vector<int> oReceived(oSent.size());
+  ASSERT_NO_THROW(oAsyncConnection.read(oReceived.data(), oReceived.size() * sizeof(int)).get());
+  ASSERT_NO_THROW(oWritten.get());
+  EXPECT_EQ(oSent, oReceived);
+
+  oClient.close();
+  char cByte;
+  EXPECT_EQ(0U, oAsyncConnection.read_some(&cByte, 1).get());
+  oReactor.stop();
+  oLoop.join();
+}
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && XTD_CPP_COROUTINES
+namespace{
+  using async_stream = xtd::socket::async_socket<xtd::socket::ipv4_tcp_stream>;
+
+  xtd::socket::detached_task coroutine_echo(xtd::socket::reactor& oReactor, std::shared_ptr<xtd::socket::ipv4_tcp_stream> pConnection){
+    async_stream oConnection(oReactor, *pConnection);
+    for (auto iValue = co_await oConnection.co_read<int>(); iValue; iValue = co_await oConnection.co_read<int>()){
+      co_await oConnection.co_write(iValue * 2);
+    }
+  }
+
+  xtd::socket::detached_task coroutine_server(xtd::socket::reactor& oReactor, async_stream& oListener, int iConnections){
+    for (; iConnections; --iConnections){
+      coroutine_echo(oReactor, co_await oListener.co_accept<xtd::socket::ipv4_tcp_stream>());
+    }
+  }
+}
+
+TEST(test_socket, async_coroutines){
+  static constexpr uint16_t iPort = 8861;
+  xtd::socket::reactor oReactor;
+  xtd::socket::ipv4_tcp_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  async_stream oListener(oReactor, oServer);
+  coroutine_server(oReactor, oListener, 4);
+  std::thread oLoop([&oReactor](){ oReactor.run(); });
+
+  //hanging up mid read fails only that connection's handler
+  {
+    xtd::socket::ipv4_tcp_stream oClient;
+    oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+    oClient.write(static_cast<char>(1));
+  }
+  for (int iClient = 1; iClient <= 3; ++iClient){
+    xtd::socket::ipv4_tcp_stream oClient;
+    oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+    oClient.write(iClient);
+    EXPECT_EQ(iClient * 2, oClient.read<int>());
+    oClient.write(0);
+  }
+  oReactor.stop();
+  oLoop.join();
+}
+#endif
+
+TEST(test_socket, udp_datagram){
+  xtd::socket::ipv4_udp_socket oReceiver;
+  oReceiver.bind(xtd::socket::ipv4address("127.0.0.1", 8862));
+  xtd::socket::ipv4_udp_socket oSender;
+  oSender.send_to("hello", 5, xtd::socket::ipv4address("127.0.0.1", 8862));
+  char sBuffer[16];
+  xtd::socket::ipv4address oFrom("0.0.0.0", 0);
+  ASSERT_EQ(5U, oReceiver.recv_from(sBuffer, sizeof(sBuffer), oFrom));
+  EXPECT_EQ(std::string("hello"), std::string(sBuffer, 5));
+  EXPECT_EQ(htonl(INADDR_LOOPBACK), oFrom.sin_addr.s_addr);
+}
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+TEST(test_socket, udp_batch){
+  static constexpr uint16_t iPort = 8863;
+  static constexpr uint32_t iDatagrams = 1000;
+  xtd::socket::ipv4_udp_socket oReceiver;
+  oReceiver.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  xtd::socket::ipv4_udp_socket oSender;
+
+  xtd::socket::datagram_batch<xtd::socket::ipv4address> oOut(32, 64);
+  xtd::socket::datagram_batch<xtd::socket::ipv4address> oIn(32, 64);
+  std::vector<bool> oSeen(iDatagrams, false);
+  uint32_t iReceived = 0;
+  for (uint32_t i = 0; i < iDatagrams; ++i){
+    ASSERT_TRUE(oOut.push_back(&i, sizeof(i), xtd::socket::ipv4address("127.0.0.1", iPort)));
+    if (oOut.size() == oOut.capacity() || i + 1 == iDatagrams){
+      oSender.send_batch(oOut);
+      ASSERT_EQ(0U, oOut.size());
+      //drain as we go so loopback never drops datagrams from a full receive buffer
+      while (auto iCount = oReceiver.recv_batch(oIn, false)){
+        for (size_t j = 0; j < iCount; ++j){
+          ASSERT_EQ(sizeof(uint32_t), oIn.length(j));
+          uint32_t iValue;
+          memcpy(&iValue, oIn.data(j), sizeof(iValue));
+          ASSERT_LT(iValue, iDatagrams);
+          oSeen[iValue] = true;
+          ++iReceived;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(iDatagrams, iReceived);
+  EXPECT_EQ(oSeen.end(), std::find(oSeen.begin(), oSeen.end(), false));
+}
+#endif
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+TEST(test_socket, listener_group){
+  static constexpr uint16_t iPort = 8864;
+  static constexpr int iClients = 50;
+  xtd::socket::listener_group<xtd::socket::ipv4_tcp_stream> oGroup(xtd::socket::ipv4address("127.0.0.1", iPort), 4);
+  ASSERT_EQ(4U, oGroup.size());
+  ASSERT_TRUE(oGroup[0].reuse_port());
+  ASSERT_NO_THROW(oGroup.steer_by_cpu());
+
+  std::atomic<int> iServed(0);
+  oGroup.start<xtd::socket::ipv4_tcp_stream>([&iServed](size_t, std::unique_ptr<xtd::socket::ipv4_tcp_stream> pConnection){
+    auto iValue = pConnection->read<int>();
+    pConnection->write(iValue * 3);
+    ++iServed;
+  }, 0);
+  for (int i = 0; i < iClients; ++i){
+    xtd::socket::ipv4_tcp_stream oClient;
+    oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+    oClient.write(i);
+    EXPECT_EQ(i * 3, oClient.read<int>());
+  }
+  oGroup.stop();
+  EXPECT_EQ(iClients, iServed.load());
+
+  //a connection made while stopped waits in the backlog until the loops restart
+  xtd::socket::ipv4_tcp_stream oClient;
+  oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oClient.write(7);
+  //connections are non-blocking by default
+  std::atomic<bool> bNonBlocking(false);
+  oGroup.start<xtd::socket::ipv4_tcp_stream>([&iServed, &bNonBlocking](size_t, std::unique_ptr<xtd::socket::ipv4_tcp_stream> pConnection){
+    bNonBlocking = 0 != (::fcntl(*pConnection, F_GETFL) & O_NONBLOCK);
+    pConnection->set_blocking(true);
+    pConnection->write(pConnection->read<int>() * 3);
+    ++iServed;
+  });
+  EXPECT_EQ(21, oClient.read<int>());
+  oGroup.stop();
+  EXPECT_EQ(iClients + 1, iServed.load());
+  EXPECT_TRUE(bNonBlocking.load());
+}
+#endif
+
+TEST(test_socket, tuning_options){
+  xtd::socket::ipv4_tcp_stream oSocket;
+  ASSERT_NO_THROW(oSocket.send_buffer_size(256 * 1024));
+  EXPECT_GE(oSocket.send_buffer_size(), 256 * 1024);
+  ASSERT_NO_THROW(oSocket.receive_buffer_size(256 * 1024));
+  EXPECT_GE(oSocket.receive_buffer_size(), 256 * 1024);
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__)
+  ASSERT_NO_THROW(oSocket.quick_ack(true));
+  ASSERT_NO_THROW(oSocket.not_sent_lowat(16384));
+  EXPECT_EQ(16384, oSocket.not_sent_lowat());
+  ASSERT_NO_THROW(oSocket.defer_accept(1));
+  ASSERT_NO_THROW(oSocket.busy_poll());
+#endif
+}
+
+TEST(test_socket, socket_profile){
+  xtd::socket::ipv4_tcp_stream oSocket;
+  ASSERT_NO_THROW(xtd::socket::socket_profile::low_latency().apply(oSocket));
+  EXPECT_TRUE(oSocket.no_delay());
+  auto iDefault = oSocket.send_buffer_size();
+  ASSERT_NO_THROW(xtd::socket::socket_profile::throughput().apply(oSocket));
+  //the kernel clamps buffer sizes to wmem_max so only growth can be checked
+  EXPECT_GE(oSocket.send_buffer_size(), iDefault);
+  xtd::socket::ipv4_udp_socket oDatagram;
+  ASSERT_NO_THROW(xtd::socket::socket_profile::low_latency().apply(oDatagram));
+}
+
+#if (XTD_OS_UNIX & XTD_OS) && defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+TEST(test_socket, zero_copy_send){
+  static constexpr uint16_t iPort = 8865;
+  xtd::socket::ipv4_tcp_stream oServer;
+  oServer.reuse_address(true);
+  oServer.bind(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oServer.listen();
+  std::vector<char> oSent(1024 * 1024, 'z');
+  auto oReceived = std::async(std::launch::async, [&oServer, &oSent](){
+    auto oConnection = oServer.accept<xtd::socket::ipv4_tcp_stream>();
+    std::vector<char> oRet(oSent.size());
+    oConnection.recv_all(oRet.data(), oRet.size());
+    return oRet;
+  });
+  xtd::socket::ipv4_tcp_stream oClient;
+  oClient.connect(xtd::socket::ipv4address("127.0.0.1", iPort));
+  oClient.zero_copy(true);
+  EXPECT_TRUE(oClient.zero_copy());
+  uint32_t iLast = 0;
+  auto bPinned = oClient.send_zero_copy(oSent.data(), oSent.size(), iLast);
+  ASSERT_EQ(oSent, oReceived.get());
+  if (!bPinned){
+    //every byte was copied so there is nothing to wait for
+    return;
+  }
+
+  uint32_t iCompleted = 0;
+  bool bCopied = false;
+  for (int i = 0; i < 100 && !(oClient.reap_zero_copy(iCompleted, bCopied) && iCompleted == iLast); ++i){
+    pollfd oPoll{ oClient, 0, 0 };
+    ::poll(&oPoll, 1, 10);
+  }
+  EXPECT_EQ(iLast, iCompleted);
+}
+#endif